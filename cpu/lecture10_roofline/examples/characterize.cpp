@@ -0,0 +1,334 @@
+// characterize.cpp - Measure the machine's roofline ceilings
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread characterize.cpp -o characterize
+// Run: ./characterize [profile.json]      (default machine_profile.json)
+//
+// Datasheet peaks assume max turbo on every core and ignore what the
+// memory system can actually sustain. This tool measures both ceilings
+// of the roofline model on the machine it runs on:
+//
+//   Compute: AVX2 FMA throughput with 12 independent accumulator chains
+//            (FMA latency 4 cycles x 2 ports = 8 chains needed to saturate),
+//            single and double precision, one core and all cores.
+//   Memory:  a working-set sweep from 8 KB to ~1 GB with two kernels,
+//            4-stream read and in-place update (read + write-back), as
+//            STREAM reports the best of several kernels. The plateaus of
+//            the better of the two give L1/L2/L3/DRAM bandwidth; DRAM is
+//            also measured with all cores.
+//
+// The result is written as flat JSON that machine_profile.h loads, so
+// every benchmark can report %peak and %bandwidth against it.
+
+#include <immintrin.h>
+#include <unistd.h>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static volatile double sink;  // keeps results alive
+
+// ============================================================================
+// Compute ceiling: independent FMA chains
+// ============================================================================
+
+// c = c * a + b converges to b / (1 - a): no overflow, no denormals
+static void fma_sp(long iters) {
+    __m256 a = _mm256_set1_ps(0.999999f), b = _mm256_set1_ps(1e-7f);
+    __m256 c0 = _mm256_set1_ps(0.0f), c1 = _mm256_set1_ps(0.1f), c2 = _mm256_set1_ps(0.2f);
+    __m256 c3 = _mm256_set1_ps(0.3f), c4 = _mm256_set1_ps(0.4f), c5 = _mm256_set1_ps(0.5f);
+    __m256 c6 = _mm256_set1_ps(0.6f), c7 = _mm256_set1_ps(0.7f), c8 = _mm256_set1_ps(0.8f);
+    __m256 c9 = _mm256_set1_ps(0.9f), c10 = _mm256_set1_ps(1.0f), c11 = _mm256_set1_ps(1.1f);
+    for (long i = 0; i < iters; i++) {
+        c0 = _mm256_fmadd_ps(c0, a, b);   c1 = _mm256_fmadd_ps(c1, a, b);
+        c2 = _mm256_fmadd_ps(c2, a, b);   c3 = _mm256_fmadd_ps(c3, a, b);
+        c4 = _mm256_fmadd_ps(c4, a, b);   c5 = _mm256_fmadd_ps(c5, a, b);
+        c6 = _mm256_fmadd_ps(c6, a, b);   c7 = _mm256_fmadd_ps(c7, a, b);
+        c8 = _mm256_fmadd_ps(c8, a, b);   c9 = _mm256_fmadd_ps(c9, a, b);
+        c10 = _mm256_fmadd_ps(c10, a, b); c11 = _mm256_fmadd_ps(c11, a, b);
+    }
+    __m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(c0, c1), _mm256_add_ps(c2, c3)),
+                             _mm256_add_ps(_mm256_add_ps(c4, c5), _mm256_add_ps(c6, c7)));
+    s = _mm256_add_ps(s, _mm256_add_ps(_mm256_add_ps(c8, c9), _mm256_add_ps(c10, c11)));
+    sink = _mm256_cvtss_f32(s);
+}
+
+static void fma_dp(long iters) {
+    __m256d a = _mm256_set1_pd(0.999999), b = _mm256_set1_pd(1e-7);
+    __m256d c0 = _mm256_set1_pd(0.0), c1 = _mm256_set1_pd(0.1), c2 = _mm256_set1_pd(0.2);
+    __m256d c3 = _mm256_set1_pd(0.3), c4 = _mm256_set1_pd(0.4), c5 = _mm256_set1_pd(0.5);
+    __m256d c6 = _mm256_set1_pd(0.6), c7 = _mm256_set1_pd(0.7), c8 = _mm256_set1_pd(0.8);
+    __m256d c9 = _mm256_set1_pd(0.9), c10 = _mm256_set1_pd(1.0), c11 = _mm256_set1_pd(1.1);
+    for (long i = 0; i < iters; i++) {
+        c0 = _mm256_fmadd_pd(c0, a, b);   c1 = _mm256_fmadd_pd(c1, a, b);
+        c2 = _mm256_fmadd_pd(c2, a, b);   c3 = _mm256_fmadd_pd(c3, a, b);
+        c4 = _mm256_fmadd_pd(c4, a, b);   c5 = _mm256_fmadd_pd(c5, a, b);
+        c6 = _mm256_fmadd_pd(c6, a, b);   c7 = _mm256_fmadd_pd(c7, a, b);
+        c8 = _mm256_fmadd_pd(c8, a, b);   c9 = _mm256_fmadd_pd(c9, a, b);
+        c10 = _mm256_fmadd_pd(c10, a, b); c11 = _mm256_fmadd_pd(c11, a, b);
+    }
+    __m256d s = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(c0, c1), _mm256_add_pd(c2, c3)),
+                              _mm256_add_pd(_mm256_add_pd(c4, c5), _mm256_add_pd(c6, c7)));
+    s = _mm256_add_pd(s, _mm256_add_pd(_mm256_add_pd(c8, c9), _mm256_add_pd(c10, c11)));
+    sink = _mm256_cvtsd_f64(s);
+}
+
+// GFLOPS of `kernel` on `threads` threads (best of 3, ~0.2 s each)
+static double peak_gflops(void (*kernel)(long), double flops_per_iter, int threads) {
+    long iters = 1 << 20;
+    double t0 = now();
+    kernel(iters);
+    double t = now() - t0;
+    iters = (long)(iters * 0.2 / (t > 1e-6 ? t : 1e-6));
+
+    double best = 0;
+    for (int rep = 0; rep < 3; rep++) {
+        vector<thread> pool;
+        t0 = now();
+        for (int i = 0; i < threads; i++) pool.emplace_back(kernel, iters);
+        for (auto& th : pool) th.join();
+        t = now() - t0;
+        double gflops = flops_per_iter * iters * threads / t / 1e9;
+        if (gflops > best) best = gflops;
+    }
+    return best;
+}
+
+// ============================================================================
+// Memory ceilings: bandwidth over a working-set sweep
+// ============================================================================
+
+// Read: 4 concurrent streams (one per quarter of x) so the hardware
+// prefetchers keep enough misses in flight; 8 independent add chains so
+// the loads, not the adds, are the limit. n must be a multiple of 32.
+static double read_kernel(const double* x, size_t n) {
+    const double *x0 = x, *x1 = x + n / 4, *x2 = x + n / 2, *x3 = x + 3 * (n / 4);
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    __m256d s4 = _mm256_setzero_pd(), s5 = _mm256_setzero_pd();
+    __m256d s6 = _mm256_setzero_pd(), s7 = _mm256_setzero_pd();
+    for (size_t i = 0; i < n / 4; i += 8) {
+        s0 = _mm256_add_pd(s0, _mm256_load_pd(x0 + i)); s1 = _mm256_add_pd(s1, _mm256_load_pd(x0 + i + 4));
+        s2 = _mm256_add_pd(s2, _mm256_load_pd(x1 + i)); s3 = _mm256_add_pd(s3, _mm256_load_pd(x1 + i + 4));
+        s4 = _mm256_add_pd(s4, _mm256_load_pd(x2 + i)); s5 = _mm256_add_pd(s5, _mm256_load_pd(x2 + i + 4));
+        s6 = _mm256_add_pd(s6, _mm256_load_pd(x3 + i)); s7 = _mm256_add_pd(s7, _mm256_load_pd(x3 + i + 4));
+    }
+    __m256d s = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)),
+                              _mm256_add_pd(_mm256_add_pd(s4, s5), _mm256_add_pd(s6, s7)));
+    return _mm256_cvtsd_f64(s);
+}
+
+// Update in place, x = x * a + b: every line read and written back (2x the
+// bytes). Many memory systems sustain more with mixed read/write traffic.
+static double update_kernel(double* x, size_t n) {
+    __m256d a = _mm256_set1_pd(0.999999), b = _mm256_set1_pd(1e-7);
+    for (size_t i = 0; i < n; i += 16) {
+        _mm256_store_pd(x + i + 0, _mm256_fmadd_pd(_mm256_load_pd(x + i + 0), a, b));
+        _mm256_store_pd(x + i + 4, _mm256_fmadd_pd(_mm256_load_pd(x + i + 4), a, b));
+        _mm256_store_pd(x + i + 8, _mm256_fmadd_pd(_mm256_load_pd(x + i + 8), a, b));
+        _mm256_store_pd(x + i + 12, _mm256_fmadd_pd(_mm256_load_pd(x + i + 12), a, b));
+    }
+    return x[0];
+}
+
+enum bw_kernel { BW_READ, BW_UPDATE };
+
+static void run_passes(double* x, size_t n, long passes, int init, bw_kernel kind) {
+    if (init)
+        for (size_t i = 0; i < n; i++) x[i] = 1.0;  // first touch by the owning thread
+    double s = 0;
+    for (long p = 0; p < passes; p++)
+        s += (kind == BW_READ) ? read_kernel(x, n) : update_kernel(x, n);
+    sink = s;
+}
+
+// Both kernels step whole blocks: bytes must be a multiple of this
+const size_t BW_BLOCK = 32 * sizeof(double);
+
+// GB/s of memory traffic with a working set of `bytes` per thread (best of 3)
+static double bandwidth(size_t bytes, int threads, bw_kernel kind) {
+    assert(bytes > 0 && bytes % BW_BLOCK == 0);
+    size_t n = bytes / sizeof(double);
+    long passes = (long)(((size_t)1 << 31) / bytes);  // ~2 GB of traffic per timing
+    if (passes < 2) passes = 2;
+    double traffic = (kind == BW_READ ? 1.0 : 2.0) * bytes;
+
+    vector<double*> bufs(threads);
+    for (int i = 0; i < threads; i++) {
+        bufs[i] = (double*)aligned_alloc(64, bytes);
+        if (!bufs[i]) abort();
+    }
+    {   // initialize + warm up in the owning threads
+        vector<thread> pool;
+        for (int i = 0; i < threads; i++) pool.emplace_back(run_passes, bufs[i], n, 1L, 1, kind);
+        for (auto& th : pool) th.join();
+    }
+
+    double best = 0;
+    for (int rep = 0; rep < 3; rep++) {
+        vector<thread> pool;
+        double t0 = now();
+        for (int i = 0; i < threads; i++) pool.emplace_back(run_passes, bufs[i], n, passes, 0, kind);
+        for (auto& th : pool) th.join();
+        double t = now() - t0;
+        double gbs = traffic * passes * threads / t / 1e9;
+        if (gbs > best) best = gbs;
+    }
+    for (int i = 0; i < threads; i++) free(bufs[i]);
+    return best;
+}
+
+// ============================================================================
+// Machine info
+// ============================================================================
+static string cpu_model() {
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (!f) return "unknown";
+    char line[512];
+    string model = "unknown";
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10) == 0) {
+            char* p = strchr(line, ':');
+            if (p) {
+                model = p + 2;
+                while (!model.empty() && (model.back() == '\n' || model.back() == ' ')) model.pop_back();
+            }
+            break;
+        }
+    }
+    fclose(f);
+    for (auto& c : model)
+        if (c == '"' || c == '\\') c = ' ';
+    return model;
+}
+
+static size_t cache_size(int name, size_t fallback) {
+    long v = sysconf(name);
+    return v > 0 ? (size_t)v : fallback;
+}
+
+// Best bandwidth among sweep points in (lo, hi]; nearest point <= hi if none
+static double plateau(const vector<size_t>& sizes, const vector<double>& bw, size_t lo, size_t hi) {
+    double best = 0, nearest = bw[0];
+    for (size_t i = 0; i < sizes.size(); i++) {
+        if (sizes[i] <= hi) nearest = bw[i];
+        if (sizes[i] > lo && sizes[i] <= hi && bw[i] > best) best = bw[i];
+    }
+    return best > 0 ? best : nearest;
+}
+
+int main(int argc, char** argv) {
+    const char* out_path = (argc > 1) ? argv[1] : "machine_profile.json";
+    int cores = (int)thread::hardware_concurrency();
+    if (cores < 1) cores = 1;
+    string model = cpu_model();
+
+    size_t l1 = cache_size(_SC_LEVEL1_DCACHE_SIZE, 32 << 10);
+    size_t l2 = cache_size(_SC_LEVEL2_CACHE_SIZE, 1 << 20);
+    size_t l3 = cache_size(_SC_LEVEL3_CACHE_SIZE, 8 << 20);
+
+    // Sweep to 4x L3 when memory allows (at most 1/4 of RAM and 1 GB)
+    size_t ram = (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE);
+    size_t max_bytes = 4 * l3;
+    if (max_bytes < ((size_t)256 << 20)) max_bytes = (size_t)256 << 20;
+    if (max_bytes > ram / 4) max_bytes = ram / 4;
+    if (max_bytes > ((size_t)1 << 30)) max_bytes = (size_t)1 << 30;
+
+    printf("\n");
+    printf("╔══════════════════════════════════════════════════════════════╗\n");
+    printf("║              Machine Characterization (AVX2+FMA)             ║\n");
+    printf("╚══════════════════════════════════════════════════════════════╝\n");
+    printf("CPU: %s (%d hardware threads)\n", model.c_str(), cores);
+    printf("Caches: L1d %zu KB, L2 %zu KB, L3 %zu KB\n\n", l1 >> 10, l2 >> 10, l3 >> 10);
+
+    printf("Peak FMA throughput (12 independent chains):\n");
+    double sp1 = peak_gflops(fma_sp, 12 * 8 * 2, 1);
+    double dp1 = peak_gflops(fma_dp, 12 * 4 * 2, 1);
+    double spn = cores > 1 ? peak_gflops(fma_sp, 12 * 8 * 2, cores) : sp1;
+    double dpn = cores > 1 ? peak_gflops(fma_dp, 12 * 4 * 2, cores) : dp1;
+    printf("  fp32: %8.1f GFLOPS/core  %8.1f GFLOPS all cores\n", sp1, spn);
+    printf("  fp64: %8.1f GFLOPS/core  %8.1f GFLOPS all cores\n\n", dp1, dpn);
+
+    printf("Bandwidth sweep (1 core; update counts read + write-back):\n");
+    printf("  ┌──────────────┬──────────┬──────────┐\n");
+    printf("  │ Working set  │   Read   │  Update  │  (GB/s)\n");
+    printf("  ├──────────────┼──────────┼──────────┤\n");
+    vector<size_t> sizes;
+    vector<double> bw;  // sustainable: best of read and update
+    vector<double> bw_read, bw_update;
+    for (size_t bytes = 8 << 10; bytes <= max_bytes; bytes *= 2) {
+        double r = bandwidth(bytes, 1, BW_READ);
+        double u = bandwidth(bytes, 1, BW_UPDATE);
+        sizes.push_back(bytes);
+        bw_read.push_back(r);
+        bw_update.push_back(u);
+        bw.push_back(r > u ? r : u);
+        if (bytes < ((size_t)1 << 20))
+            printf("  │ %8zu KB  │ %8.1f │ %8.1f │\n", bytes >> 10, r, u);
+        else
+            printf("  │ %8zu MB  │ %8.1f │ %8.1f │\n", bytes >> 20, r, u);
+    }
+    printf("  └──────────────┴──────────┴──────────┘\n");
+
+    double bw_l1 = plateau(sizes, bw, 0, l1 / 2);
+    double bw_l2 = plateau(sizes, bw, l1, l2 / 2);
+    double bw_l3 = plateau(sizes, bw, l2, l3 / 2);
+    double bw_dram = bw.back();
+    // All cores: each thread streams its own share of the largest working set
+    double bw_dram_all = bw_dram;
+    if (cores > 1) {
+        size_t per_thread = max_bytes / cores / BW_BLOCK * BW_BLOCK;
+        double r = bandwidth(per_thread, cores, BW_READ);
+        double u = bandwidth(per_thread, cores, BW_UPDATE);
+        bw_dram_all = r > u ? r : u;
+    }
+    int dram_in_llc = sizes.back() < 4 * l3;
+
+    printf("\nBandwidth ceilings:\n");
+    printf("  L1  %8.1f GB/s\n", bw_l1);
+    printf("  L2  %8.1f GB/s\n", bw_l2);
+    printf("  L3  %8.1f GB/s\n", bw_l3);
+    printf("  DRAM %7.1f GB/s (1 core), %.1f GB/s (all cores)%s\n", bw_dram, bw_dram_all,
+           dram_in_llc ? "  [largest set < 4x L3]" : "");
+    printf("  Ridge point (fp64, 1 core): %.1f flops/byte\n", dp1 / bw_dram);
+
+    FILE* f = fopen(out_path, "w");
+    if (!f) {
+        perror(out_path);
+        return 1;
+    }
+    fprintf(f, "{\n");
+    fprintf(f, "  \"cpu_model\": \"%s\",\n", model.c_str());
+    fprintf(f, "  \"cores\": %d,\n", cores);
+    fprintf(f, "  \"simd\": \"avx2+fma\",\n");
+    fprintf(f, "  \"peak_sp_gflops_1core\": %.2f,\n", sp1);
+    fprintf(f, "  \"peak_sp_gflops_all\": %.2f,\n", spn);
+    fprintf(f, "  \"peak_dp_gflops_1core\": %.2f,\n", dp1);
+    fprintf(f, "  \"peak_dp_gflops_all\": %.2f,\n", dpn);
+    fprintf(f, "  \"cache_l1_kb\": %zu,\n", l1 >> 10);
+    fprintf(f, "  \"cache_l2_kb\": %zu,\n", l2 >> 10);
+    fprintf(f, "  \"cache_l3_kb\": %zu,\n", l3 >> 10);
+    fprintf(f, "  \"bw_l1_gbs\": %.2f,\n", bw_l1);
+    fprintf(f, "  \"bw_l2_gbs\": %.2f,\n", bw_l2);
+    fprintf(f, "  \"bw_l3_gbs\": %.2f,\n", bw_l3);
+    fprintf(f, "  \"bw_dram_gbs_1core\": %.2f,\n", bw_dram);
+    fprintf(f, "  \"bw_dram_gbs_all\": %.2f,\n", bw_dram_all);
+    fprintf(f, "  \"dram_set_exceeds_4x_l3\": %s,\n", dram_in_llc ? "false" : "true");
+    fprintf(f, "  \"sweep\": [\n");
+    for (size_t i = 0; i < sizes.size(); i++)
+        fprintf(f, "    {\"bytes\": %zu, \"gbs\": %.2f, \"read_gbs\": %.2f, \"update_gbs\": %.2f}%s\n",
+                sizes[i], bw[i], bw_read[i], bw_update[i],
+                i + 1 < sizes.size() ? "," : "");
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    printf("\nWrote %s\n", out_path);
+    return 0;
+}
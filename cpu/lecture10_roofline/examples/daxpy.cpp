@@ -11,6 +11,7 @@
 #include <iostream>
 #include <chrono>
 #include <cstdlib>
+#include "machine_profile.h"
 using namespace std;
 
 void daxpy(double* y, double alpha, double* x, int n) {
@@ -45,6 +46,7 @@ int main() {
     cout << "  Performance: " << flops / seconds / 1e9 << " GFLOPS" << endl;
     cout << "  Bandwidth: " << bytes / seconds / 1e9 << " GB/s" << endl;
     cout << "  Operational Intensity: " << flops / bytes << " flops/byte" << endl;
+    machine_profile_report(flops, bytes, seconds, 1);
     cout << "  y[0] = " << y[0] << " (expected: 3.0)" << endl;
 
     free(x);
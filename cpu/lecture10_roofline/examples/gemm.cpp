@@ -15,6 +15,7 @@
 #include <iostream>
 #include <chrono>
 #include <cstring>
+#include "machine_profile.h"
 using namespace std;
 
 const int N = 1024;
@@ -82,6 +83,10 @@ int main() {
     cout << "  Theoretical I: " << BLOCK << " flops/byte (compute bound)" << endl;
     cout << endl;
     cout << "Speedup: " << naive_sec / blocked_sec << "x" << endl;
+    machine_profile mp;
+    if (machine_profile_load(&mp))
+        cout << "Measured fp64 peak: " << mp.peak_dp_1core << " GFLOPS/core (blocked: "
+             << 100 * blocked_gflops / mp.peak_dp_1core << "% of peak)" << endl;
     cout << "C[0] = " << C[0] << " (expected: " << N << ")" << endl;
 
     return 0;
@@ -0,0 +1,399 @@
+// gemv_quant.cpp - Compressed-weight GEMV (fp16 / int8 / int4) for bandwidth-bound decode
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -mf16c -pthread gemv_quant.cpp -o gemv_quant
+// Run: ./gemv_quant [n ...]      (n x n weights, default 4096 8192 16384)
+//
+// GEMV is memory bound (gemv.cpp: I = 1/4 flops/byte in fp64), so time is
+// bytes of weights / bandwidth and the only lever left is fewer bytes per
+// weight. Each format below is dequantized in registers and accumulated
+// in fp32 against an fp32 activation vector x:
+//
+//   fp64   8 bytes/weight    (gemv.cpp's precision)
+//   fp32   4
+//   fp16   2                 vcvtph2ps (F16C), no scale
+//   int8   1 + 2/G           symmetric, one fp16 scale per group of G
+//   int4   0.5 + 2/G         symmetric [-8, 7] stored as q + 8 in nibbles;
+//                            byte b of a group holds weights b (low) and
+//                            b + G/2 (high), so two ANDs unpack 32 weights
+//
+// Per group: acc += scale * sum(w_q * x). For int4 the +8 offset folds
+// out: sum((u - 8) x) = sum(u x) - 8 sum(x), with the group sums of x
+// computed once per call. Rows go 4 at a time so each x vector load feeds
+// 4 rows, split across the pinned pool. Error is relative to the fp64
+// product of the original weights.
+
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "machine_profile.h"
+#include "thread_pool.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <class T>
+static T* alloc_array(size_t n) {
+    T* p = (T*)aligned_alloc(64, ((n * sizeof(T) + 63) / 64) * 64);
+    if (!p) abort();
+    return p;
+}
+
+static inline float hsum(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_movehdup_ps(s)));
+}
+
+static inline double hsum(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+const int G = 32;  // quantization group (weights per scale)
+
+// All formats: n x n row-major weights
+struct weights {
+    int n;
+    double* f64;
+    float* f32;
+    uint16_t* f16;
+    int8_t* q8;       // n*n
+    uint8_t* q4;      // n*n/2, nibble pairs
+    uint16_t* scale;  // fp16, n * n/G (shared layout for int8 and int4)
+};
+
+// ============================================================================
+// Kernels: rows [r0, r1) of y = W x, 4 rows at a time (n % 4 == 0)
+// ============================================================================
+
+static void gemv_f64(const weights& w, const float* x, float* y, int r0, int r1) {
+    int n = w.n;
+    for (int i = r0; i < r1; i += 4) {
+        __m256d acc[4][2];
+        for (int r = 0; r < 4; r++) acc[r][0] = acc[r][1] = _mm256_setzero_pd();
+        for (int j = 0; j < n; j += 8) {
+            __m256d x0 = _mm256_cvtps_pd(_mm_loadu_ps(x + j));
+            __m256d x1 = _mm256_cvtps_pd(_mm_loadu_ps(x + j + 4));
+            for (int r = 0; r < 4; r++) {
+                const double* a = w.f64 + (size_t)(i + r) * n + j;
+                acc[r][0] = _mm256_fmadd_pd(_mm256_load_pd(a), x0, acc[r][0]);
+                acc[r][1] = _mm256_fmadd_pd(_mm256_load_pd(a + 4), x1, acc[r][1]);
+            }
+        }
+        for (int r = 0; r < 4; r++) y[i + r] = (float)hsum(_mm256_add_pd(acc[r][0], acc[r][1]));
+    }
+}
+
+static void gemv_f32(const weights& w, const float* x, float* y, int r0, int r1) {
+    int n = w.n;
+    for (int i = r0; i < r1; i += 4) {
+        __m256 acc[4][2];
+        for (int r = 0; r < 4; r++) acc[r][0] = acc[r][1] = _mm256_setzero_ps();
+        for (int j = 0; j < n; j += 16) {
+            __m256 x0 = _mm256_loadu_ps(x + j), x1 = _mm256_loadu_ps(x + j + 8);
+            for (int r = 0; r < 4; r++) {
+                const float* a = w.f32 + (size_t)(i + r) * n + j;
+                acc[r][0] = _mm256_fmadd_ps(_mm256_load_ps(a), x0, acc[r][0]);
+                acc[r][1] = _mm256_fmadd_ps(_mm256_load_ps(a + 8), x1, acc[r][1]);
+            }
+        }
+        for (int r = 0; r < 4; r++) y[i + r] = hsum(_mm256_add_ps(acc[r][0], acc[r][1]));
+    }
+}
+
+static void gemv_f16(const weights& w, const float* x, float* y, int r0, int r1) {
+    int n = w.n;
+    for (int i = r0; i < r1; i += 4) {
+        __m256 acc[4][2];
+        for (int r = 0; r < 4; r++) acc[r][0] = acc[r][1] = _mm256_setzero_ps();
+        for (int j = 0; j < n; j += 16) {
+            __m256 x0 = _mm256_loadu_ps(x + j), x1 = _mm256_loadu_ps(x + j + 8);
+            for (int r = 0; r < 4; r++) {
+                const uint16_t* a = w.f16 + (size_t)(i + r) * n + j;
+                acc[r][0] = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_load_si128((const __m128i*)a)),
+                                            x0, acc[r][0]);
+                acc[r][1] = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_load_si128((const __m128i*)(a + 8))),
+                                            x1, acc[r][1]);
+            }
+        }
+        for (int r = 0; r < 4; r++) y[i + r] = hsum(_mm256_add_ps(acc[r][0], acc[r][1]));
+    }
+}
+
+static inline __m256 i8x8_to_ps(const int8_t* p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)p)));
+}
+
+static void gemv_q8(const weights& w, const float* x, float* y, int r0, int r1) {
+    int n = w.n, groups = n / G;
+    for (int i = r0; i < r1; i += 4) {
+        __m256 acc[4];
+        for (int r = 0; r < 4; r++) acc[r] = _mm256_setzero_ps();
+        for (int g = 0; g < groups; g++) {
+            const float* xg = x + g * G;
+            __m256 x0 = _mm256_loadu_ps(xg), x1 = _mm256_loadu_ps(xg + 8);
+            __m256 x2 = _mm256_loadu_ps(xg + 16), x3 = _mm256_loadu_ps(xg + 24);
+            for (int r = 0; r < 4; r++) {
+                const int8_t* q = w.q8 + (size_t)(i + r) * n + g * G;
+                __m256 s = _mm256_mul_ps(i8x8_to_ps(q), x0);
+                s = _mm256_fmadd_ps(i8x8_to_ps(q + 8), x1, s);
+                s = _mm256_fmadd_ps(i8x8_to_ps(q + 16), x2, s);
+                s = _mm256_fmadd_ps(i8x8_to_ps(q + 24), x3, s);
+                float scale = _cvtsh_ss(w.scale[(size_t)(i + r) * groups + g]);
+                acc[r] = _mm256_fmadd_ps(_mm256_set1_ps(scale), s, acc[r]);
+            }
+        }
+        for (int r = 0; r < 4; r++) y[i + r] = hsum(acc[r]);
+    }
+}
+
+// xsum[g] = sum of x over group g (int4 offset correction)
+static void gemv_q4(const weights& w, const float* x, const float* xsum, float* y, int r0, int r1) {
+    int n = w.n, groups = n / G;
+    const __m128i low4 = _mm_set1_epi8(0x0F);
+    for (int i = r0; i < r1; i += 4) {
+        __m256 acc[4];
+        float corr[4] = {0, 0, 0, 0};
+        for (int r = 0; r < 4; r++) acc[r] = _mm256_setzero_ps();
+        for (int g = 0; g < groups; g++) {
+            const float* xg = x + g * G;
+            __m256 x0 = _mm256_loadu_ps(xg), x1 = _mm256_loadu_ps(xg + 8);
+            __m256 x2 = _mm256_loadu_ps(xg + 16), x3 = _mm256_loadu_ps(xg + 24);
+            for (int r = 0; r < 4; r++) {
+                __m128i b = _mm_load_si128((const __m128i*)(w.q4 + ((size_t)(i + r) * n + g * G) / 2));
+                __m128i lo = _mm_and_si128(b, low4);                     // weights 0..15
+                __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), low4);  // weights 16..31
+                __m256 s = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(lo)), x0);
+                s = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8))),
+                                    x1, s);
+                s = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(hi)), x2, s);
+                s = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8))),
+                                    x3, s);
+                float scale = _cvtsh_ss(w.scale[(size_t)(i + r) * groups + g]);
+                acc[r] = _mm256_fmadd_ps(_mm256_set1_ps(scale), s, acc[r]);
+                corr[r] += scale * xsum[g];
+            }
+        }
+        for (int r = 0; r < 4; r++) y[i + r] = hsum(acc[r]) - 8.0f * corr[r];
+    }
+}
+
+// ============================================================================
+// Quantization
+// ============================================================================
+
+static void quantize(weights& w, thread_pool& pool) {
+    int n = w.n, groups = n / G;
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk((size_t)n, pool.n, id, &lo, &hi, 4);
+        for (size_t i = lo; i < hi; i++) {
+            const float* row = w.f32 + i * n;
+            for (int j = 0; j < n; j++) w.f16[i * n + j] = _cvtss_sh(row[j], 0);
+            for (int g = 0; g < groups; g++) {
+                const float* v = row + g * G;
+                float amax = 0;
+                for (int k = 0; k < G; k++) amax = max(amax, fabsf(v[k]));
+                // One fp16 scale per group, amax/127 (int4 has its own,
+                // amax/7, from quantize_q4)
+                uint16_t s8 = _cvtss_sh(amax > 0 ? amax / 127.0f : 1.0f, 0);
+                w.scale[i * groups + g] = s8;
+                float inv8 = 1.0f / _cvtsh_ss(s8);
+                for (int k = 0; k < G; k++)
+                    w.q8[i * n + g * G + k] = (int8_t)lrintf(max(-127.0f, min(127.0f, v[k] * inv8)));
+            }
+        }
+    });
+}
+
+// int4 gets its own scale array (amax/7 per group), same layout
+static void quantize_q4(weights& w, uint16_t* scale4, thread_pool& pool) {
+    int n = w.n, groups = n / G;
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk((size_t)n, pool.n, id, &lo, &hi, 4);
+        for (size_t i = lo; i < hi; i++)
+            for (int g = 0; g < groups; g++) {
+                const float* v = w.f32 + i * n + g * G;
+                float amax = 0;
+                for (int k = 0; k < G; k++) amax = max(amax, fabsf(v[k]));
+                uint16_t s4 = _cvtss_sh(amax > 0 ? amax / 7.0f : 1.0f, 0);
+                scale4[i * groups + g] = s4;
+                float inv = 1.0f / _cvtsh_ss(s4);
+                uint8_t* dst = w.q4 + (i * n + g * G) / 2;
+                for (int b = 0; b < G / 2; b++) {
+                    int lo4 = (int)lrintf(max(-8.0f, min(7.0f, v[b] * inv))) + 8;
+                    int hi4 = (int)lrintf(max(-8.0f, min(7.0f, v[b + G / 2] * inv))) + 8;
+                    dst[b] = (uint8_t)(lo4 | (hi4 << 4));
+                }
+            }
+    });
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+// Best seconds per call over >= 0.3 s
+template <class F>
+static double time_call(F&& f) {
+    double best = 1e30, total = 0;
+    for (int r = 0; r < 200 && (r < 3 || total < 0.3); r++) {
+        double t0 = now();
+        f();
+        double t = now() - t0;
+        total += t;
+        best = min(best, t);
+    }
+    return best;
+}
+
+static void run_size(int n, thread_pool& pool) {
+    int groups = n / G;
+    size_t nn = (size_t)n * n;
+    weights w;
+    w.n = n;
+    w.f64 = alloc_array<double>(nn);
+    w.f32 = alloc_array<float>(nn);
+    w.f16 = alloc_array<uint16_t>(nn);
+    w.q8 = alloc_array<int8_t>(nn);
+    w.q4 = alloc_array<uint8_t>(nn / 2);
+    w.scale = alloc_array<uint16_t>((size_t)n * groups);
+    uint16_t* scale4 = alloc_array<uint16_t>((size_t)n * groups);
+    float* x = alloc_array<float>(n);
+    float* xsum = alloc_array<float>(groups);
+    float* y = alloc_array<float>(n);
+    double* y_ref = alloc_array<double>(n);
+
+    // Weights ~ N(0, 1/n) with a per-row spread, first-touched by row owner
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk((size_t)n, pool.n, id, &lo, &hi, 4);
+        uint64_t s = 0x9E3779B97F4A7C15ull * (lo + 1);
+        for (size_t i = lo; i < hi; i++) {
+            float row_scale = (0.5f + (float)(i % 7) / 7.0f) / sqrtf((float)n);
+            for (int j = 0; j < n; j++) {
+                float u = 0;
+                for (int k = 0; k < 4; k++) {
+                    s = s * 6364136223846793005ull + 1442695040888963407ull;
+                    u += (float)(s >> 40) / (float)(1 << 24) - 0.5f;
+                }
+                w.f32[i * n + j] = u * row_scale * 1.732f;
+                w.f64[i * n + j] = w.f32[i * n + j];
+            }
+        }
+    });
+    for (int j = 0; j < n; j++) x[j] = sinf(0.37f * j) + 0.1f;
+    for (int g = 0; g < groups; g++) {
+        xsum[g] = 0;
+        for (int k = 0; k < G; k++) xsum[g] += x[g * G + k];
+    }
+    quantize(w, pool);
+    quantize_q4(w, scale4, pool);
+
+    for (int i = 0; i < n; i++) {
+        double s = 0;
+        for (int j = 0; j < n; j++) s += w.f64[(size_t)i * n + j] * x[j];
+        y_ref[i] = s;
+    }
+
+    weights w4 = w;
+    w4.scale = scale4;
+    double scale_bytes = 2.0 * n * groups;
+    struct { const char* name; double bytes; int which; } formats[] = {
+        {"fp64", 8.0 * nn, 0},
+        {"fp32", 4.0 * nn, 1},
+        {"fp16", 2.0 * nn, 2},
+        {"int8 + fp16 scale/32", 1.0 * nn + scale_bytes, 3},
+        {"int4 + fp16 scale/32", 0.5 * nn + scale_bytes, 4},
+    };
+
+    printf("\n%d x %d (%d thread%s):\n", n, n, pool.n, pool.n > 1 ? "s" : "");
+    printf("  ┌──────────────────────┬──────────┬──────────┬──────────┬───────────┬─────────┬─────────┬─────────┐\n");
+    printf("  │ Format               │  MB read │  time ms │     GB/s │ fp32-eq   │ vs fp32 │ vs fp64 │ rel err │\n");
+    printf("  ├──────────────────────┼──────────┼──────────┼──────────┼───────────┼─────────┼─────────┼─────────┤\n");
+    // Time everything first: the speedup columns need fp32 and fp64
+    const int nf = sizeof(formats) / sizeof(formats[0]);
+    double seconds[nf], err[nf];
+    for (int k = 0; k < nf; k++) {
+        int which = formats[k].which;
+        seconds[k] = time_call([&] {
+            pool.run([&](int id) {
+                size_t lo, hi;
+                chunk((size_t)n, pool.n, id, &lo, &hi, 4);
+                switch (which) {
+                    case 0: gemv_f64(w, x, y, (int)lo, (int)hi); break;
+                    case 1: gemv_f32(w, x, y, (int)lo, (int)hi); break;
+                    case 2: gemv_f16(w, x, y, (int)lo, (int)hi); break;
+                    case 3: gemv_q8(w, x, y, (int)lo, (int)hi); break;
+                    default: gemv_q4(w4, x, xsum, y, (int)lo, (int)hi); break;
+                }
+            });
+        });
+        double num = 0, den = 0;
+        for (int i = 0; i < n; i++) {
+            num += (y[i] - y_ref[i]) * (y[i] - y_ref[i]);
+            den += y_ref[i] * y_ref[i];
+        }
+        err[k] = sqrt(num / den);
+    }
+    for (int k = 0; k < nf; k++) {
+        double t = seconds[k], bytes = formats[k].bytes + 8.0 * n;  // + x and y
+        printf("  │ %-20s │ %8.1f │ %8.2f │ %8.1f │ %8.1f  │ %6.2fx │ %6.2fx │ %7.1e │\n",
+               formats[k].name, bytes / 1e6, t * 1e3, bytes / t / 1e9, 4.0 * nn / t / 1e9,
+               seconds[1] / t, seconds[0] / t, err[k]);
+    }
+    printf("  └──────────────────────┴──────────┴──────────┴──────────┴───────────┴─────────┴─────────┴─────────┘\n");
+
+    free(w.f64);
+    free(w.f32);
+    free(w.f16);
+    free(w.q8);
+    free(w.q4);
+    free(w.scale);
+    free(scale4);
+    free(x);
+    free(xsum);
+    free(y);
+    free(y_ref);
+}
+
+int main(int argc, char** argv) {
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(atoi(argv[i]) / 64 * 64);
+    if (sizes.empty()) sizes = {4096, 8192, 16384};
+
+    vector<int> cpus = cpu_order("compact");
+    thread_pool pool((int)cpus.size(), cpus);
+    size_t ram = (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE);
+
+    printf("\n");
+    printf("╔═════════════════════════════════════════════════════════════════╗\n");
+    printf("║  Compressed-weight GEMV: y = W x, fp32 accumulate, AVX2 + F16C  ║\n");
+    printf("╚═════════════════════════════════════════════════════════════════╝\n");
+    printf("GB/s: bytes actually read (weights + scales + x, y). fp32-eq: the fp32\n");
+    printf("matrix size over the same time, i.e. the bandwidth fp32 would need.\n");
+    for (int n : sizes) {
+        // All formats live at once: 8 + 4 + 2 + 1 + 0.5 bytes per weight
+        if (n < 64 || 15.5 * n * n > 0.8 * ram) {
+            printf("\n%d x %d: skipped (needs %.1f GB, have %.1f GB RAM)\n", n, n,
+                   15.5 * n * n / 1e9, ram / 1e9);
+            continue;
+        }
+        run_size(n, pool);
+    }
+    printf("\nfp16 and int8 cut time roughly with bytes until the dequantize work\n");
+    printf("(widen + convert + FMA per 8 weights) becomes the limit; int4 adds an\n");
+    printf("unpack on top, so it only wins where bandwidth per core is lower.\n");
+    machine_profile mp;
+    if (machine_profile_load(&mp))
+        printf("\ncharacterize DRAM ceiling: %.1f GB/s (1 core), %.1f GB/s (all cores)\n",
+               mp.bw_dram_1core, mp.bw_dram_all);
+    return 0;
+}
@@ -0,0 +1,166 @@
+// machine_profile.h - Measured machine ceilings for roofline reports
+//
+// `characterize` (characterize.cpp) measures peak FMA throughput and
+// sustainable bandwidth at each cache level and writes them to
+// machine_profile.json. Benchmarks load that file with
+// machine_profile_load() to report %peak and %bandwidth against what the
+// machine actually does, instead of a hardcoded datasheet number.
+//
+// Lookup order: $MACHINE_PROFILE, then ./machine_profile.json.
+// Plain C so the C benchmarks (gemm_exercise_intel) can use it too.
+
+#ifndef MACHINE_PROFILE_H
+#define MACHINE_PROFILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MACHINE_PROFILE_FILE "machine_profile.json"
+
+typedef struct {
+    int loaded;               // 0: file missing, all numbers 0
+    char path[256];
+    char cpu_model[128];
+    int cores;
+    char simd[32];            // ISA the peaks were measured with
+
+    // Peak FMA throughput, GFLOPS
+    double peak_sp_1core, peak_sp_all;
+    double peak_dp_1core, peak_dp_all;
+
+    // Cache sizes, KB
+    double l1_kb, l2_kb, l3_kb;
+
+    // Bandwidth ceilings, GB/s: the better of the read-only and the
+    // read-modify-write (update) kernel at each level, traffic counted
+    // both ways
+    double bw_l1, bw_l2, bw_l3;
+    double bw_dram_1core, bw_dram_all;
+} machine_profile;
+
+// Value of a top-level numeric/string key in a flat JSON object
+static inline const char* mp_find(const char* json, const char* key) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char* p = strstr(json, pattern);
+    if (!p) return NULL;
+    p = strchr(p + strlen(pattern), ':');
+    if (!p) return NULL;
+    p++;
+    while (*p == ' ' || *p == '\t' || *p == '\n') p++;
+    return p;
+}
+
+static inline double mp_number(const char* json, const char* key) {
+    const char* p = mp_find(json, key);
+    return p ? strtod(p, NULL) : 0.0;
+}
+
+static inline void mp_string(const char* json, const char* key, char* out, size_t n) {
+    const char* p = mp_find(json, key);
+    out[0] = '\0';
+    if (!p || *p != '"') return;
+    p++;
+    size_t i = 0;
+    while (p[i] && p[i] != '"' && i + 1 < n) {
+        out[i] = p[i];
+        i++;
+    }
+    out[i] = '\0';
+}
+
+// Returns 1 if a profile was found and parsed
+static inline int machine_profile_load(machine_profile* mp) {
+    memset(mp, 0, sizeof(*mp));
+    const char* env = getenv("MACHINE_PROFILE");
+    snprintf(mp->path, sizeof(mp->path), "%s", (env && *env) ? env : MACHINE_PROFILE_FILE);
+
+    FILE* f = fopen(mp->path, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* json = (char*)malloc(size + 1);
+    if (!json || fread(json, 1, size, f) != (size_t)size) {
+        free(json);
+        fclose(f);
+        return 0;
+    }
+    json[size] = '\0';
+    fclose(f);
+
+    mp_string(json, "cpu_model", mp->cpu_model, sizeof(mp->cpu_model));
+    mp_string(json, "simd", mp->simd, sizeof(mp->simd));
+    mp->cores = (int)mp_number(json, "cores");
+    mp->peak_sp_1core = mp_number(json, "peak_sp_gflops_1core");
+    mp->peak_sp_all = mp_number(json, "peak_sp_gflops_all");
+    mp->peak_dp_1core = mp_number(json, "peak_dp_gflops_1core");
+    mp->peak_dp_all = mp_number(json, "peak_dp_gflops_all");
+    mp->l1_kb = mp_number(json, "cache_l1_kb");
+    mp->l2_kb = mp_number(json, "cache_l2_kb");
+    mp->l3_kb = mp_number(json, "cache_l3_kb");
+    mp->bw_l1 = mp_number(json, "bw_l1_gbs");
+    mp->bw_l2 = mp_number(json, "bw_l2_gbs");
+    mp->bw_l3 = mp_number(json, "bw_l3_gbs");
+    mp->bw_dram_1core = mp_number(json, "bw_dram_gbs_1core");
+    mp->bw_dram_all = mp_number(json, "bw_dram_gbs_all");
+    free(json);
+
+    mp->loaded = mp->peak_sp_1core > 0 && mp->bw_dram_1core > 0;
+    return mp->loaded;
+}
+
+// Roofline bound for one core: min(peak, I * DRAM bandwidth), GFLOPS
+static inline double machine_profile_roof(const machine_profile* mp, double intensity,
+                                          int double_precision) {
+    double peak = double_precision ? mp->peak_dp_1core : mp->peak_sp_1core;
+    double mem = intensity * mp->bw_dram_1core;
+    return mem < peak ? mem : peak;
+}
+
+// One-core report for a kernel that moved `bytes` from DRAM in `seconds`:
+// achieved fraction of the bandwidth ceiling and of the roofline bound
+static inline void machine_profile_report(double flops, double bytes, double seconds,
+                                          int double_precision) {
+    machine_profile mp;
+    if (!machine_profile_load(&mp)) {
+        printf("  (no %s: run `make profile` for measured ceilings)\n", MACHINE_PROFILE_FILE);
+        return;
+    }
+    double gflops = flops / seconds / 1e9, gbs = bytes / seconds / 1e9;
+    double roof = machine_profile_roof(&mp, flops / bytes, double_precision);
+    printf("  DRAM ceiling: %.1f GB/s (%.0f%% achieved)\n", mp.bw_dram_1core,
+           100.0 * gbs / mp.bw_dram_1core);
+    printf("  Roofline bound: %.2f GFLOPS (%.0f%% achieved, %s)\n", roof, 100.0 * gflops / roof,
+           roof < (double_precision ? mp.peak_dp_1core : mp.peak_sp_1core) ? "memory bound"
+                                                                           : "compute bound");
+}
+
+// ============================================================================
+// Roofline CSV: one schema for every producer (roofline.cpp sweeps,
+// gemm_progressive csv), consumed by `roofline plot`
+// ============================================================================
+#define MACHINE_PROFILE_CSV_HEADER \
+    "kernel,precision,size,working_set_mb,gflops,gbs,intensity,intensity_source,roof_gflops,pct_of_roof"
+
+// bytes: DRAM traffic, measured (LLC misses x 64) or from a traffic model,
+// as named by `source`. Roof columns stay empty without a profile.
+static inline void machine_profile_csv_row(FILE* f, const machine_profile* mp,
+                                           const char* kernel, int double_precision,
+                                           long size, double working_set_bytes,
+                                           double flops, double bytes, double seconds,
+                                           const char* source) {
+    double gflops = flops / seconds / 1e9;
+    double intensity = flops / (bytes > 0 ? bytes : 1.0);
+    fprintf(f, "%s,%s,%ld,%.3f,%.4f,%.3f,%.5f,%s,", kernel, double_precision ? "fp64" : "fp32",
+            size, working_set_bytes / 1e6, gflops, bytes / seconds / 1e9, intensity, source);
+    if (mp->loaded) {
+        double roof = machine_profile_roof(mp, intensity, double_precision);
+        fprintf(f, "%.4f,%.1f\n", roof, 100.0 * gflops / roof);
+    } else {
+        fprintf(f, ",\n");
+    }
+}
+
+#endif // MACHINE_PROFILE_H
@@ -0,0 +1,383 @@
+// roofline.cpp - Place every example kernel on the measured roofline
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma roofline.cpp -o roofline
+// Run: ./roofline sweep roofline.csv              (kernels x sizes -> CSV)
+//      ./roofline plot roofline.csv roofline.svg  (CSV + profile -> SVG)
+//
+// `make report` runs both, appending the GEMM stages of
+// gemm_exercise_intel/gemm_progressive (its `csv` mode) in between.
+//
+// For every kernel and size the sweep records achieved GFLOPS and the
+// operational intensity I = flops / DRAM bytes. DRAM bytes are measured
+// as LLC misses x 64 when perf_event_open() is allowed, otherwise taken
+// from the same traffic model each example prints (intensity_source
+// says which). The plot draws the fp32/fp64 peaks and the L1/L2/L3/DRAM
+// bandwidth slopes from machine_profile.json, so small in-cache sizes
+// show up above the DRAM roof and below their cache level's roof.
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "machine_profile.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static volatile double sink;
+
+// ============================================================================
+// Kernels (same code as the single-file examples)
+// ============================================================================
+
+void daxpy(double* y, double alpha, double* x, int n) {
+    for (int i = 0; i < n; i++) y[i] = alpha * x[i] + y[i];
+}
+
+double dot(double* x, double* y, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) s += x[i] * y[i];
+    return s;
+}
+
+void gemv(double* y, double* A, double* x, int n) {
+    for (int i = 0; i < n; i++) {
+        y[i] = 0;
+        for (int j = 0; j < n; j++) y[i] += A[i * n + j] * x[j];
+    }
+}
+
+void stencil_2d(double* B, double* A, int n) {
+    for (int i = 1; i < n - 1; i++)
+        for (int j = 1; j < n - 1; j++)
+            B[i * n + j] = 0.25 * (A[(i-1) * n + j] + A[(i+1) * n + j] +
+                                   A[i * n + (j-1)] + A[i * n + (j+1)]);
+}
+
+// gemm.cpp is built with -fno-tree-vectorize to isolate the effect of blocking
+const int BLOCK = 32;
+
+__attribute__((optimize("no-tree-vectorize")))
+void gemm_naive(const double* A, const double* B, double* C, int n) {
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            for (int k = 0; k < n; k++)
+                C[i * n + j] += A[i * n + k] * B[k * n + j];
+}
+
+__attribute__((optimize("no-tree-vectorize")))
+void gemm_blocked(const double* A, const double* B, double* C, int n) {
+    for (int ii = 0; ii < n; ii += BLOCK)
+        for (int jj = 0; jj < n; jj += BLOCK)
+            for (int kk = 0; kk < n; kk += BLOCK)
+                for (int i = ii; i < ii + BLOCK; i++)
+                    for (int j = jj; j < jj + BLOCK; j++)
+                        for (int k = kk; k < kk + BLOCK; k++)
+                            C[i * n + j] += A[i * n + k] * B[k * n + j];
+}
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+// LLC misses via perf_event_open, -1 when counters are not available
+static int llc_open() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static long long llc_count(int fd, const function<void()>& body) {
+    if (fd < 0) {
+        body();
+        return -1;
+    }
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    body();
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long count = -1;
+    if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) return -1;
+    return count;
+}
+
+struct harness {
+    FILE* out;
+    machine_profile mp;
+    int llc_fd;
+
+    // Warm up once, then repeat for >= 0.2 s; bytes per call from LLC
+    // misses when counted, else `model_bytes`
+    void run(const char* kernel, long size, double working_set, double flops,
+             double model_bytes, const function<void()>& fn) {
+        fn();
+        int reps = 1;
+        double t = 0;
+        long long misses = -1;
+        for (;;) {
+            double t0 = now();
+            misses = llc_count(llc_fd, [&] {
+                for (int r = 0; r < reps; r++) fn();
+            });
+            t = now() - t0;
+            if (t >= 0.2 || reps >= (1 << 20)) break;
+            reps *= (t > 0.02) ? 2 : 8;
+        }
+        double seconds = t / reps;
+        double bytes = misses >= 0 ? 64.0 * misses / reps : model_bytes;
+        machine_profile_csv_row(out, &mp, kernel, 1, size, working_set, flops, bytes, seconds,
+                                misses >= 0 ? "llc_misses" : "model");
+        fflush(out);
+        printf("  %-14s n=%-10ld %8.2f GFLOPS  I=%.3f\n", kernel, size, flops / seconds / 1e9,
+               flops / bytes);
+    }
+};
+
+static double* alloc_doubles(size_t n, double value) {
+    double* p = (double*)aligned_alloc(64, ((n * sizeof(double) + 63) / 64) * 64);
+    if (!p) abort();
+    for (size_t i = 0; i < n; i++) p[i] = value;
+    return p;
+}
+
+static int sweep(const char* path) {
+    harness h;
+    machine_profile_load(&h.mp);
+    h.llc_fd = llc_open();
+    h.out = fopen(path, "w");
+    if (!h.out) {
+        perror(path);
+        return 1;
+    }
+    fprintf(h.out, "%s\n", MACHINE_PROFILE_CSV_HEADER);
+    printf("Roofline sweep -> %s (intensity from %s)\n", path,
+           h.llc_fd >= 0 ? "LLC misses" : "traffic model; perf_event_open unavailable");
+
+    // BLAS 1: n from L2-resident to DRAM
+    for (int n = 1 << 16; n <= 1 << 26; n <<= 2) {
+        double* x = alloc_doubles(n, 1.0);
+        double* y = alloc_doubles(n, 1.0);
+        h.run("daxpy", n, 16.0 * n, 2.0 * n, 24.0 * n, [&] { daxpy(y, 1e-9, x, n); });
+        h.run("dot", n, 16.0 * n, 2.0 * n, 16.0 * n, [&] { sink = dot(x, y, n); });
+        free(x);
+        free(y);
+    }
+
+    // BLAS 2
+    for (int n = 512; n <= 8192; n *= 2) {
+        double* A = alloc_doubles((size_t)n * n, 1.0);
+        double* x = alloc_doubles(n, 1.0);
+        double* y = alloc_doubles(n, 0.0);
+        h.run("gemv", n, 8.0 * n * n, 2.0 * n * n, 8.0 * n * n + 16.0 * n,
+              [&] { gemv(y, A, x, n); });
+        free(A);
+        free(x);
+        free(y);
+    }
+
+    // Stencil
+    for (int n = 256; n <= 8192; n *= 2) {
+        double* A = alloc_doubles((size_t)n * n, 1.0);
+        double* B = alloc_doubles((size_t)n * n, 0.0);
+        h.run("stencil", n, 16.0 * n * n, 4.0 * (n - 2) * (n - 2), 16.0 * n * n,
+              [&] { stencil_2d(B, A, n); });
+        free(A);
+        free(B);
+    }
+
+    // GEMM: naive re-reads B for every row (8n^3 bytes), blocked cuts that by BLOCK
+    for (int n = 128; n <= 1024; n *= 2) {
+        double* A = alloc_doubles((size_t)n * n, 1.0);
+        double* B = alloc_doubles((size_t)n * n, 1.0);
+        double* C = alloc_doubles((size_t)n * n, 0.0);
+        double flops = 2.0 * n * n * n;
+        if (n <= 512)
+            h.run("gemm_naive", n, 24.0 * n * n, flops, 8.0 * n * n * n,
+                  [&] { gemm_naive(A, B, C, n); });
+        if (n >= 256)
+            h.run("gemm_blocked", n, 24.0 * n * n, flops, 2.0 * n * n * n / BLOCK * 8,
+                  [&] { gemm_blocked(A, B, C, n); });
+        free(A);
+        free(B);
+        free(C);
+    }
+
+    if (h.llc_fd >= 0) close(h.llc_fd);
+    fclose(h.out);
+    return 0;
+}
+
+// ============================================================================
+// SVG plot
+// ============================================================================
+struct point {
+    string kernel, precision;
+    long size;
+    double gflops, intensity;
+};
+
+static vector<point> read_csv(const char* path) {
+    vector<point> pts;
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return pts;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "kernel,", 7) == 0) continue;  // header(s)
+        char kernel[128], prec[16];
+        long size;
+        double ws, gflops, gbs, intensity;
+        if (sscanf(line, "%127[^,],%15[^,],%ld,%lf,%lf,%lf,%lf", kernel, prec, &size, &ws,
+                   &gflops, &gbs, &intensity) == 7 && gflops > 0 && intensity > 0)
+            pts.push_back({kernel, prec, size, gflops, intensity});
+    }
+    fclose(f);
+    return pts;
+}
+
+static int plot(const char* csv_path, const char* svg_path) {
+    vector<point> pts = read_csv(csv_path);
+    if (pts.empty()) {
+        fprintf(stderr, "no data points in %s\n", csv_path);
+        return 1;
+    }
+    machine_profile mp;
+    if (!machine_profile_load(&mp)) {
+        fprintf(stderr, "no %s: run `make profile` first\n", mp.path);
+        return 1;
+    }
+
+    // Log-log axes: intensity (x, base 2) and GFLOPS (y, base 10)
+    double imin = 1e30, imax = 0, gmin = 1e30;
+    for (auto& p : pts) {
+        imin = min(imin, p.intensity);
+        imax = max(imax, p.intensity);
+        gmin = min(gmin, p.gflops);
+    }
+    imax = max(imax, 4 * mp.peak_sp_1core / mp.bw_dram_1core);
+    double x0 = floor(log2(imin)), x1 = ceil(log2(imax));
+    double y0 = floor(log10(gmin)), y1 = ceil(log10(2 * mp.peak_sp_1core));
+    const double W = 960, H = 640, L = 80, R = 220, T = 50, B = 60;
+    auto sx = [&](double i) { return L + (log2(i) - x0) / (x1 - x0) * (W - L - R); };
+    auto sy = [&](double g) { return H - B - (log10(g) - y0) / (y1 - y0) * (H - T - B); };
+
+    FILE* f = fopen(svg_path, "w");
+    if (!f) {
+        perror(svg_path);
+        return 1;
+    }
+    fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%.0f\" height=\"%.0f\" "
+               "font-family=\"sans-serif\" font-size=\"12\">\n", W, H);
+    fprintf(f, "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n");
+    fprintf(f, "<text x=\"%.0f\" y=\"24\" font-size=\"16\">Roofline: %s (1 core)</text>\n",
+            L, mp.cpu_model);
+
+    // Grid + axis labels
+    for (double e = x0; e <= x1; e++) {
+        fprintf(f, "<line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"#ddd\"/>\n",
+                sx(pow(2, e)), (double)T, sx(pow(2, e)), H - B);
+        fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"middle\">%g</text>\n",
+                sx(pow(2, e)), H - B + 18, pow(2, e));
+    }
+    for (double e = y0; e <= y1; e++) {
+        fprintf(f, "<line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"#ddd\"/>\n",
+                L, sy(pow(10, e)), W - R, sy(pow(10, e)));
+        fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"end\">%g</text>\n",
+                L - 6, sy(pow(10, e)) + 4, pow(10, e));
+    }
+    fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"middle\">Operational intensity "
+               "(flops/byte)</text>\n", (L + W - R) / 2, H - 16);
+    fprintf(f, "<text x=\"20\" y=\"%.1f\" transform=\"rotate(-90 20 %.1f)\" "
+               "text-anchor=\"middle\">GFLOPS</text>\n", (T + H - B) / 2, (T + H - B) / 2);
+
+    // Ceilings: bandwidth slopes capped by the fp32 peak, plus both peaks
+    struct { const char* name; double bw; const char* color; } roofs[] = {
+        {"L1", mp.bw_l1, "#9ecae1"}, {"L2", mp.bw_l2, "#6baed6"},
+        {"L3", mp.bw_l3, "#3182bd"}, {"DRAM", mp.bw_dram_1core, "#08519c"},
+    };
+    double ilo = pow(2, x0), ihi = pow(2, x1);
+    for (auto& r : roofs) {
+        if (r.bw <= 0) continue;
+        double ridge = mp.peak_sp_1core / r.bw;
+        double i_start = max(ilo, pow(10, y0) / r.bw);
+        fprintf(f, "<polyline fill=\"none\" stroke=\"%s\" stroke-width=\"2\" points=\"%.1f,%.1f "
+                   "%.1f,%.1f\"/>\n", r.color, sx(i_start), sy(i_start * r.bw),
+                sx(min(ridge, ihi)), sy(min(ridge, ihi) * r.bw));
+        fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" fill=\"%s\">%s %.0f GB/s</text>\n",
+                sx(i_start) + 4, sy(i_start * r.bw) - 6, r.color, r.name, r.bw);
+    }
+    struct { const char* name; double peak; const char* dash; } peaks[] = {
+        {"fp32 peak", mp.peak_sp_1core, ""}, {"fp64 peak", mp.peak_dp_1core, "6,4"},
+    };
+    for (auto& p : peaks) {
+        double ridge = p.peak / mp.bw_l1;
+        fprintf(f, "<line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"#a50f15\" "
+                   "stroke-width=\"2\" stroke-dasharray=\"%s\"/>\n",
+                sx(max(ilo, ridge)), sy(p.peak), W - R, sy(p.peak), p.dash);
+        fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" fill=\"#a50f15\" text-anchor=\"end\">%s %.0f "
+                   "GFLOPS</text>\n", W - R, sy(p.peak) - 6, p.name, p.peak);
+    }
+
+    // Points, one color per kernel
+    const char* palette[] = {"#e41a1c", "#4daf4a", "#984ea3", "#ff7f00", "#a65628",
+                             "#f781bf", "#999999", "#17becf", "#bcbd22", "#1f77b4",
+                             "#8c564b", "#d62728", "#2ca02c"};
+    map<string, int> color_of;
+    for (auto& p : pts) {
+        if (!color_of.count(p.kernel)) {
+            int c = (int)color_of.size();
+            color_of[p.kernel] = c;
+        }
+        const char* color = palette[color_of[p.kernel] % 13];
+        fprintf(f, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"%s\" fill=\"%s\" fill-opacity=\"0.8\">"
+                   "<title>%s n=%ld %s: %.2f GFLOPS, I=%.3f</title></circle>\n",
+                sx(p.intensity), sy(p.gflops), p.precision == "fp32" ? "6" : "4", color,
+                p.kernel.c_str(), p.size, p.precision.c_str(), p.gflops, p.intensity);
+    }
+
+    // Legend
+    int row = 0;
+    vector<pair<int, string>> legend;
+    for (auto& kv : color_of) legend.push_back({kv.second, kv.first});
+    sort(legend.begin(), legend.end());
+    for (auto& e : legend) {
+        double y = T + 16 + 18 * row++;
+        fprintf(f, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"5\" fill=\"%s\"/>\n", W - R + 20, y - 4,
+                palette[e.first % 13]);
+        fprintf(f, "<text x=\"%.1f\" y=\"%.1f\">%s</text>\n", W - R + 30, y, e.second.c_str());
+    }
+    fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" fill=\"#666\">large dots: fp32</text>\n",
+            W - R + 20, T + 16 + 18.0 * row + 8);
+    fprintf(f, "</svg>\n");
+    fclose(f);
+    printf("Wrote %s (%zu points)\n", svg_path, pts.size());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "sweep") == 0)
+        return sweep(argc >= 3 ? argv[2] : "roofline.csv");
+    if (argc >= 2 && strcmp(argv[1], "plot") == 0)
+        return plot(argc >= 3 ? argv[2] : "roofline.csv", argc >= 4 ? argv[3] : "roofline.svg");
+    fprintf(stderr, "usage: %s sweep [out.csv] | plot [in.csv] [out.svg]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,625 @@
+// spmv.cpp - Sparse matrix-vector product: CSR, SELL-C-sigma and BCSR on the roofline
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread spmv.cpp -o spmv
+// Run: ./spmv                          (synthetic suite)
+//      ./spmv lap2d 1000 | fem2d 700 | random 1000000 16 | powerlaw 1000000
+//      ./spmv matrix.mtx               (Matrix Market, coordinate format)
+//      ./spmv csv                      (suite as roofline.csv rows, see `make report`)
+//
+// y = A x with nnz nonzeros does 2 nnz flops and streams every value
+// (8 bytes) and column index (4 bytes) once: I <= 2 / 12 = 1/6 flops/byte,
+// below even GEMV, plus whatever x costs when its gathers miss cache.
+// The formats only change how close to that bound one gets:
+//
+//   CSR         row pointers + (col, val) per nonzero; AVX2 gathers 4 x
+//               values per step, short rows end in a scalar tail
+//   SELL-C-s    rows sorted by length inside windows of s rows, cut into
+//               chunks of C, each chunk padded to its longest row and stored
+//               column-major: one vector op covers C rows, no tails
+//   BCSR 2x2    dense 2x2 blocks with one column index per block: 4 values
+//               per index and no gather (x pair is one 128-bit broadcast),
+//               at the price of explicit zeros where blocks are not full
+//
+// Threads split work by nonzeros (stored entries, including padding), not
+// rows, so a power-law matrix with a few huge rows stays balanced. Traffic
+// is the compulsory model: matrix data + index arrays + x read once + y.
+
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "machine_profile.h"
+#include "thread_pool.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline double hsum(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+// x[idx[0..3]]; the masked form with a zero source avoids GCC's
+// maybe-uninitialized false positive on _mm256_i32gather_pd
+static inline __m256d gather(const double* x, __m128i idx) {
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, idx,
+                                    _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+
+struct csr {
+    int rows, cols;
+    vector<int> ptr, col;  // ptr: rows + 1
+    vector<double> val;
+    size_t nnz() const { return val.size(); }
+};
+
+// ============================================================================
+// Matrix Market loader (coordinate real/integer/pattern, general/symmetric)
+// ============================================================================
+
+// COO triplets -> CSR, columns sorted, duplicates summed
+static void coo_to_csr(int rows, int cols, const vector<int>& ri, const vector<int>& ci,
+                       const vector<double>& v, csr& A) {
+    A.rows = rows;
+    A.cols = cols;
+    A.ptr.assign(rows + 1, 0);
+    for (int r : ri) A.ptr[r + 1]++;
+    for (int i = 0; i < rows; i++) A.ptr[i + 1] += A.ptr[i];
+    vector<int> next(A.ptr.begin(), A.ptr.end() - 1);
+    vector<pair<int, double>> entries(v.size());
+    for (size_t k = 0; k < v.size(); k++) entries[next[ri[k]]++] = make_pair(ci[k], v[k]);
+
+    A.col.clear();
+    A.val.clear();
+    int out_start = 0;
+    for (int i = 0; i < rows; i++) {
+        sort(entries.begin() + A.ptr[i], entries.begin() + A.ptr[i + 1],
+             [](const pair<int, double>& a, const pair<int, double>& b) { return a.first < b.first; });
+        for (int k = A.ptr[i]; k < A.ptr[i + 1]; k++) {
+            if ((int)A.col.size() > out_start && A.col.back() == entries[k].first) {
+                A.val.back() += entries[k].second;
+            } else {
+                A.col.push_back(entries[k].first);
+                A.val.push_back(entries[k].second);
+            }
+        }
+        A.ptr[i] = out_start;
+        out_start = (int)A.col.size();
+    }
+    A.ptr[rows] = out_start;
+}
+
+static bool load_mtx(const char* path, csr& A) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char line[1024], object[64], format[64], field[64], symmetry[64];
+    if (!fgets(line, sizeof(line), f) ||
+        sscanf(line, "%%%%MatrixMarket %63s %63s %63s %63s", object, format, field, symmetry) != 4 ||
+        strcmp(format, "coordinate") != 0 || strcmp(field, "complex") == 0) {
+        fprintf(stderr, "%s: only real/integer/pattern coordinate Matrix Market files\n", path);
+        fclose(f);
+        return false;
+    }
+    bool pattern = strcmp(field, "pattern") == 0;
+    bool symmetric = strcmp(symmetry, "symmetric") == 0;
+    bool skew = strcmp(symmetry, "skew-symmetric") == 0;
+    do {
+        if (!fgets(line, sizeof(line), f)) {
+            fclose(f);
+            return false;
+        }
+    } while (line[0] == '%');
+    int rows, cols;
+    long entries;
+    if (sscanf(line, "%d %d %ld", &rows, &cols, &entries) != 3 || rows <= 0 || cols <= 0 ||
+        entries < 0 || entries > (long)rows * cols || entries > INT_MAX / 2 ||
+        ((symmetric || skew) && rows != cols)) {
+        fprintf(stderr, "%s: bad size line: %s", path, line);
+        fclose(f);
+        return false;
+    }
+    vector<int> ri, ci;
+    vector<double> v;
+    ri.reserve(entries * (symmetric || skew ? 2 : 1));
+    ci.reserve(ri.capacity());
+    v.reserve(ri.capacity());
+    for (long k = 0; k < entries; k++) {
+        int i, j;
+        double a = 1.0;
+        if (fscanf(f, "%d %d", &i, &j) != 2 || (!pattern && fscanf(f, "%lf", &a) != 1)) {
+            fprintf(stderr, "%s: truncated at entry %ld\n", path, k);
+            fclose(f);
+            return false;
+        }
+        if (i < 1 || i > rows || j < 1 || j > cols) {
+            fprintf(stderr, "%s: entry %ld (%d, %d) outside the %d x %d matrix\n", path, k, i, j,
+                    rows, cols);
+            fclose(f);
+            return false;
+        }
+        ri.push_back(i - 1);
+        ci.push_back(j - 1);
+        v.push_back(a);
+        if ((symmetric || skew) && i != j) {
+            ri.push_back(j - 1);
+            ci.push_back(i - 1);
+            v.push_back(skew ? -a : a);
+        }
+    }
+    fclose(f);
+    coo_to_csr(rows, cols, ri, ci, v, A);
+    return true;
+}
+
+// ============================================================================
+// Synthetic generators
+// ============================================================================
+
+static uint64_t rng_state = 0x2545F4914F6CDD1Dull;
+static inline uint64_t rng() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+static inline double uniform() { return (rng() >> 11) * (1.0 / 9007199254740992.0); }
+
+// 5-point Laplacian on a g x g grid
+static void gen_lap2d(int g, csr& A) {
+    A.rows = A.cols = g * g;
+    A.ptr.assign(1, 0);
+    A.col.clear();
+    A.val.clear();
+    for (int i = 0; i < g; i++)
+        for (int j = 0; j < g; j++) {
+            int r = i * g + j;
+            if (i > 0) A.col.push_back(r - g), A.val.push_back(-1);
+            if (j > 0) A.col.push_back(r - 1), A.val.push_back(-1);
+            A.col.push_back(r), A.val.push_back(4);
+            if (j < g - 1) A.col.push_back(r + 1), A.val.push_back(-1);
+            if (i < g - 1) A.col.push_back(r + g), A.val.push_back(-1);
+            A.ptr.push_back((int)A.col.size());
+        }
+}
+
+// Same grid with 2 unknowns per node (elasticity-like): every coupling is
+// a dense 2x2 block, the case BCSR is built for
+static void gen_fem2d(int g, csr& A) {
+    A.rows = A.cols = 2 * g * g;
+    A.ptr.assign(1, 0);
+    A.col.clear();
+    A.val.clear();
+    for (int i = 0; i < g; i++)
+        for (int j = 0; j < g; j++)
+            for (int d = 0; d < 2; d++) {
+                int node = i * g + j;
+                int nbr[5] = {i > 0 ? node - g : -1, j > 0 ? node - 1 : -1, node,
+                              j < g - 1 ? node + 1 : -1, i < g - 1 ? node + g : -1};
+                for (int b : nbr) {
+                    if (b < 0) continue;
+                    for (int e = 0; e < 2; e++) {
+                        A.col.push_back(2 * b + e);
+                        A.val.push_back(b == node ? (d == e ? 8.0 : 0.5) : (d == e ? -1.0 : -0.25));
+                    }
+                }
+                A.ptr.push_back((int)A.col.size());
+            }
+}
+
+// `k` uniformly random columns per row: x gathers miss cache
+static void gen_random(int n, int k, csr& A) {
+    vector<int> ri, ci;
+    vector<double> v;
+    for (int i = 0; i < n; i++)
+        for (int t = 0; t < k; t++) {
+            ri.push_back(i);
+            ci.push_back((int)(rng() % n));
+            v.push_back(uniform() - 0.5);
+        }
+    coo_to_csr(n, n, ri, ci, v, A);
+}
+
+// Heavy-tailed row lengths (Pareto, mean ~16, capped at n/8) with columns
+// near the diagonal: a graph-like matrix where equal-row splits go wrong
+static void gen_powerlaw(int n, csr& A) {
+    vector<int> ri, ci;
+    vector<double> v;
+    for (int i = 0; i < n; i++) {
+        int len = (int)min((double)n / 8, 4.0 / pow(1.0 - uniform(), 1.0 / 1.3));
+        for (int t = 0; t < len; t++) {
+            long off = (long)((uniform() - 0.5) * 2 * min(n, 65536));
+            ri.push_back(i);
+            ci.push_back((int)((i + off + n) % n));
+            v.push_back(uniform() - 0.5);
+        }
+    }
+    coo_to_csr(n, n, ri, ci, v, A);
+}
+
+// ============================================================================
+// Formats
+// ============================================================================
+
+template <int C>
+struct sell {
+    int rows, chunks, sigma;
+    vector<int> cptr, clen;  // chunk offset (entries) and width
+    vector<int> perm;        // chunk slot -> row, -1 for padding slots
+    vector<int> col;
+    vector<double> val;
+};
+
+template <int C>
+static void build_sell(const csr& A, int sigma, sell<C>& S) {
+    int n = A.rows;
+    S.rows = n;
+    S.sigma = sigma;
+    S.chunks = (n + C - 1) / C;
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) order[i] = i;
+    auto len = [&](int r) { return A.ptr[r + 1] - A.ptr[r]; };
+    for (int w = 0; w < n; w += sigma)
+        stable_sort(order.begin() + w, order.begin() + min(n, w + sigma),
+                    [&](int a, int b) { return len(a) > len(b); });
+    S.perm.assign((size_t)S.chunks * C, -1);
+    copy(order.begin(), order.end(), S.perm.begin());
+    S.cptr.assign(S.chunks + 1, 0);
+    S.clen.assign(S.chunks, 0);
+    for (int c = 0; c < S.chunks; c++) {
+        for (int r = 0; r < C; r++)
+            if (S.perm[c * C + r] >= 0) S.clen[c] = max(S.clen[c], len(S.perm[c * C + r]));
+        S.cptr[c + 1] = S.cptr[c] + S.clen[c] * C;
+    }
+    // Padding: value 0 at column 0 (its x stays in cache)
+    S.col.assign(S.cptr[S.chunks], 0);
+    S.val.assign(S.cptr[S.chunks], 0.0);
+    for (int c = 0; c < S.chunks; c++)
+        for (int r = 0; r < C; r++) {
+            int row = S.perm[c * C + r];
+            if (row < 0) continue;
+            for (int j = 0; j < len(row); j++) {
+                S.col[S.cptr[c] + j * C + r] = A.col[A.ptr[row] + j];
+                S.val[S.cptr[c] + j * C + r] = A.val[A.ptr[row] + j];
+            }
+        }
+}
+
+struct bcsr2 {
+    int rows, brows;
+    vector<int> bptr, bcol;  // per block row / per block (block column index)
+    vector<double> val;      // 4 per block, row-major
+    size_t blocks() const { return bcol.size(); }
+};
+
+static void build_bcsr2(const csr& A, bcsr2& B) {
+    B.rows = A.rows;
+    B.brows = (A.rows + 1) / 2;
+    B.bptr.assign(1, 0);
+    B.bcol.clear();
+    B.val.clear();
+    vector<int> slot((A.cols + 1) / 2, -1);
+    for (int br = 0; br < B.brows; br++) {
+        int first = (int)B.bcol.size();
+        for (int r = 2 * br; r < min(A.rows, 2 * br + 2); r++)
+            for (int k = A.ptr[r]; k < A.ptr[r + 1]; k++) {
+                int bc = A.col[k] / 2;
+                if (slot[bc] < first) {
+                    slot[bc] = (int)B.bcol.size();
+                    B.bcol.push_back(bc);
+                }
+            }
+        sort(B.bcol.begin() + first, B.bcol.end());
+        for (int b = first; b < (int)B.bcol.size(); b++) slot[B.bcol[b]] = b;
+        B.val.resize(B.bcol.size() * 4, 0.0);
+        for (int r = 2 * br; r < min(A.rows, 2 * br + 2); r++)
+            for (int k = A.ptr[r]; k < A.ptr[r + 1]; k++)
+                B.val[(size_t)slot[A.col[k] / 2] * 4 + (r - 2 * br) * 2 + A.col[k] % 2] = A.val[k];
+        B.bptr.push_back((int)B.bcol.size());
+    }
+}
+
+// Thread boundaries over [0, items) so each thread gets ~equal work, where
+// prefix[i] is the work before item i (a row/chunk/block-row pointer)
+static vector<int> split_by_work(const vector<int>& prefix, int items, int threads) {
+    vector<int> bounds(threads + 1, items);
+    bounds[0] = 0;
+    for (int t = 1; t < threads; t++) {
+        long target = (long)prefix[items] * t / threads;
+        bounds[t] = (int)(lower_bound(prefix.begin(), prefix.begin() + items + 1, target) -
+                          prefix.begin());
+        bounds[t] = max(bounds[t], bounds[t - 1]);
+    }
+    return bounds;
+}
+
+// ============================================================================
+// Kernels: rows (chunks, block rows) [lo, hi)
+// ============================================================================
+
+__attribute__((optimize("no-tree-vectorize")))
+static void spmv_csr_scalar(const csr& A, const double* x, double* y, int lo, int hi) {
+    for (int i = lo; i < hi; i++) {
+        double s = 0;
+        for (int k = A.ptr[i]; k < A.ptr[i + 1]; k++) s += A.val[k] * x[A.col[k]];
+        y[i] = s;
+    }
+}
+
+static void spmv_csr_avx2(const csr& A, const double* x, double* y, int lo, int hi) {
+    const int* col = A.col.data();
+    const double* val = A.val.data();
+    for (int i = lo; i < hi; i++) {
+        int k = A.ptr[i], e = A.ptr[i + 1];
+        __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+        for (; k + 8 <= e; k += 8) {
+            __m128i c0 = _mm_loadu_si128((const __m128i*)(col + k));
+            __m128i c1 = _mm_loadu_si128((const __m128i*)(col + k + 4));
+            a0 = _mm256_fmadd_pd(_mm256_loadu_pd(val + k), gather(x, c0), a0);
+            a1 = _mm256_fmadd_pd(_mm256_loadu_pd(val + k + 4), gather(x, c1), a1);
+        }
+        if (k + 4 <= e) {
+            __m128i c0 = _mm_loadu_si128((const __m128i*)(col + k));
+            a0 = _mm256_fmadd_pd(_mm256_loadu_pd(val + k), gather(x, c0), a0);
+            k += 4;
+        }
+        double s = hsum(_mm256_add_pd(a0, a1));
+        for (; k < e; k++) s += val[k] * x[col[k]];
+        y[i] = s;
+    }
+}
+
+template <int C>
+static void spmv_sell(const sell<C>& S, const double* x, double* y, int lo, int hi) {
+    const int V = C / 4;  // vectors per chunk column
+    for (int c = lo; c < hi; c++) {
+        __m256d acc[V];
+        for (int v = 0; v < V; v++) acc[v] = _mm256_setzero_pd();
+        const int* col = S.col.data() + S.cptr[c];
+        const double* val = S.val.data() + S.cptr[c];
+        for (int j = 0; j < S.clen[c]; j++)
+            for (int v = 0; v < V; v++) {
+                __m128i ci = _mm_loadu_si128((const __m128i*)(col + j * C + 4 * v));
+                acc[v] = _mm256_fmadd_pd(_mm256_loadu_pd(val + j * C + 4 * v),
+                                         gather(x, ci), acc[v]);
+            }
+        alignas(32) double out[C];
+        for (int v = 0; v < V; v++) _mm256_store_pd(out + 4 * v, acc[v]);
+        for (int r = 0; r < C; r++) {
+            int row = S.perm[c * C + r];
+            if (row >= 0) y[row] = out[r];
+        }
+    }
+}
+
+// x and y padded to an even length
+static void spmv_bcsr2(const bcsr2& B, const double* x, double* y, int lo, int hi) {
+    const double* val = B.val.data();
+    for (int br = lo; br < hi; br++) {
+        // acc = (a00 x0, a01 x1, a10 x0, a11 x1) summed over the block row
+        __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+        int b = B.bptr[br], e = B.bptr[br + 1];
+        for (; b + 2 <= e; b += 2) {
+            __m256d x0 = _mm256_broadcast_pd((const __m128d*)(x + 2 * B.bcol[b]));
+            __m256d x1 = _mm256_broadcast_pd((const __m128d*)(x + 2 * B.bcol[b + 1]));
+            a0 = _mm256_fmadd_pd(_mm256_loadu_pd(val + 4 * (size_t)b), x0, a0);
+            a1 = _mm256_fmadd_pd(_mm256_loadu_pd(val + 4 * (size_t)b + 4), x1, a1);
+        }
+        if (b < e) {
+            __m256d x0 = _mm256_broadcast_pd((const __m128d*)(x + 2 * B.bcol[b]));
+            a0 = _mm256_fmadd_pd(_mm256_loadu_pd(val + 4 * (size_t)b), x0, a0);
+        }
+        __m256d acc = _mm256_add_pd(a0, a1);
+        __m128d yy = _mm_hadd_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+        _mm_storeu_pd(y + 2 * br, yy);
+    }
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+struct result {
+    string name, id;  // id: roofline.csv kernel column
+    double seconds, bytes, fill, err;
+};
+
+template <class F>
+static double time_call(F&& f) {
+    double best = 1e30, total = 0;
+    for (int r = 0; r < 500 && (r < 3 || total < 0.3); r++) {
+        double t0 = now();
+        f();
+        double t = now() - t0;
+        total += t;
+        best = min(best, t);
+    }
+    return best;
+}
+
+// Kernel over the pool with per-thread [bounds[id], bounds[id+1])
+template <class K>
+static double time_split(thread_pool& pool, const vector<int>& bounds, K kernel) {
+    return time_call([&] { pool.run([&](int id) { kernel(bounds[id], bounds[id + 1]); }); });
+}
+
+static double max_rel_err(const vector<double>& y, const vector<double>& ref, int n) {
+    double err = 0, scale = 0;
+    for (int i = 0; i < n; i++) {
+        err = max(err, fabs(y[i] - ref[i]));
+        scale = max(scale, fabs(ref[i]));
+    }
+    return err / (scale > 0 ? scale : 1.0);
+}
+
+static vector<result> bench(const csr& A, thread_pool& pool) {
+    int n = A.rows, T = pool.n;
+    double nnz = (double)A.nnz();
+    // x, y padded to even length for BCSR 2x2 (all kernels load x unaligned)
+    vector<double> x(A.cols + 2, 0.0), y(n + 2), ref(n + 2);
+    for (int j = 0; j < A.cols; j++) x[j] = 1.0 + 0.5 * sin(0.01 * j);
+    double xy_bytes = 8.0 * A.cols + 8.0 * n;
+
+    sell<4> S4;
+    sell<8> S8;
+    build_sell(A, 256, S4);
+    build_sell(A, 256, S8);
+    bcsr2 B;
+    build_bcsr2(A, B);
+
+    vector<int> rows_equal(T + 1);
+    for (int t = 0; t <= T; t++) rows_equal[t] = (int)((long)n * t / T);
+    vector<int> rows_nnz = split_by_work(A.ptr, n, T);
+    vector<int> chunks4 = split_by_work(S4.cptr, S4.chunks, T);
+    vector<int> chunks8 = split_by_work(S8.cptr, S8.chunks, T);
+    vector<int> brows = split_by_work(B.bptr, B.brows, T);
+
+    vector<result> out;
+    double csr_bytes = nnz * 12 + 4.0 * (n + 1) + xy_bytes;
+    auto record = [&](const string& name, const string& id, double t, double bytes,
+                      double stored) {
+        out.push_back({name, id, t, bytes, stored / nnz, max_rel_err(y, ref, n)});
+    };
+
+    double t = time_split(pool, rows_nnz, [&](int lo, int hi) {
+        spmv_csr_scalar(A, x.data(), ref.data(), lo, hi);
+    });
+    y = ref;
+    record("CSR scalar", "", t, csr_bytes, nnz);
+    if (T > 1) {
+        t = time_split(pool, rows_equal, [&](int lo, int hi) {
+            spmv_csr_avx2(A, x.data(), y.data(), lo, hi);
+        });
+        record("CSR AVX2, equal rows", "", t, csr_bytes, nnz);
+    }
+    t = time_split(pool, rows_nnz, [&](int lo, int hi) {
+        spmv_csr_avx2(A, x.data(), y.data(), lo, hi);
+    });
+    record("CSR AVX2", "spmv_csr", t, csr_bytes, nnz);
+    t = time_split(pool, chunks4, [&](int lo, int hi) {
+        spmv_sell(S4, x.data(), y.data(), lo, hi);
+    });
+    record("SELL-4-256", "", t, S4.cptr.back() * 12.0 + 8.0 * S4.chunks + 4.0 * n + xy_bytes,
+           S4.cptr.back());
+    t = time_split(pool, chunks8, [&](int lo, int hi) {
+        spmv_sell(S8, x.data(), y.data(), lo, hi);
+    });
+    record("SELL-8-256", "spmv_sell8", t, S8.cptr.back() * 12.0 + 8.0 * S8.chunks + 4.0 * n + xy_bytes,
+           S8.cptr.back());
+    t = time_split(pool, brows, [&](int lo, int hi) {
+        spmv_bcsr2(B, x.data(), y.data(), lo, hi);
+    });
+    record("BCSR 2x2", "spmv_bcsr2", t, B.blocks() * 36.0 + 4.0 * (B.brows + 1) + xy_bytes, B.blocks() * 4.0);
+    return out;
+}
+
+static void print_table(const char* title, const csr& A, const vector<result>& res,
+                        const machine_profile& mp, int threads) {
+    double nnz = (double)A.nnz();
+    printf("\n%s: %d x %d, %.0f nnz (%.1f per row), %d thread%s\n", title, A.rows, A.cols, nnz,
+           nnz / A.rows, threads, threads > 1 ? "s" : "");
+    printf("  ┌──────────────────────┬───────┬─────────┬──────────┬─────────┬────────┬────────┬─────────┐\n");
+    printf("  │ Format               │  fill │  I f/B  │  time ms │  GFLOPS │   GB/s │ %% roof │ max err │\n");
+    printf("  ├──────────────────────┼───────┼─────────┼──────────┼─────────┼────────┼────────┼─────────┤\n");
+    for (const result& r : res) {
+        double intensity = 2 * nnz / r.bytes, gflops = 2 * nnz / r.seconds / 1e9;
+        char roof[16] = "     -";
+        if (mp.loaded) {
+            double bw = threads > 1 ? mp.bw_dram_all : mp.bw_dram_1core;
+            snprintf(roof, sizeof(roof), "%5.0f%%", 100.0 * gflops / (intensity * bw));
+        }
+        printf("  │ %-20s │ %5.2f │ %7.3f │ %8.3f │ %7.2f │ %6.1f │ %s │ %7.0e │\n",
+               r.name.c_str(), r.fill, intensity, r.seconds * 1e3, gflops,
+               r.bytes / r.seconds / 1e9, roof, r.err);
+    }
+    printf("  └──────────────────────┴───────┴─────────┴──────────┴─────────┴────────┴────────┴─────────┘\n");
+}
+
+// m = {kind, args...}: a generator name or a .mtx path
+static bool make_matrix(const vector<const char*>& m, csr& A, string& title) {
+    string kind = m[0];
+    auto arg = [&](size_t k, long long fallback) {
+        return k < m.size() ? atoll(m[k]) : fallback;
+    };
+    // Sizes must be positive and nnz must fit the int indices
+    auto fits = [](long long nnz) { return nnz <= INT_MAX; };
+    long long g = arg(1, kind == "fem2d" ? 700 : 1000), n = arg(1, 1000000), k = arg(2, 16);
+    if (kind == "lap2d") {
+        if (g <= 0 || g > 65536 || !fits(5 * g * g)) return false;
+        gen_lap2d((int)g, A);
+    } else if (kind == "fem2d") {
+        if (g <= 0 || g > 65536 || !fits(20 * g * g)) return false;
+        gen_fem2d((int)g, A);
+    } else if (kind == "random") {
+        if (k <= 0 || k > n || n > INT_MAX || !fits(n * k)) return false;
+        gen_random((int)n, (int)k, A);
+    } else if (kind == "powerlaw") {
+        if (n < 8 || !fits(n)) return false;  // rows are capped at n/8 entries
+        gen_powerlaw((int)n, A);
+    } else if (kind.size() > 4 && kind.substr(kind.size() - 4) == ".mtx") {
+        if (!load_mtx(kind.c_str(), A)) return false;
+    } else {
+        return false;
+    }
+    title = kind;
+    for (size_t k = 1; k < m.size(); k++) title += string(" ") + m[k];
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool csv = argc >= 2 && strcmp(argv[1], "csv") == 0;
+    vector<vector<const char*>> suite = {
+        {"lap2d", "1000"}, {"fem2d", "700"}, {"random", "1000000", "16"}, {"powerlaw", "1000000"}};
+    if (argc >= 2 && !csv) suite.assign(1, vector<const char*>(argv + 1, argv + argc));
+
+    vector<int> cpus = cpu_order("compact");
+    thread_pool pool((int)cpus.size(), cpus);
+    machine_profile mp;
+    machine_profile_load(&mp);
+
+    for (auto& m : suite) {
+        csr A;
+        string title;
+        if (!make_matrix(m, A, title)) {
+            fprintf(stderr,
+                    "usage: %s [lap2d g | fem2d g | random n k | powerlaw n | file.mtx | csv]\n",
+                    argv[0]);
+            return 1;
+        }
+        if (!csv && &m == &suite[0]) {
+            printf("\n");
+            printf("╔═══════════════════════════════════════════════════════════════╗\n");
+            printf("║  SpMV y = A x: CSR vs SELL-C-sigma vs BCSR 2x2 (fp64, AVX2)   ║\n");
+            printf("╚═══════════════════════════════════════════════════════════════╝\n");
+            printf("fill: stored entries / nnz. I: 2 nnz / modeled bytes (matrix + indices\n");
+            printf("+ x once + y). %% roof: GFLOPS / (I x DRAM bandwidth).\n");
+        }
+        vector<result> res = bench(A, pool);
+        if (!csv) {
+            print_table(title.c_str(), A, res, mp, pool.n);
+            continue;
+        }
+        // One point per matrix for the AVX2 CSR, SELL-8 and BCSR kernels
+        for (const result& r : res)
+            if (!r.id.empty())
+                machine_profile_csv_row(stdout, &mp, r.id.c_str(), 1, A.rows, r.bytes,
+                                        2.0 * A.nnz(), r.bytes, r.seconds, "model");
+    }
+    if (!csv) {
+        printf("\nSELL pads each chunk to its longest row; sorting inside sigma-row\n");
+        printf("windows keeps fill near 1 without scattering y. BCSR 2x2 drops the\n");
+        printf("gathers and 3 of 4 indices but only pays off when blocks are dense.\n");
+        if (!mp.loaded) printf("(no %s: run `make profile` for the %% roof column)\n",
+                               MACHINE_PROFILE_FILE);
+    }
+    return 0;
+}
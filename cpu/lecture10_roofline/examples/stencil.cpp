@@ -11,6 +11,7 @@
 #include <iostream>
 #include <chrono>
 #include <cstdlib>
+#include "machine_profile.h"
 using namespace std;
 
 void stencil_2d(double* B, double* A, int n) {
@@ -49,6 +50,7 @@ int main() {
     cout << "  Performance: " << flops / seconds / 1e9 << " GFLOPS" << endl;
     cout << "  Bandwidth: " << bytes / seconds / 1e9 << " GB/s" << endl;
     cout << "  Operational Intensity: " << flops / bytes << " flops/byte" << endl;
+    machine_profile_report(flops, bytes, seconds, 1);
     cout << "  B[n/2][n/2] = " << B[(n/2) * n + n/2] << " (expected: 1.0)" << endl;
 
     free(A);
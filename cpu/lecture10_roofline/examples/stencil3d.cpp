@@ -0,0 +1,303 @@
+// stencil3d.cpp - Parallel AVX2 3D stencils (7-point and 27-point)
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread stencil3d.cpp -o stencil3d
+// Run: ./stencil3d [n] [steps] [threads]     (default 384 10 all cores)
+//
+// stencil.cpp is a scalar, single-threaded 2D sweep. At scale, 3D
+// stencils need every level of the hierarchy working together:
+//
+//   SIMD:      AVX2 along x (unit stride), 4 points per vector
+//   Blocking:  y is cut into BY-row blocks; a z sweep of one block keeps
+//              three planes of (BY + 2) rows in L2, so every input point
+//              comes from DRAM once instead of once per plane that uses it
+//   Threads:   z is split across a pinned pool (thread_pool.h)
+//   NUMA:      both grids are first-touched by the threads that sweep them
+//
+// Points are updated from the 1-deep halo of the previous timestep
+// (Jacobi ping-pong); the outer layer is a fixed Dirichlet boundary.
+//
+//   7-point:  out = c0 * center + c1 * (6 face neighbours)          8 flops
+//   27-point: out = c0 * center + c1 * faces + c2 * edges + c3 * corners
+//             (26 adds + 4 muls = 30 flops)
+//
+// Ideal traffic is one read and one write per point (16 bytes), so both
+// stencils are memory bound at I = 0.5 and 1.9 flops/byte and the target
+// is the machine's STREAM bandwidth. The program measures a triad with
+// the same pool and placement, and compares against it.
+
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "machine_profile.h"
+#include "thread_pool.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 7-point weights (sum to 1, stable for the heat equation)
+const double W7_C = 0.4, W7_F = 0.1;
+// 27-point weights by neighbour class: center, 6 faces, 12 edges, 8 corners
+const double W27_C = 0.2, W27_F = 0.06, W27_E = 0.02, W27_K = 0.025;
+
+struct grid {
+    int n;             // points per dimension, boundary included
+    size_t sy, sz;     // strides of y and z (x is unit stride)
+    double* data;
+    double* at(int x, int y, int z) const { return data + z * sz + y * sy + x; }
+};
+
+// ============================================================================
+// Scalar reference (not vectorized, not blocked)
+// ============================================================================
+__attribute__((optimize("no-tree-vectorize")))
+static void sweep7_scalar(const grid& in, grid& out, int z0, int z1) {
+    int n = in.n;
+    for (int z = z0; z < z1; z++)
+        for (int y = 1; y < n - 1; y++)
+            for (int x = 1; x < n - 1; x++) {
+                const double* p = in.at(x, y, z);
+                double faces = p[-1] + p[1] + p[-(long)in.sy] + p[in.sy] + p[-(long)in.sz] +
+                               p[in.sz];
+                *out.at(x, y, z) = W7_C * p[0] + W7_F * faces;
+            }
+}
+
+__attribute__((optimize("no-tree-vectorize")))
+static void sweep27_scalar(const grid& in, grid& out, int z0, int z1) {
+    int n = in.n;
+    const double w[4] = {W27_C, W27_F, W27_E, W27_K};
+    for (int z = z0; z < z1; z++)
+        for (int y = 1; y < n - 1; y++)
+            for (int x = 1; x < n - 1; x++) {
+                double sum[4] = {0, 0, 0, 0};
+                for (int dz = -1; dz <= 1; dz++)
+                    for (int dy = -1; dy <= 1; dy++)
+                        for (int dx = -1; dx <= 1; dx++)
+                            sum[(dx != 0) + (dy != 0) + (dz != 0)] += *in.at(x + dx, y + dy, z + dz);
+                *out.at(x, y, z) = w[0] * sum[0] + w[1] * sum[1] + w[2] * sum[2] + w[3] * sum[3];
+            }
+}
+
+// ============================================================================
+// AVX2 row kernels: x in [1, n-1) of one (y, z) row
+// ============================================================================
+
+static inline void row7_avx2(const double* p, double* o, int n, size_t sy, size_t sz) {
+    const __m256d wc = _mm256_set1_pd(W7_C), wf = _mm256_set1_pd(W7_F);
+    int x = 1;
+    for (; x + 4 <= n - 1; x += 4) {
+        __m256d f = _mm256_add_pd(_mm256_loadu_pd(p + x - 1), _mm256_loadu_pd(p + x + 1));
+        f = _mm256_add_pd(f, _mm256_add_pd(_mm256_loadu_pd(p + x - sy), _mm256_loadu_pd(p + x + sy)));
+        f = _mm256_add_pd(f, _mm256_add_pd(_mm256_loadu_pd(p + x - sz), _mm256_loadu_pd(p + x + sz)));
+        _mm256_storeu_pd(o + x, _mm256_fmadd_pd(wc, _mm256_loadu_pd(p + x), _mm256_mul_pd(wf, f)));
+    }
+    for (; x < n - 1; x++) {
+        double f = p[x - 1] + p[x + 1] + p[x - sy] + p[x + sy] + p[x - sz] + p[x + sz];
+        o[x] = W7_C * p[x] + W7_F * f;
+    }
+}
+
+// Each of the 9 (dy, dz) rows contributes its middle point to class k and
+// its left + right points to class k + 1, k = (dy != 0) + (dz != 0)
+static inline void row27_avx2(const double* p, double* o, int n, size_t sy, size_t sz) {
+    const __m256d w0 = _mm256_set1_pd(W27_C), w1 = _mm256_set1_pd(W27_F);
+    const __m256d w2 = _mm256_set1_pd(W27_E), w3 = _mm256_set1_pd(W27_K);
+    int x = 1;
+    for (; x + 4 <= n - 1; x += 4) {
+        __m256d s[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(),
+                        _mm256_setzero_pd()};
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dy = -1; dy <= 1; dy++) {
+                const double* r = p + dz * (long)sz + dy * (long)sy + x;
+                int k = (dy != 0) + (dz != 0);
+                s[k] = _mm256_add_pd(s[k], _mm256_loadu_pd(r));
+                s[k + 1] = _mm256_add_pd(s[k + 1],
+                                         _mm256_add_pd(_mm256_loadu_pd(r - 1), _mm256_loadu_pd(r + 1)));
+            }
+        __m256d v = _mm256_fmadd_pd(w3, s[3], _mm256_mul_pd(w2, s[2]));
+        v = _mm256_fmadd_pd(w1, s[1], v);
+        _mm256_storeu_pd(o + x, _mm256_fmadd_pd(w0, s[0], v));
+    }
+    for (; x < n - 1; x++) {
+        double s[4] = {0, 0, 0, 0};
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dy = -1; dy <= 1; dy++) {
+                const double* r = p + dz * (long)sz + dy * (long)sy + x;
+                int k = (dy != 0) + (dz != 0);
+                s[k] += r[0];
+                s[k + 1] += r[-1] + r[1];
+            }
+        o[x] = W27_K * s[3] + W27_E * s[2] + W27_F * s[1] + W27_C * s[0];
+    }
+}
+
+typedef void (*row_kernel)(const double*, double*, int, size_t, size_t);
+
+// Planes [z0, z1): y blocks of `by` rows, each swept through all its planes
+static void sweep_avx2(row_kernel row, const grid& in, grid& out, int z0, int z1, int by) {
+    int n = in.n;
+    for (int y0 = 1; y0 < n - 1; y0 += by) {
+        int y1 = min(y0 + by, n - 1);
+        for (int z = z0; z < z1; z++)
+            for (int y = y0; y < y1; y++)
+                row(in.at(0, y, z), out.at(0, y, z), n, in.sy, in.sz);
+    }
+}
+
+// ============================================================================
+// Driver
+// ============================================================================
+
+static grid make_grid(int n) {
+    grid g;
+    g.n = n;
+    g.sy = (size_t)((n + 3) & ~3);  // rows padded to a multiple of 4 doubles
+    g.sz = g.sy * n;
+    g.data = (double*)aligned_alloc(64, ((g.sz * n * sizeof(double) + 63) / 64) * 64);
+    if (!g.data) abort();
+    return g;
+}
+
+// Interior planes [1, n-1) split by thread; planes 0 and n-1 go with the edge threads
+static void planes(int n, int threads, int id, int* z0, int* z1) {
+    size_t lo, hi;
+    chunk((size_t)(n - 2), threads, id, &lo, &hi, 1);
+    *z0 = 1 + (int)lo;
+    *z1 = 1 + (int)hi;
+}
+
+// First touch: each thread writes the planes it will sweep (plus the
+// boundary planes next to its range), so the pages land on its node
+static void init_grids(thread_pool& pool, grid& a, grid& b) {
+    int n = a.n;
+    pool.run([&](int id) {
+        int z0, z1;
+        planes(n, pool.n, id, &z0, &z1);
+        if (z0 == 1) z0 = 0;
+        if (z1 == n - 1) z1 = n;
+        for (int z = z0; z < z1; z++)
+            for (int y = 0; y < n; y++)
+                for (int x = 0; x < (int)a.sy; x++) {
+                    bool boundary = x == 0 || y == 0 || z == 0 || x >= n - 1 || y == n - 1 ||
+                                    z == n - 1;
+                    double v = boundary ? 1.0 : sin(0.05 * x) * cos(0.03 * y) + 0.01 * z;
+                    *a.at(x, y, z) = *b.at(x, y, z) = v;
+                }
+    });
+}
+
+typedef void (*sweep_fn)(const grid&, grid&, int, int);
+
+struct variant {
+    const char* name;
+    int points;
+    double flops_per_point;
+    sweep_fn scalar;
+    row_kernel row;
+};
+
+// Seconds per sweep for `steps` Jacobi steps; by == 0 selects the scalar sweep
+static double run(thread_pool& pool, const variant& v, grid& a, grid& b, int steps, int by,
+                  grid** result) {
+    grid* in = &a;
+    grid* out = &b;
+    double t0 = now();
+    for (int s = 0; s < steps; s++) {
+        pool.run([&](int id) {
+            int z0, z1;
+            planes(in->n, pool.n, id, &z0, &z1);
+            if (by == 0) v.scalar(*in, *out, z0, z1);
+            else sweep_avx2(v.row, *in, *out, z0, z1, by);
+        });
+        swap(in, out);
+    }
+    *result = in;
+    return (now() - t0) / steps;
+}
+
+// Best-of-5 STREAM triad over the same grids and pool, GB/s (24 bytes/elem)
+static double triad_gbs(thread_pool& pool, grid& a, grid& b, grid& c) {
+    size_t total = a.sz * a.n;
+    double best = 0;
+    for (int r = 0; r < 5; r++) {
+        double t0 = now();
+        pool.run([&](int id) {
+            size_t lo, hi;
+            chunk(total, pool.n, id, &lo, &hi);
+            for (size_t i = lo; i < hi; i++) a.data[i] = b.data[i] + 3.0 * c.data[i];
+        });
+        best = max(best, 24.0 * total / (now() - t0) / 1e9);
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 384;
+    int steps = argc > 2 ? atoi(argv[2]) : 10;
+    vector<int> cpus = cpu_order("compact");
+    int threads = argc > 3 ? min(atoi(argv[3]), (int)cpus.size()) : (int)cpus.size();
+    const int BY = 16;
+
+    thread_pool pool(threads, cpus);
+    grid a = make_grid(n), b = make_grid(n), ref_a = make_grid(n), ref_b = make_grid(n);
+    double interior = (double)(n - 2) * (n - 2) * (n - 2);
+    double bytes = 16.0 * interior;  // ideal: read + write each point once
+
+    variant variants[] = {
+        {"7-point", 7, 8, sweep7_scalar, row7_avx2},
+        {"27-point", 27, 30, sweep27_scalar, row27_avx2},
+    };
+
+    printf("\n");
+    printf("╔═══════════════════════════════════════════════════════════════════╗\n");
+    printf("║  3D stencils: %4d^3 grid, %2d steps, %2d thread%s                   ║\n", n, steps,
+           threads, threads > 1 ? "s" : " ");
+    printf("╠═══════════════════════════════════════════════════════════════════╣\n");
+    printf("║ Stencil   Version            GFLOPS      GB/s   %%STREAM   Error   ║\n");
+    printf("╠═══════════════════════════════════════════════════════════════════╣\n");
+
+    init_grids(pool, a, b);
+    double stream = triad_gbs(pool, ref_a, a, b);  // ref_a is scratch until used below
+
+    for (const variant& v : variants) {
+        // Scalar reference result, also the baseline timing
+        init_grids(pool, ref_a, ref_b);
+        grid* ref = NULL;
+        double t_ref = run(pool, v, ref_a, ref_b, steps, 0, &ref);
+
+        struct { const char* name; int by; } versions[] = {{"AVX2", n}, {"AVX2 + y-blocking", BY}};
+        printf("║ %-9s %-17s %8.2f  %8.1f   %6.1f%%  %7s ║\n", v.name, "scalar",
+               v.flops_per_point * interior / t_ref / 1e9, bytes / t_ref / 1e9,
+               100.0 * bytes / t_ref / 1e9 / stream, "-");
+        for (auto& ver : versions) {
+            init_grids(pool, a, b);
+            grid* out = NULL;
+            double t = run(pool, v, a, b, steps, ver.by, &out);
+            double err = 0;
+            for (int z = 0; z < n; z++)
+                for (int y = 0; y < n; y++)
+                    for (int x = 0; x < n; x++)
+                        err = max(err, fabs(*out->at(x, y, z) - *ref->at(x, y, z)));
+            printf("║ %-9s %-17s %8.2f  %8.1f   %6.1f%%  %7.0e ║\n", "", ver.name,
+                   v.flops_per_point * interior / t / 1e9, bytes / t / 1e9,
+                   100.0 * bytes / t / 1e9 / stream, err);
+        }
+    }
+    printf("╚═══════════════════════════════════════════════════════════════════╝\n");
+    printf("STREAM triad (same threads, first-touch placement): %.1f GB/s\n", stream);
+    machine_profile mp;
+    if (machine_profile_load(&mp))
+        printf("characterize DRAM ceiling: %.1f GB/s (all cores)\n", mp.bw_dram_all);
+    printf("GB/s counts 16 bytes per interior point (one read, one write).\n");
+
+    free(a.data);
+    free(b.data);
+    free(ref_a.data);
+    free(ref_b.data);
+    return 0;
+}
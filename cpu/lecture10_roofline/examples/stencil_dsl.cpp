@@ -0,0 +1,286 @@
+// stencil_dsl.cpp - Stencil DSL instances vs hand-written kernels
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread stencil_dsl.cpp -o stencil_dsl
+// Run: ./stencil_dsl [n2d] [n3d] [steps]     (default 4096 256 4)
+//
+// Each stencil below is only a tap table (stencil_dsl.h expands it). For
+// every instance the same threaded, y-blocked sweep runs with:
+//
+//   scalar      the table read at run time (reference result)
+//   hand AVX2   hand-written intrinsics, where the lectures have one
+//   DSL loads   generated kernel, one unaligned load per tap
+//   DSL window  generated kernel, register reuse along x
+//
+// Instances: 2D 5-point, 2D 9-point box, 2D 17-point radius-4 star (8th
+// order Laplacian), 3D 7-point, 3D 13-point radius-2 star (4th order),
+// 3D 27-point box. All are explicit heat-equation steps whose weights
+// sum to 1, so repeated sweeps stay bounded.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "machine_profile.h"
+#include "stencil_dsl.h"
+#include "thread_pool.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ============================================================================
+// Stencil descriptions
+// ============================================================================
+constexpr double NU = 0.1;  // diffusion number of the heat steps
+
+// 2nd-order (5-point) and box 9-point, 2D
+struct star5_2d {
+    static constexpr int dims = 2, ntaps = 5;
+    static constexpr tap taps[ntaps] = {
+        {0, 0, 0, 1 - 4 * NU},
+        {-1, 0, 0, NU}, {1, 0, 0, NU}, {0, -1, 0, NU}, {0, 1, 0, NU}};
+};
+struct box9_2d {
+    static constexpr int dims = 2, ntaps = 9;
+    static constexpr tap taps[ntaps] = {
+        {-1, -1, 0, 0.025}, {0, -1, 0, 0.1}, {1, -1, 0, 0.025},
+        {-1,  0, 0, 0.1},   {0,  0, 0, 0.5}, {1,  0, 0, 0.1},
+        {-1,  1, 0, 0.025}, {0,  1, 0, 0.1}, {1,  1, 0, 0.025}};
+};
+
+// 8th-order second derivative: -1/560 8/315 -1/5 8/5 [-205/72] ...
+constexpr double D8[5] = {-205.0 / 72, 8.0 / 5, -1.0 / 5, 8.0 / 315, -1.0 / 560};
+constexpr double NU8 = 0.05;
+struct star17_2d {
+    static constexpr int dims = 2, ntaps = 17;
+    static constexpr tap taps[ntaps] = {
+        {0, 0, 0, 1 + 2 * NU8 * D8[0]},
+        {-1, 0, 0, NU8 * D8[1]}, {1, 0, 0, NU8 * D8[1]}, {0, -1, 0, NU8 * D8[1]}, {0, 1, 0, NU8 * D8[1]},
+        {-2, 0, 0, NU8 * D8[2]}, {2, 0, 0, NU8 * D8[2]}, {0, -2, 0, NU8 * D8[2]}, {0, 2, 0, NU8 * D8[2]},
+        {-3, 0, 0, NU8 * D8[3]}, {3, 0, 0, NU8 * D8[3]}, {0, -3, 0, NU8 * D8[3]}, {0, 3, 0, NU8 * D8[3]},
+        {-4, 0, 0, NU8 * D8[4]}, {4, 0, 0, NU8 * D8[4]}, {0, -4, 0, NU8 * D8[4]}, {0, 4, 0, NU8 * D8[4]}};
+};
+
+struct star7_3d {
+    static constexpr int dims = 3, ntaps = 7;
+    static constexpr tap taps[ntaps] = {
+        {0, 0, 0, 1 - 6 * NU},
+        {-1, 0, 0, NU}, {1, 0, 0, NU}, {0, -1, 0, NU}, {0, 1, 0, NU}, {0, 0, -1, NU}, {0, 0, 1, NU}};
+};
+
+// 4th-order second derivative: -1/12 4/3 [-5/2] 4/3 -1/12
+constexpr double NU4 = 0.05;
+struct star13_3d {
+    static constexpr int dims = 3, ntaps = 13;
+    static constexpr tap taps[ntaps] = {
+        {0, 0, 0, 1 - 3 * NU4 * 2.5},
+        {-1, 0, 0, NU4 * 4 / 3}, {1, 0, 0, NU4 * 4 / 3}, {0, -1, 0, NU4 * 4 / 3},
+        {0, 1, 0, NU4 * 4 / 3},  {0, 0, -1, NU4 * 4 / 3}, {0, 0, 1, NU4 * 4 / 3},
+        {-2, 0, 0, -NU4 / 12}, {2, 0, 0, -NU4 / 12}, {0, -2, 0, -NU4 / 12},
+        {0, 2, 0, -NU4 / 12},  {0, 0, -2, -NU4 / 12}, {0, 0, 2, -NU4 / 12}};
+};
+
+// 27-point box: center 0.2, faces 0.06, edges 0.02, corners 0.025 (as stencil3d.cpp)
+#define B27_ROW(dy, dz, side, mid) \
+    {-1, dy, dz, side}, {0, dy, dz, mid}, {1, dy, dz, side}
+struct box27_3d {
+    static constexpr int dims = 3, ntaps = 27;
+    static constexpr tap taps[ntaps] = {
+        B27_ROW(-1, -1, 0.025, 0.02), B27_ROW(0, -1, 0.02, 0.06), B27_ROW(1, -1, 0.025, 0.02),
+        B27_ROW(-1,  0, 0.02,  0.06), B27_ROW(0,  0, 0.06, 0.2),  B27_ROW(1,  0, 0.02,  0.06),
+        B27_ROW(-1,  1, 0.025, 0.02), B27_ROW(0,  1, 0.02, 0.06), B27_ROW(1,  1, 0.025, 0.02)};
+};
+#undef B27_ROW
+
+constexpr tap star5_2d::taps[];
+constexpr tap box9_2d::taps[];
+constexpr tap star17_2d::taps[];
+constexpr tap star7_3d::taps[];
+constexpr tap star13_3d::taps[];
+constexpr tap box27_3d::taps[];
+
+// ============================================================================
+// Hand-written kernels (same signature as dsl_row)
+// ============================================================================
+
+static void hand5_2d(const double* p, double* o, int nx, size_t sy, size_t) {
+    const __m256d wc = _mm256_set1_pd(1 - 4 * NU), wf = _mm256_set1_pd(NU);
+    for (int x = 0; x < nx; x += 4) {
+        __m256d f = _mm256_add_pd(_mm256_loadu_pd(p + x - 1), _mm256_loadu_pd(p + x + 1));
+        f = _mm256_add_pd(f, _mm256_add_pd(_mm256_load_pd(p + x - sy), _mm256_load_pd(p + x + sy)));
+        _mm256_store_pd(o + x, _mm256_fmadd_pd(wc, _mm256_load_pd(p + x), _mm256_mul_pd(wf, f)));
+    }
+}
+
+static void hand9_2d(const double* p, double* o, int nx, size_t sy, size_t) {
+    const __m256d wc = _mm256_set1_pd(0.5), wf = _mm256_set1_pd(0.1), wk = _mm256_set1_pd(0.025);
+    const double* u = p - sy;
+    const double* d = p + sy;
+    for (int x = 0; x < nx; x += 4) {
+        __m256d faces = _mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(p + x - 1), _mm256_loadu_pd(p + x + 1)),
+                                      _mm256_add_pd(_mm256_load_pd(u + x), _mm256_load_pd(d + x)));
+        __m256d corners = _mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(u + x - 1), _mm256_loadu_pd(u + x + 1)),
+                                        _mm256_add_pd(_mm256_loadu_pd(d + x - 1), _mm256_loadu_pd(d + x + 1)));
+        __m256d v = _mm256_fmadd_pd(wf, faces, _mm256_mul_pd(wk, corners));
+        _mm256_store_pd(o + x, _mm256_fmadd_pd(wc, _mm256_load_pd(p + x), v));
+    }
+}
+
+static void hand7_3d(const double* p, double* o, int nx, size_t sy, size_t sz) {
+    const __m256d wc = _mm256_set1_pd(1 - 6 * NU), wf = _mm256_set1_pd(NU);
+    for (int x = 0; x < nx; x += 4) {
+        __m256d f = _mm256_add_pd(_mm256_loadu_pd(p + x - 1), _mm256_loadu_pd(p + x + 1));
+        f = _mm256_add_pd(f, _mm256_add_pd(_mm256_load_pd(p + x - sy), _mm256_load_pd(p + x + sy)));
+        f = _mm256_add_pd(f, _mm256_add_pd(_mm256_load_pd(p + x - sz), _mm256_load_pd(p + x + sz)));
+        _mm256_store_pd(o + x, _mm256_fmadd_pd(wc, _mm256_load_pd(p + x), _mm256_mul_pd(wf, f)));
+    }
+}
+
+// Class sums as in stencil3d.cpp's row27_avx2
+static void hand27_3d(const double* p, double* o, int nx, size_t sy, size_t sz) {
+    const __m256d w0 = _mm256_set1_pd(0.2), w1 = _mm256_set1_pd(0.06);
+    const __m256d w2 = _mm256_set1_pd(0.02), w3 = _mm256_set1_pd(0.025);
+    for (int x = 0; x < nx; x += 4) {
+        __m256d s[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(),
+                        _mm256_setzero_pd()};
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dy = -1; dy <= 1; dy++) {
+                const double* r = p + dz * (long)sz + dy * (long)sy + x;
+                int k = (dy != 0) + (dz != 0);
+                s[k] = _mm256_add_pd(s[k], _mm256_load_pd(r));
+                s[k + 1] = _mm256_add_pd(s[k + 1],
+                                         _mm256_add_pd(_mm256_loadu_pd(r - 1), _mm256_loadu_pd(r + 1)));
+            }
+        __m256d v = _mm256_fmadd_pd(w3, s[3], _mm256_mul_pd(w2, s[2]));
+        v = _mm256_fmadd_pd(w1, s[1], v);
+        _mm256_store_pd(o + x, _mm256_fmadd_pd(w0, s[0], v));
+    }
+}
+
+// ============================================================================
+// Benchmark driver
+// ============================================================================
+typedef void (*row_fn)(const double*, double*, int, size_t, size_t);
+
+struct bench_env {
+    thread_pool* pool;
+    int steps;
+    int by;  // y block (3D); 2D sweeps are not y-blocked
+};
+
+// Interior pattern + constant-1 halo, first-touched by the sweeping threads
+static void init_field(bench_env& env, field& f) {
+    int outer = f.nz > 1 ? f.nz : f.ny;
+    env.pool->run([&](int id) {
+        size_t lo, hi;
+        chunk((size_t)outer, env.pool->n, id, &lo, &hi, 1);
+        int z0 = f.nz > 1 ? (int)lo - f.hz : 0, z1 = f.nz > 1 ? (int)hi + f.hz : 1;
+        int y0 = f.nz > 1 ? -DSL_HALO : (int)lo - DSL_HALO;
+        int y1 = f.nz > 1 ? f.ny + DSL_HALO : (int)hi + DSL_HALO;
+        for (int z = max(z0, -f.hz); z < min(z1, f.nz + f.hz); z++)
+            for (int y = max(y0, -DSL_HALO); y < min(y1, f.ny + DSL_HALO); y++)
+                for (int x = -DSL_HALO; x < f.nx + DSL_HALO; x++) {
+                    bool halo = x < 0 || y < 0 || z < 0 || x >= f.nx || y >= f.ny || z >= f.nz;
+                    *f.at(x, y, z) = halo ? 1.0 : sin(0.05 * x) * cos(0.03 * y) + 0.01 * z;
+                }
+    });
+}
+
+// Seconds per sweep; the final field is left in *result
+template <class Sweep>
+static double time_sweeps(bench_env& env, field& a, field& b, Sweep sweep, field** result) {
+    init_field(env, a);
+    init_field(env, b);
+    field* in = &a;
+    field* out = &b;
+    int outer = a.nz > 1 ? a.nz : a.ny;
+    double t0 = now();
+    for (int s = 0; s < env.steps; s++) {
+        env.pool->run([&](int id) {
+            size_t lo, hi;
+            chunk((size_t)outer, env.pool->n, id, &lo, &hi, 1);
+            if (a.nz > 1) sweep(*in, *out, 0, a.ny, (int)lo, (int)hi);
+            else sweep(*in, *out, (int)lo, (int)hi, 0, 1);
+        });
+        swap(in, out);
+    }
+    *result = in;
+    return (now() - t0) / env.steps;
+}
+
+static double max_diff(const field& a, const field& b) {
+    double d = 0;
+    for (int z = 0; z < a.nz; z++)
+        for (int y = 0; y < a.ny; y++)
+            for (int x = 0; x < a.nx; x++) d = max(d, fabs(*a.at(x, y, z) - *b.at(x, y, z)));
+    return d;
+}
+
+template <class S>
+static void bench(bench_env& env, const char* name, int n, row_fn hand) {
+    int nz = S::dims == 3 ? n : 1;
+    field a = make_field(n, n, nz), b = make_field(n, n, nz);
+    field ra = make_field(n, n, nz), rb = make_field(n, n, nz);
+    double points = (double)n * n * nz;
+    double flops = 2.0 * S::ntaps * points;
+    int by = S::dims == 3 ? env.by : n;
+
+    field* ref = NULL;
+    double t = time_sweeps(env, ra, rb, [&](const field& in, field& out, int y0, int y1, int z0, int z1) {
+        dsl_sweep_scalar<S>(in, out, y0, y1, z0, z1);
+    }, &ref);
+    printf("║ %-17s %2d  %-12s %8.2f  %8.1f  %7s ║\n", name, S::ntaps, "scalar",
+           flops / t / 1e9, 16.0 * points / t / 1e9, "-");
+
+    struct { const char* label; row_fn row; } versions[] = {
+        {"hand AVX2", hand},
+        {"DSL loads", dsl_row<S, ROW_LOADS>},
+        {"DSL window", dsl_row<S, ROW_WINDOW>},
+    };
+    for (auto& v : versions) {
+        if (!v.row) continue;
+        field* out = NULL;
+        t = time_sweeps(env, a, b, [&](const field& in, field& o, int y0, int y1, int z0, int z1) {
+            blocked_sweep(v.row, in, o, y0, y1, z0, z1, by);
+        }, &out);
+        printf("║ %-17s     %-12s %8.2f  %8.1f  %7.0e ║\n", "", v.label, flops / t / 1e9,
+               16.0 * points / t / 1e9, max_diff(*out, *ref));
+    }
+    free(a.data);
+    free(b.data);
+    free(ra.data);
+    free(rb.data);
+}
+
+int main(int argc, char** argv) {
+    int n2 = argc > 1 ? atoi(argv[1]) : 4096;
+    int n3 = argc > 2 ? atoi(argv[2]) : 256;
+    int steps = argc > 3 ? atoi(argv[3]) : 4;
+    n2 = max(4, n2 / 4 * 4);
+    n3 = max(4, n3 / 4 * 4);
+
+    vector<int> cpus = cpu_order("compact");
+    thread_pool pool((int)cpus.size(), cpus);
+    bench_env env = {&pool, steps, 16};
+
+    printf("\n");
+    printf("╔════════════════════════════════════════════════════════════════╗\n");
+    printf("║  Stencil DSL: 2D %5d^2, 3D %4d^3, %d steps, %2d thread%s       ║\n", n2, n3,
+           steps, pool.n, pool.n > 1 ? "s" : " ");
+    printf("╠════════════════════════════════════════════════════════════════╣\n");
+    printf("║ Stencil         Taps  Version        GFLOPS      GB/s   Error  ║\n");
+    printf("╠════════════════════════════════════════════════════════════════╣\n");
+    bench<star5_2d>(env, "2D 5-point", n2, hand5_2d);
+    bench<box9_2d>(env, "2D 9-point box", n2, hand9_2d);
+    bench<star17_2d>(env, "2D r=4 star", n2, NULL);
+    bench<star7_3d>(env, "3D 7-point", n3, hand7_3d);
+    bench<star13_3d>(env, "3D r=2 star", n3, NULL);
+    bench<box27_3d>(env, "3D 27-point box", n3, hand27_3d);
+    printf("╚════════════════════════════════════════════════════════════════╝\n");
+    printf("GFLOPS: 2 per tap per point; GB/s: 16 bytes per point (read + write).\n");
+    machine_profile mp;
+    if (machine_profile_load(&mp))
+        printf("characterize DRAM ceiling: %.1f GB/s (all cores)\n", mp.bw_dram_all);
+    return 0;
+}
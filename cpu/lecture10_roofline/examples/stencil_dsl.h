@@ -0,0 +1,270 @@
+// stencil_dsl.h - Compile-time stencil descriptions -> unrolled AVX2 kernels
+//
+// A stencil is a struct with a constexpr table of taps (offset +
+// coefficient). dsl_row<S> expands the table at compile time, one FMA
+// per tap with the coefficient as an immediate broadcast, so a new
+// stencil is a table instead of another hand-written loop:
+//
+//   struct star5 {
+//       static constexpr int dims = 2, ntaps = 5;
+//       static constexpr tap taps[ntaps] = {
+//           {0, 0, 0, 0.6}, {-1, 0, 0, 0.1}, {1, 0, 0, 0.1}, {0, -1, 0, 0.1}, {0, 1, 0, 0.1}};
+//   };
+//   constexpr tap star5::taps[];
+//
+//   dsl_sweep<star5, ROW_WINDOW>(in, out, y0, y1, z0, z1, by);
+//
+// Two ways to fetch the taps of one row (dy, dz) of the stencil:
+//   ROW_LOADS   one unaligned load per tap
+//   ROW_WINDOW  register reuse along x: a row with x taps (dx != 0) keeps
+//               an aligned window prev|cur|next of 3 vectors, loads only
+//               `next` per step and builds the x-shifted vectors with
+//               lane shuffles; a row whose only tap is dx = 0 (the arms
+//               of a star) is one aligned load, no window
+// The window trades loads for shuffles (port 5) and needs 3 registers
+// per windowed row, so only the first DSL_WINDOW_ROWS shifted rows get
+// one; further rows (6 of the 27-point box's 9) fall back to a load per
+// tap instead of spilling. Stars have a single shifted row and gain the
+// most; boxes end up close to ROW_LOADS. The benchmark
+// (stencil_dsl.cpp) reports both.
+//
+// Fields carry a 4-point halo on every stencil axis (so |offset| <= 4)
+// and interior rows start 32-byte aligned, which the window needs.
+
+#ifndef STENCIL_DSL_H
+#define STENCIL_DSL_H
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstdlib>
+#include <type_traits>
+
+struct tap {
+    int dx, dy, dz;
+    double c;
+};
+
+const int DSL_HALO = 4;
+const int DSL_WINDOW_ROWS = 3;  // 3 x 3 window registers, the rest for taps and acc
+
+enum row_mode { ROW_LOADS, ROW_WINDOW };
+
+// ============================================================================
+// Fields
+// ============================================================================
+struct field {
+    int nx, ny, nz;   // interior points (nx a multiple of 4)
+    int hz;           // z halo: DSL_HALO in 3D, 0 in 2D
+    size_t sy, sz;    // strides of y and z
+    double* data;
+
+    // Interior coordinates; halo cells are at negative / >= n indices
+    double* at(int x, int y, int z) const {
+        return data + (size_t)(z + hz) * sz + (size_t)(y + DSL_HALO) * sy + (x + DSL_HALO);
+    }
+};
+
+static inline field make_field(int nx, int ny, int nz) {
+    if (nx % 4 != 0) abort();
+    field f;
+    f.nx = nx;
+    f.ny = ny;
+    f.nz = nz;
+    f.hz = nz > 1 ? DSL_HALO : 0;
+    f.sy = (size_t)nx + 2 * DSL_HALO;
+    f.sz = f.sy * (ny + 2 * DSL_HALO);
+    size_t bytes = f.sz * (nz + 2 * f.hz) * sizeof(double);
+    f.data = (double*)aligned_alloc(64, (bytes + 63) / 64 * 64);
+    if (!f.data) abort();
+    return f;
+}
+
+// ============================================================================
+// Compile-time expansion helpers
+// ============================================================================
+
+// unroll<0, N>::run(f) calls f(integral_constant<int, 0>) ... f(<N-1>)
+template <int I, int N>
+struct unroll {
+    template <class F>
+    static inline __attribute__((always_inline)) void run(F&& f) {
+        f(std::integral_constant<int, I>());
+        unroll<I + 1, N>::run(f);
+    }
+};
+template <int N>
+struct unroll<N, N> {
+    template <class F>
+    static inline __attribute__((always_inline)) void run(F&&) {}
+};
+
+// Index of tap t's row (dy, dz) among the stencil's distinct rows
+template <class S>
+constexpr int row_of(int t) {
+    int rows = 0;
+    for (int i = 0; i < t; i++) {
+        bool first = true;
+        for (int j = 0; j < i; j++)
+            if (S::taps[j].dy == S::taps[i].dy && S::taps[j].dz == S::taps[i].dz) first = false;
+        if (first) rows++;
+    }
+    for (int j = 0; j < t; j++)
+        if (S::taps[j].dy == S::taps[t].dy && S::taps[j].dz == S::taps[t].dz) return row_of<S>(j);
+    return rows;
+}
+
+template <class S>
+constexpr int row_count() {
+    int rows = 0;
+    for (int t = 0; t < S::ntaps; t++)
+        if (row_of<S>(t) == rows) rows++;
+    return rows;
+}
+
+// Does row r have a tap with dx != 0 (and so want a window)?
+template <class S>
+constexpr bool row_shifted(int r) {
+    for (int t = 0; t < S::ntaps; t++)
+        if (row_of<S>(t) == r && S::taps[t].dx != 0) return true;
+    return false;
+}
+
+// Index of row r among the shifted rows
+template <class S>
+constexpr int window_of(int r) {
+    int w = 0;
+    for (int i = 0; i < r; i++) w += row_shifted<S>(i);
+    return w;
+}
+
+// Row r gets a window: shifted, and among the first DSL_WINDOW_ROWS
+template <class S>
+constexpr bool row_windowed(int r) {
+    return row_shifted<S>(r) && window_of<S>(r) < DSL_WINDOW_ROWS;
+}
+
+template <class S>
+constexpr bool offsets_fit() {
+    for (int t = 0; t < S::ntaps; t++)
+        if (S::taps[t].dx < -DSL_HALO || S::taps[t].dx > DSL_HALO || S::taps[t].dy < -DSL_HALO ||
+            S::taps[t].dy > DSL_HALO || S::taps[t].dz < -DSL_HALO || S::taps[t].dz > DSL_HALO ||
+            (S::dims == 2 && S::taps[t].dz != 0))
+            return false;
+    return true;
+}
+
+// Points x+D .. x+D+3, from the aligned window prev|cur|next at x
+template <int D> static inline __m256d window_at(__m256d p, __m256d c, __m256d n);
+template <> inline __m256d window_at<0>(__m256d, __m256d c, __m256d) { return c; }
+template <> inline __m256d window_at<1>(__m256d, __m256d c, __m256d n) {
+    return _mm256_shuffle_pd(c, _mm256_permute2f128_pd(c, n, 0x21), 0x5);
+}
+template <> inline __m256d window_at<2>(__m256d, __m256d c, __m256d n) {
+    return _mm256_permute2f128_pd(c, n, 0x21);
+}
+template <> inline __m256d window_at<3>(__m256d, __m256d c, __m256d n) {
+    return _mm256_shuffle_pd(_mm256_permute2f128_pd(c, n, 0x21), n, 0x5);
+}
+template <> inline __m256d window_at<4>(__m256d, __m256d, __m256d n) { return n; }
+template <> inline __m256d window_at<-1>(__m256d p, __m256d c, __m256d) {
+    return window_at<3>(p, p, c);
+}
+template <> inline __m256d window_at<-2>(__m256d p, __m256d c, __m256d) {
+    return window_at<2>(p, p, c);
+}
+template <> inline __m256d window_at<-3>(__m256d p, __m256d c, __m256d) {
+    return window_at<1>(p, p, c);
+}
+template <> inline __m256d window_at<-4>(__m256d p, __m256d, __m256d) { return p; }
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+// One interior row of `out`: `in` and `out` point at interior x = 0
+template <class S, row_mode M>
+static inline void dsl_row(const double* in, double* out, int nx, size_t sy, size_t sz) {
+    static_assert(offsets_fit<S>(), "tap offsets must be within DSL_HALO (and dz == 0 in 2D)");
+    constexpr int R = row_count<S>();
+    const double* rows[R];
+    unroll<0, S::ntaps>::run([&](auto t) {
+        constexpr tap k = S::taps[decltype(t)::value];
+        rows[row_of<S>(decltype(t)::value)] = in + k.dy * (long)sy + k.dz * (long)sz;
+    });
+
+    if (M == ROW_LOADS) {
+        for (int x = 0; x < nx; x += 4) {
+            __m256d acc = _mm256_setzero_pd();
+            unroll<0, S::ntaps>::run([&](auto t) {
+                constexpr tap k = S::taps[decltype(t)::value];
+                const double* r = rows[row_of<S>(decltype(t)::value)];
+                acc = _mm256_fmadd_pd(_mm256_set1_pd(k.c), _mm256_loadu_pd(r + x + k.dx), acc);
+            });
+            _mm256_store_pd(out + x, acc);
+        }
+    } else {
+        constexpr int WR = std::min(window_of<S>(R), DSL_WINDOW_ROWS);  // rows with a window
+        const double* wrows[WR > 0 ? WR : 1];
+        unroll<0, R>::run([&](auto r) {
+            if (row_windowed<S>(decltype(r)::value))
+                wrows[window_of<S>(decltype(r)::value)] = rows[decltype(r)::value];
+        });
+        __m256d prev[WR > 0 ? WR : 1], cur[WR > 0 ? WR : 1], next[WR > 0 ? WR : 1];
+        for (int w = 0; w < WR; w++) {
+            prev[w] = _mm256_load_pd(wrows[w] - 4);
+            cur[w] = _mm256_load_pd(wrows[w]);
+        }
+        for (int x = 0; x < nx; x += 4) {
+            for (int w = 0; w < WR; w++) next[w] = _mm256_load_pd(wrows[w] + x + 4);
+            __m256d acc = _mm256_setzero_pd();
+            unroll<0, S::ntaps>::run([&](auto t) {
+                constexpr tap k = S::taps[decltype(t)::value];
+                constexpr int r = row_of<S>(decltype(t)::value);
+                constexpr int w = row_windowed<S>(r) ? window_of<S>(r) : 0;
+                __m256d v = row_windowed<S>(r) ? window_at<k.dx>(prev[w], cur[w], next[w])
+                                               : _mm256_loadu_pd(rows[r] + x + k.dx);
+                acc = _mm256_fmadd_pd(_mm256_set1_pd(k.c), v, acc);
+            });
+            _mm256_store_pd(out + x, acc);
+            for (int w = 0; w < WR; w++) {
+                prev[w] = cur[w];
+                cur[w] = next[w];
+            }
+        }
+    }
+}
+
+// Rows [y0, y1) x planes [z0, z1), swept in y blocks of `by` rows so the
+// planes a block reads stay cache resident across its z sweep. `row` is
+// any kernel with dsl_row's signature (hand-written ones included).
+template <class Row>
+static void blocked_sweep(Row row, const field& in, field& out, int y0, int y1, int z0, int z1,
+                          int by) {
+    for (int yb = y0; yb < y1; yb += by) {
+        int ye = yb + by < y1 ? yb + by : y1;
+        for (int z = z0; z < z1; z++)
+            for (int y = yb; y < ye; y++) row(in.at(0, y, z), out.at(0, y, z), in.nx, in.sy, in.sz);
+    }
+}
+
+template <class S, row_mode M>
+static void dsl_sweep(const field& in, field& out, int y0, int y1, int z0, int z1, int by) {
+    blocked_sweep(dsl_row<S, M>, in, out, y0, y1, z0, z1, by);
+}
+
+// Table-driven scalar sweep (reads the same description at run time)
+template <class S>
+__attribute__((optimize("no-tree-vectorize")))
+static void dsl_sweep_scalar(const field& in, field& out, int y0, int y1, int z0, int z1) {
+    for (int z = z0; z < z1; z++)
+        for (int y = y0; y < y1; y++)
+            for (int x = 0; x < in.nx; x++) {
+                double acc = 0;
+                for (int t = 0; t < S::ntaps; t++)
+                    acc += S::taps[t].c * *in.at(x + S::taps[t].dx, y + S::taps[t].dy,
+                                                 z + S::taps[t].dz);
+                *out.at(x, y, z) = acc;
+            }
+}
+
+#endif // STENCIL_DSL_H
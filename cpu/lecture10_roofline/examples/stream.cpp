@@ -0,0 +1,307 @@
+// stream.cpp - Multithreaded STREAM-class bandwidth suite
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread stream.cpp -o stream
+// Run: ./stream [--n ELEMS] [--threads 1,2,4|max] [--pin compact|spread|none]
+//               [--numa local|master|interleave] [--ntimes K]
+//
+// daxpy.cpp and dot.cpp stream 100M elements on one core, which measures
+// one core's bandwidth. A socket needs several cores in flight to
+// saturate its memory controllers, so this suite sweeps the thread count:
+//
+//   copy   c = a              16 bytes/elem   scale  b = q*c          16
+//   add    c = a + b          24              triad  a = b + q*c      24
+//   dot    s += a*b           16              daxpy  b = q*a + b      24
+//
+// Bytes follow STREAM's convention (no write-allocate). With regular
+// stores each written line is first read (RFO), so the real traffic is
+// higher; the non-temporal (NT) variants bypass the cache and avoid it,
+// which is why they usually report more GB/s. dot has no stores.
+//
+// Each array is 4x the L3 size when RAM allows (STREAM's rule). Threads
+// are pinned (compact: CPUs in order; spread: round-robin over sockets),
+// and pages are placed by first touch in the owning thread (local), by
+// the main thread (master: everything on one node), or interleaved over
+// all nodes with mbind(), on fresh arrays for every thread count.
+// Reported: best of --ntimes trials, per kernel.
+
+#include <immintrin.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "machine_profile.h"
+#include "thread_pool.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const double q = 3.0;
+static volatile double dot_sink;  // keeps the dot reduction live
+
+// ============================================================================
+// Kernels: regular stores (auto-vectorized) and non-temporal AVX stores
+// ============================================================================
+// [lo, hi) is the calling thread's chunk; lo is a multiple of 8 so the NT
+// versions start 64-byte aligned and only the last chunk has a tail.
+
+static void copy(double* c, const double* a, size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; i++) c[i] = a[i];
+}
+static void scale(double* b, const double* c, size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; i++) b[i] = q * c[i];
+}
+static void add(double* c, const double* a, const double* b, size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; i++) c[i] = a[i] + b[i];
+}
+static void triad(double* a, const double* b, const double* c, size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; i++) a[i] = b[i] + q * c[i];
+}
+static double dot(const double* a, const double* b, size_t lo, size_t hi) {
+    double s = 0.0;
+    for (size_t i = lo; i < hi; i++) s += a[i] * b[i];
+    return s;
+}
+static void daxpy(double* b, const double* a, size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; i++) b[i] = q * a[i] + b[i];
+}
+
+static void copy_nt(double* c, const double* a, size_t lo, size_t hi) {
+    size_t i = lo;
+    for (; i + 4 <= hi; i += 4) _mm256_stream_pd(c + i, _mm256_load_pd(a + i));
+    for (; i < hi; i++) c[i] = a[i];
+    _mm_sfence();
+}
+static void scale_nt(double* b, const double* c, size_t lo, size_t hi) {
+    __m256d vq = _mm256_set1_pd(q);
+    size_t i = lo;
+    for (; i + 4 <= hi; i += 4) _mm256_stream_pd(b + i, _mm256_mul_pd(vq, _mm256_load_pd(c + i)));
+    for (; i < hi; i++) b[i] = q * c[i];
+    _mm_sfence();
+}
+static void add_nt(double* c, const double* a, const double* b, size_t lo, size_t hi) {
+    size_t i = lo;
+    for (; i + 4 <= hi; i += 4)
+        _mm256_stream_pd(c + i, _mm256_add_pd(_mm256_load_pd(a + i), _mm256_load_pd(b + i)));
+    for (; i < hi; i++) c[i] = a[i] + b[i];
+    _mm_sfence();
+}
+static void triad_nt(double* a, const double* b, const double* c, size_t lo, size_t hi) {
+    __m256d vq = _mm256_set1_pd(q);
+    size_t i = lo;
+    for (; i + 4 <= hi; i += 4)
+        _mm256_stream_pd(a + i, _mm256_fmadd_pd(vq, _mm256_load_pd(c + i), _mm256_load_pd(b + i)));
+    for (; i < hi; i++) a[i] = b[i] + q * c[i];
+    _mm_sfence();
+}
+static void daxpy_nt(double* b, const double* a, size_t lo, size_t hi) {
+    __m256d vq = _mm256_set1_pd(q);
+    size_t i = lo;
+    for (; i + 4 <= hi; i += 4)
+        _mm256_stream_pd(b + i, _mm256_fmadd_pd(vq, _mm256_load_pd(a + i), _mm256_load_pd(b + i)));
+    for (; i < hi; i++) b[i] = q * a[i] + b[i];
+    _mm_sfence();
+}
+
+// ============================================================================
+// NUMA placement
+// ============================================================================
+
+static int numa_nodes() {
+    int nodes = 0;
+    while (access(("/sys/devices/system/node/node" + to_string(nodes)).c_str(), F_OK) == 0) nodes++;
+    return nodes > 0 ? nodes : 1;
+}
+
+static size_t array_bytes(size_t n) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return ((n * sizeof(double) + page - 1) / page) * page;
+}
+
+// Fresh, untouched pages straight from mmap (malloc may hand back pages it
+// already placed); with interleave, pages go round-robin over all nodes
+static double* alloc_array(size_t n, bool interleave) {
+    size_t bytes = array_bytes(n);
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) abort();
+    if (interleave) {
+        unsigned long mask = ~0UL;  // the kernel drops nodes that are not online
+        if (syscall(SYS_mbind, p, bytes, MPOL_INTERLEAVE, &mask, 8 * sizeof(mask), 0) != 0)
+            perror("mbind(MPOL_INTERLEAVE)");
+    }
+    return (double*)p;
+}
+
+static void free_array(double* p, size_t n) { munmap(p, array_bytes(n)); }
+
+// ============================================================================
+// Main
+// ============================================================================
+
+struct kernel_def {
+    const char* name;
+    double bytes_per_elem;
+    // (thread id, lo, hi); nt empty: no stores, a reduction into partial[id]
+    function<void(int, size_t, size_t)> regular, nt;
+};
+
+static vector<int> parse_threads(const string& s, int max_threads) {
+    vector<int> list;
+    if (s.empty() || s == "sweep") {
+        for (int t = 1; t < max_threads; t *= 2) list.push_back(t);
+        list.push_back(max_threads);
+    } else if (s == "max") {
+        list.push_back(max_threads);
+    } else {
+        for (const char* p = s.c_str(); *p;) {
+            int t = atoi(p);
+            if (t > 0) list.push_back(min(t, max_threads));
+            p = strchr(p, ',');
+            if (!p) break;
+            p++;
+        }
+    }
+    sort(list.begin(), list.end());
+    list.erase(unique(list.begin(), list.end()), list.end());
+    return list;
+}
+
+int main(int argc, char** argv) {
+    size_t n = 0;
+    string threads_arg, pin = "compact", numa = "local";
+    int ntimes = 10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string key = argv[i];
+        if (key == "--n") n = strtoull(argv[i + 1], NULL, 10);
+        else if (key == "--threads") threads_arg = argv[i + 1];
+        else if (key == "--pin") pin = argv[i + 1];
+        else if (key == "--numa") numa = argv[i + 1];
+        else if (key == "--ntimes") ntimes = max(2, atoi(argv[i + 1]));
+        else fprintf(stderr, "unknown option %s\n", argv[i]);
+    }
+    if (pin != "compact" && pin != "spread" && pin != "none") pin = "compact";
+    if (numa != "local" && numa != "master" && numa != "interleave") numa = "local";
+
+    cpu_set_t initial_affinity;
+    sched_getaffinity(0, sizeof(initial_affinity), &initial_affinity);
+    vector<int> cpus = cpu_order(pin);
+    int max_threads = (int)cpus.size();
+    vector<int> thread_counts = parse_threads(threads_arg, max_threads);
+
+    // 4x L3 per array, at most 1/4 of RAM for all three
+    machine_profile mp;
+    machine_profile_load(&mp);
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    size_t l3_bytes = l3 > 0 ? (size_t)l3 : (size_t)(mp.l3_kb * 1024);
+    size_t ram = (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE);
+    bool capped = false;
+    if (n == 0) {
+        n = max((size_t)4 * l3_bytes / sizeof(double), (size_t)1 << 24);
+        if (3 * n * sizeof(double) > ram / 4) {
+            n = ram / 4 / 3 / sizeof(double);
+            capped = true;
+        }
+    }
+    bool interleave = numa == "interleave";
+    double *a = nullptr, *b = nullptr, *c = nullptr;  // fresh per thread count
+
+    printf("\n");
+    printf("╔═══════════════════════════════════════════════════════════════╗\n");
+    printf("║          STREAM-class Bandwidth Suite (AVX2, fp64)            ║\n");
+    printf("╚═══════════════════════════════════════════════════════════════╝\n");
+    printf("Arrays: 3 x %zu elements (%.1f MB each)%s\n", n, n * 8.0 / 1e6,
+           capped ? "  [capped at 1/4 RAM, < 4x L3]" : "");
+    printf("Pinning: %s   NUMA: %s (%d node%s)   best of %d trials\n", pin.c_str(), numa.c_str(),
+           numa_nodes(), numa_nodes() > 1 ? "s" : "", ntimes);
+
+    vector<double> partial(max_threads);
+    vector<kernel_def> kernels = {
+        {"copy", 16, [&](int, size_t lo, size_t hi) { copy(c, a, lo, hi); },
+                     [&](int, size_t lo, size_t hi) { copy_nt(c, a, lo, hi); }},
+        {"scale", 16, [&](int, size_t lo, size_t hi) { scale(b, c, lo, hi); },
+                      [&](int, size_t lo, size_t hi) { scale_nt(b, c, lo, hi); }},
+        {"add", 24, [&](int, size_t lo, size_t hi) { add(c, a, b, lo, hi); },
+                    [&](int, size_t lo, size_t hi) { add_nt(c, a, b, lo, hi); }},
+        {"triad", 24, [&](int, size_t lo, size_t hi) { triad(a, b, c, lo, hi); },
+                      [&](int, size_t lo, size_t hi) { triad_nt(a, b, c, lo, hi); }},
+        {"dot", 16, [&](int id, size_t lo, size_t hi) { partial[id] = dot(a, b, lo, hi); },
+                    nullptr},
+        {"daxpy", 24, [&](int, size_t lo, size_t hi) { daxpy(b, a, lo, hi); },
+                      [&](int, size_t lo, size_t hi) { daxpy_nt(b, a, lo, hi); }},
+    };
+
+    double best_overall = 0;
+    for (int threads : thread_counts) {
+        // New arrays each time: pages keep the node of their first touch,
+        // so arrays placed by the 1-thread pass would stay on one node
+        a = alloc_array(n, interleave);
+        b = alloc_array(n, interleave);
+        c = alloc_array(n, interleave);
+        thread_pool pool(threads, cpus);
+        // master: all pages touched (and so placed) by the main thread
+        if (numa == "master") {
+            pin_to(cpus[0]);
+            for (size_t i = 0; i < n; i++) a[i] = 1.0, b[i] = 2.0, c[i] = 0.0;
+        } else  // local: each thread first-touches its own chunk
+            pool.run([&](int id) {
+                size_t lo, hi;
+                chunk(n, threads, id, &lo, &hi);
+                for (size_t i = lo; i < hi; i++) a[i] = 1.0, b[i] = 2.0, c[i] = 0.0;
+            });
+
+        printf("\n%d thread%s:\n", threads, threads > 1 ? "s" : "");
+        printf("  ┌─────────┬────────────┬────────────┬──────────┐\n");
+        printf("  │ Kernel  │ GB/s       │ GB/s (NT)  │ NT gain  │\n");
+        printf("  ├─────────┼────────────┼────────────┼──────────┤\n");
+        for (auto& k : kernels) {
+            double best[2] = {0, 0};
+            for (int variant = 0; variant < (k.nt ? 2 : 1); variant++) {
+                auto& body = variant ? k.nt : k.regular;
+                for (int t = 0; t < ntimes; t++) {
+                    double t0 = now();
+                    pool.run([&](int id) {
+                        size_t lo, hi;
+                        chunk(n, threads, id, &lo, &hi);
+                        body(id, lo, hi);
+                    });
+                    if (!k.nt) {  // reduction: combine the per-thread partials
+                        double s = 0;
+                        for (int i = 0; i < threads; i++) s += partial[i];
+                        dot_sink = s;
+                    }
+                    double gbs = k.bytes_per_elem * n / (now() - t0) / 1e9;
+                    if (t > 0) best[variant] = max(best[variant], gbs);  // first trial warms up
+                }
+            }
+            best_overall = max(best_overall, max(best[0], best[1]));
+            if (k.nt)
+                printf("  │ %-7s │ %10.1f │ %10.1f │ %7.2fx │\n", k.name, best[0], best[1],
+                       best[1] / best[0]);
+            else
+                printf("  │ %-7s │ %10.1f │          - │        - │\n", k.name, best[0]);
+        }
+        printf("  └─────────┴────────────┴────────────┴──────────┘\n");
+        free_array(a, n);
+        free_array(b, n);
+        free_array(c, n);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(initial_affinity), &initial_affinity);
+
+    printf("\nBest sustained bandwidth: %.1f GB/s\n", best_overall);
+    if (mp.loaded)
+        printf("characterize DRAM ceiling: %.1f GB/s (1 core), %.1f GB/s (all cores)\n",
+               mp.bw_dram_1core, mp.bw_dram_all);
+    return 0;
+}
@@ -0,0 +1,117 @@
+// thread_pool.h - Pinned spin pool shared by the multithreaded examples
+//
+// Workers are created once and spin (yielding) between jobs, so a timed
+// run() measures only the kernel, not thread start-up. The calling thread
+// is worker 0. Each worker is pinned to one CPU from cpu_order(), so
+// first-touch initialization through the same pool puts every thread's
+// pages on its own NUMA node.
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+static inline void pin_to(int cpu) {
+    if (cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+struct thread_pool {
+    int n;
+    std::vector<std::thread> workers;
+    std::function<void(int)> job;
+    std::atomic<int> generation{0}, done{0};
+    std::atomic<bool> stop{false};
+
+    thread_pool(int threads, const std::vector<int>& cpus) : n(threads) {
+        pin_to(cpus[0]);
+        for (int id = 1; id < n; id++)
+            workers.emplace_back([this, id, cpu = cpus[id]] {
+                pin_to(cpu);
+                int seen = 0;
+                for (;;) {
+                    while (generation.load(std::memory_order_acquire) == seen)
+                        std::this_thread::yield();
+                    seen++;
+                    if (stop.load()) return;
+                    job(id);
+                    done.fetch_add(1, std::memory_order_release);
+                }
+            });
+    }
+
+    void run(const std::function<void(int)>& f) {
+        job = f;
+        done.store(0);
+        generation.fetch_add(1, std::memory_order_release);
+        job(0);
+        while (done.load(std::memory_order_acquire) != n - 1) std::this_thread::yield();
+    }
+
+    ~thread_pool() {
+        stop.store(true);
+        generation.fetch_add(1, std::memory_order_release);
+        for (auto& w : workers) w.join();
+    }
+};
+
+// Chunk of thread `id` out of [0, n), boundaries rounded to `align` items
+static inline void chunk(size_t n, int threads, int id, size_t* lo, size_t* hi,
+                         size_t align = 8) {
+    size_t per = (n / threads + align - 1) / align * align;
+    *lo = std::min(n, per * id);
+    *hi = (id == threads - 1) ? n : std::min(n, per * (id + 1));
+}
+
+// ============================================================================
+// Topology
+// ============================================================================
+
+static inline int read_int(const std::string& path, int fallback) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return fallback;
+    int v = fallback;
+    if (fscanf(f, "%d", &v) != 1) v = fallback;
+    fclose(f);
+    return v;
+}
+
+// CPU order for pinning: the allowed CPUs in index order (compact) or
+// round-robin over physical packages (spread); -1s for "none"
+static inline std::vector<int> cpu_order(const std::string& pin) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    std::vector<int> cpus;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+    if (pin == "none") return std::vector<int>(cpus.size(), -1);
+    if (pin == "spread") {
+        std::vector<std::vector<int>> by_pkg;
+        for (int c : cpus) {
+            int pkg = read_int("/sys/devices/system/cpu/cpu" + std::to_string(c) +
+                               "/topology/physical_package_id", 0);
+            if (pkg >= (int)by_pkg.size()) by_pkg.resize(pkg + 1);
+            by_pkg[pkg].push_back(c);
+        }
+        std::vector<int> order;
+        for (size_t k = 0; order.size() < cpus.size(); k++)
+            for (auto& p : by_pkg)
+                if (k < p.size()) order.push_back(p[k]);
+        return order;
+    }
+    return cpus;
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,297 @@
+// accurate_sum.cpp - Compensated (Kahan / Neumaier) and pairwise summation at memory speed
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread -I../../lecture10_roofline/examples accurate_sum.cpp -o accurate_sum
+// Run: ./accurate_sum [n]      (default 100M doubles)
+//
+// sum_v1_fast gets its speed from -ffast-math reassociating the sum into
+// vector accumulators, and its answer changes with it. Reassociation is
+// not the problem: error in a sum of n terms grows with the length of the
+// longest chain of rounded adds. Three ways to keep it small without
+// giving up the vector units:
+//
+//   pairwise   1024-element blocks (16 lanes x 64 adds), then a binary
+//              tree over blocks: error ~ (64 + log2(n/1024)) eps
+//   Kahan      per lane, carry the rounding error c of each add and feed
+//              it back into the next:  y = x - c; t = s + y;
+//              c = (t - s) - y; s = t.  Error ~ 2 eps, independent of n
+//   Neumaier   exact error of each add by TwoSum (6 flops, no branch),
+//              summed separately. Also right when |x| > |s|, which
+//              Kahan misses (1 + 1e100 + 1 - 1e100 gives 0 with Kahan)
+//
+// Kahan's loop-carried chain is 4 dependent adds (16 cycles), so one
+// accumulator pair per 4 lanes would run at 0.25 doubles/cycle. KAHAN_K
+// pairs side by side hide the latency; 8 pairs (16 ymm) would spill.
+// Neumaier's chains are a single add, but it needs 6 adds per vector.
+// Either way the adds fit in the time DRAM takes to deliver the data,
+// given enough misses in flight (ACC_PREFETCH); the L2 column shows what
+// they cost when the data is close.
+//
+// Errors are relative to a long double Neumaier sum (64-bit mantissa plus
+// compensation), which is exact to well below double precision here.
+
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "det_reduce.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Compensated partial: value ~ s + c
+struct acc {
+    double s, c;
+};
+
+// Scalar Neumaier step
+static inline void neu_add(acc& a, double x) {
+    double t = a.s + x;
+    if (fabs(a.s) >= fabs(x)) a.c += (a.s - t) + x;
+    else a.c += (x - t) + a.s;
+    a.s = t;
+}
+
+// Lanes of s (and of c, if compensated) into a
+static inline void neu_add_lanes(acc& a, __m256d s, __m256d c) {
+    alignas(32) double ls[4], lc[4];
+    _mm256_store_pd(ls, s);
+    _mm256_store_pd(lc, c);
+    for (int l = 0; l < 4; l++) {
+        neu_add(a, ls[l]);
+        a.c += lc[l];
+    }
+}
+
+// ============================================================================
+// Kernels over x[lo, hi)
+// ============================================================================
+
+// sum_v1: one scalar chain
+__attribute__((optimize("no-tree-vectorize")))
+static acc sum_naive(const double* x, size_t lo, size_t hi) {
+    double s = 0;
+    for (size_t i = lo; i < hi; i++) s += x[i];
+    return {s, 0.0};
+}
+
+// Plain SIMD (what -ffast-math produces): 4 vector accumulators
+static acc sum_simd(const double* x, size_t lo, size_t hi) {
+    return {det_chunk_sum(x, lo, hi), 0.0};
+}
+
+// Pairwise: SIMD sum of blocks, halving split kept a multiple of 16
+const size_t PAIR_BLOCK = 1024;
+
+static double pairwise(const double* x, size_t n) {
+    if (n <= PAIR_BLOCK) return det_chunk_sum(x, 0, n);
+    size_t h = (n / 2 + 15) & ~(size_t)15;
+    return pairwise(x, h) + pairwise(x + h, n - h);
+}
+
+static acc sum_pairwise(const double* x, size_t lo, size_t hi) {
+    return {pairwise(x + lo, hi - lo), 0.0};
+}
+
+// Software prefetch distance, elements (8 KB), one prefetch per line. The
+// 4-6 extra adds per vector stretch the loop enough that the out-of-order
+// window covers fewer outstanding misses; without it Kahan reaches ~75%
+// and Neumaier ~65% of plain SIMD bandwidth on one core.
+const size_t ACC_PREFETCH = 1024;
+
+// Kahan: KAHAN_K (s, c) vector pairs; c is subtracted, so the result is s - c
+const int KAHAN_K = 4;
+
+static acc sum_kahan(const double* x, size_t lo, size_t hi) {
+    const int K = KAHAN_K;
+    __m256d s[K], c[K];
+    for (int k = 0; k < K; k++) s[k] = c[k] = _mm256_setzero_pd();
+    size_t i = lo;
+    for (; i + 4 * K <= hi; i += 4 * K) {
+        for (int p = 0; p < 4 * K; p += 8)
+            _mm_prefetch((const char*)(x + i + ACC_PREFETCH + p), _MM_HINT_T0);
+        for (int k = 0; k < K; k++) {
+            __m256d y = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4 * k), c[k]);
+            __m256d t = _mm256_add_pd(s[k], y);
+            c[k] = _mm256_sub_pd(_mm256_sub_pd(t, s[k]), y);
+            s[k] = t;
+        }
+    }
+    acc r = {0.0, 0.0};
+    for (int k = 0; k < K; k++)
+        neu_add_lanes(r, s[k], _mm256_sub_pd(_mm256_setzero_pd(), c[k]));
+    for (; i < hi; i++) neu_add(r, x[i]);
+    return r;
+}
+
+// Neumaier: TwoSum error of every add into a separate vector
+const int NEUMAIER_K = 4;
+
+static acc sum_neumaier(const double* x, size_t lo, size_t hi) {
+    const int K = NEUMAIER_K;
+    __m256d s[K], c[K];
+    for (int k = 0; k < K; k++) s[k] = c[k] = _mm256_setzero_pd();
+    size_t i = lo;
+    for (; i + 4 * K <= hi; i += 4 * K) {
+        for (int p = 0; p < 4 * K; p += 8)
+            _mm_prefetch((const char*)(x + i + ACC_PREFETCH + p), _MM_HINT_T0);
+        for (int k = 0; k < K; k++) {
+            __m256d v = _mm256_loadu_pd(x + i + 4 * k);
+            __m256d t = _mm256_add_pd(s[k], v);
+            __m256d z = _mm256_sub_pd(t, s[k]);
+            __m256d e = _mm256_add_pd(_mm256_sub_pd(s[k], _mm256_sub_pd(t, z)),
+                                      _mm256_sub_pd(v, z));
+            c[k] = _mm256_add_pd(c[k], e);
+            s[k] = t;
+        }
+    }
+    acc r = {0.0, 0.0};
+    for (int k = 0; k < K; k++) neu_add_lanes(r, s[k], c[k]);
+    for (; i < hi; i++) neu_add(r, x[i]);
+    return r;
+}
+
+typedef acc (*sum_fn)(const double*, size_t, size_t);
+
+// Thread t sums its block; partials merged in thread order (compensated)
+static double sum_parallel(thread_pool& pool, sum_fn f, const double* x, size_t n) {
+    vector<acc> part(pool.n);
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        part[id] = f(x, lo, hi);
+    });
+    acc r = {0.0, 0.0};
+    for (const acc& p : part) {
+        neu_add(r, p.s);
+        r.c += p.c;
+    }
+    return r.s + r.c;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+template <class F>
+static double best_time(int reps, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        double t0 = now();
+        f();
+        best = min(best, now() - t0);
+    }
+    return best;
+}
+
+// Long double Neumaier: the reference
+static long double sum_reference(const double* x, size_t n) {
+    long double s = 0, c = 0;
+    for (size_t i = 0; i < n; i++) {
+        long double t = s + x[i];
+        if (fabsl(s) >= fabsl((long double)x[i])) c += (s - t) + x[i];
+        else c += (x[i] - t) + s;
+        s = t;
+    }
+    return s + c;
+}
+
+enum { DATA_UNIFORM, DATA_MIXED, DATA_CANCEL, DATA_COUNT };
+static const char* data_names[] = {"uniform [0,1)", "mixed 2^+-20", "cancelling"};
+
+// uniform: all positive, well conditioned; mixed: random sign and
+// exponent; cancelling: large +-pairs over small terms, sum << sum |x|
+static void fill(thread_pool& pool, double* x, size_t n, int kind) {
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        uint64_t s = 0x9E3779B97F4A7C15ull ^ (lo * 0x2545F4914F6CDD1Dull);
+        for (size_t i = lo; i < hi; i++) {
+            s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+            double u = (double)(s >> 11) / 9007199254740992.0;
+            if (kind == DATA_UNIFORM) x[i] = u;
+            else if (kind == DATA_MIXED) x[i] = (u - 0.5) * ldexp(1.0, (int)(s % 41) - 20);
+            else x[i] = (i % 64 < 2) ? ((i & 1) ? -1e12 : 1e12) * (1.0 + (double)(i / 64 % 7))
+                                       : u;
+        }
+    });
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000000;
+    if (n < 64) {
+        fprintf(stderr, "n must be >= 64\n");
+        return 1;
+    }
+    vector<int> cpus = cpu_order("compact");
+    thread_pool pool((int)cpus.size(), cpus);
+    double* x = (double*)aligned_alloc(64, (n * sizeof(double) + 63) / 64 * 64);
+    if (!x) abort();
+
+    struct kernel { const char* name; sum_fn f; } kernels[] = {
+        {"naive (sum_v1)", sum_naive},
+        {"plain SIMD (fast-math)", sum_simd},
+        {"pairwise SIMD", sum_pairwise},
+        {"Kahan SIMD", sum_kahan},
+        {"Neumaier SIMD", sum_neumaier},
+    };
+    const int nk = sizeof(kernels) / sizeof(kernels[0]);
+
+    // Accuracy: relative error per dataset
+    double err[nk][DATA_COUNT];
+    for (int d = 0; d < DATA_COUNT; d++) {
+        fill(pool, x, n, d);
+        long double ref = sum_reference(x, n);
+        for (int k = 0; k < nk; k++)
+            err[k][d] = (double)fabsl((sum_parallel(pool, kernels[k].f, x, n) - ref) / ref);
+    }
+
+    // Throughput: n doubles from memory, and up to 32K doubles (256 KB) from L2
+    const size_t n_l2 = min(n, (size_t)32768);
+    const int l2_reps = 200;
+    fill(pool, x, n, DATA_UNIFORM);
+    double bytes = 8.0 * n;
+    double t_mem[nk], t_l2[nk];
+    volatile double sink = 0;
+    for (int k = 0; k < nk; k++) {
+        t_mem[k] = best_time(3, [&] { sink = sink + sum_parallel(pool, kernels[k].f, x, n); });
+        t_l2[k] = best_time(5, [&] {
+            for (int r = 0; r < l2_reps; r++) sink = sink + kernels[k].f(x, 0, n_l2).s;
+        });
+    }
+
+    printf("\n");
+    printf("╔═════════════════════════════════════════════════════════════════════════╗\n");
+    printf("║  Summation of %10zu doubles (%5.0f MB), %2d thread%s                 ║\n", n,
+           bytes / 1e6, pool.n, pool.n > 1 ? "s" : " ");
+    printf("╟─────────────────────────────────────────────────────────────────────────╢\n");
+    printf("║ Kernel                    DRAM GB/s  vs plain   L2 GB/s                 ║\n");
+    printf("╟─────────────────────────────────────────────────────────────────────────╢\n");
+    for (int k = 0; k < nk; k++)
+        printf("║ %-24s %10.1f %8.0f%% %9.1f                 ║\n", kernels[k].name,
+               bytes / t_mem[k] / 1e9, 100.0 * t_mem[1] / t_mem[k],
+               8.0 * n_l2 * l2_reps / t_l2[k] / 1e9);
+    printf("╚═════════════════════════════════════════════════════════════════════════╝\n");
+
+    printf("\n");
+    printf("╔═════════════════════════════════════════════════════════════════════════╗\n");
+    printf("║  Relative error vs long double Neumaier reference                       ║\n");
+    printf("╟─────────────────────────────────────────────────────────────────────────╢\n");
+    printf("║ Kernel                   ");
+    for (int d = 0; d < DATA_COUNT; d++) printf("%15s", data_names[d]);
+    printf("  ║\n");
+    printf("╟─────────────────────────────────────────────────────────────────────────╢\n");
+    for (int k = 0; k < nk; k++) {
+        printf("║ %-24s ", kernels[k].name);
+        for (int d = 0; d < DATA_COUNT; d++) printf("%15.1e", err[k][d]);
+        printf("  ║\n");
+    }
+    printf("╚═════════════════════════════════════════════════════════════════════════╝\n");
+
+    free(x);
+    return 0;
+}
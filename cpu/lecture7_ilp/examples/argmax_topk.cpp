@@ -0,0 +1,258 @@
+// argmax_topk.cpp - AVX2 argmax / argmin and top-k selection, threaded
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread -I../../lecture10_roofline/examples argmax_topk.cpp -o argmax_topk
+// Run: ./argmax_topk [n]      (default 100M floats)
+//
+// max_v1..v3 return only the value. Ranking needs the position, and
+// usually the k best:
+//
+//   argmax / argmin  8 lanes carry (value, block index) pairs. Inside a
+//                    2048-element block only vmaxps runs (4 accumulators);
+//                    at the block end one compare against the lane's best
+//                    and one blend each for value and block index. The
+//                    winning block is rescanned once for the position.
+//                    Blending per vector instead (cmp + 2 x vblendv, 3
+//                    uops each) makes the loop compute bound at ~1.5
+//                    elements/cycle, below memory speed.
+//   top-k            a min-heap of the k best so far and its worst value
+//                    broadcast as a threshold. 32 elements per step are
+//                    compared against it and OR'd into one movemask; only
+//                    when a bit is set (rare once the heap is warm: about
+//                    k ln(n/k) times in n) does the scalar heap code run.
+//
+// Both split the array over the pool and merge per-thread results. Ties
+// go to the smaller index, so the answers match std::max_element and a
+// partial_sort by (value desc, index asc). Block numbers are int32
+// lanes, so n < 2^31 keeps every index in range.
+
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+#include "thread_pool.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct cand {
+    float v;
+    int64_t i;
+};
+
+// a ranks above b: larger value, then smaller index
+static inline bool above(const cand& a, const cand& b) {
+    return a.v > b.v || (a.v == b.v && a.i < b.i);
+}
+
+// ============================================================================
+// argmax / argmin
+// ============================================================================
+
+const size_t ARG_BLOCK = 2048;  // elements per block (8 KB)
+
+static inline __m256 vext(__m256 a, __m256 b, bool max) {
+    return max ? _mm256_max_ps(a, b) : _mm256_min_ps(a, b);
+}
+
+// MAX: position of the largest value in x[lo, hi), else of the smallest
+template <bool MAX>
+static cand arg_extreme(const float* x, size_t lo, size_t hi) {
+    size_t blocks = (hi - lo) / ARG_BLOCK;
+    cand out = {x[lo], (int64_t)lo};
+    if (blocks > 0) {
+        __m256 best = _mm256_setzero_ps();
+        __m256i bblk = _mm256_setzero_si256();
+        for (size_t b = 0; b < blocks; b++) {
+            const float* p = x + lo + b * ARG_BLOCK;
+            __m256 m0 = _mm256_loadu_ps(p), m1 = _mm256_loadu_ps(p + 8);
+            __m256 m2 = _mm256_loadu_ps(p + 16), m3 = _mm256_loadu_ps(p + 24);
+            for (size_t i = 32; i < ARG_BLOCK; i += 32) {
+                m0 = vext(m0, _mm256_loadu_ps(p + i), MAX);
+                m1 = vext(m1, _mm256_loadu_ps(p + i + 8), MAX);
+                m2 = vext(m2, _mm256_loadu_ps(p + i + 16), MAX);
+                m3 = vext(m3, _mm256_loadu_ps(p + i + 24), MAX);
+            }
+            __m256 bm = vext(vext(m0, m1, MAX), vext(m2, m3, MAX), MAX);
+            // Per lane: keep (value, block) of the first strictly better block
+            __m256 m = b == 0 ? _mm256_castsi256_ps(_mm256_set1_epi32(-1))
+                     : MAX    ? _mm256_cmp_ps(bm, best, _CMP_GT_OQ)
+                              : _mm256_cmp_ps(bm, best, _CMP_LT_OQ);
+            best = _mm256_blendv_ps(best, bm, m);
+            bblk = _mm256_blendv_epi8(bblk, _mm256_set1_epi32((int)b), _mm256_castps_si256(m));
+        }
+        // Winning value, earliest block holding it, first position inside
+        alignas(32) float bv[8];
+        alignas(32) int32_t bb[8];
+        _mm256_store_ps(bv, best);
+        _mm256_store_si256((__m256i*)bb, bblk);
+        float v = bv[0];
+        int32_t blk = bb[0];
+        for (int l = 1; l < 8; l++) {
+            if (MAX ? bv[l] > v : bv[l] < v) v = bv[l], blk = bb[l];
+            else if (bv[l] == v && bb[l] < blk) blk = bb[l];
+        }
+        // A NaN winner equals nothing: stop at the block's last element
+        size_t j = lo + (size_t)blk * ARG_BLOCK, last = j + ARG_BLOCK - 1;
+        while (j < last && x[j] != v) j++;
+        out = {v, (int64_t)j};
+    }
+    for (size_t i = lo + blocks * ARG_BLOCK; i < hi; i++)
+        if (MAX ? x[i] > out.v : x[i] < out.v) out = {x[i], (int64_t)i};
+    return out;
+}
+
+template <bool MAX>
+static cand arg_extreme_parallel(thread_pool& pool, const float* x, size_t n) {
+    vector<cand> part(pool.n, cand{0, -1});
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        if (lo < hi) part[id] = arg_extreme<MAX>(x, lo, hi);
+    });
+    cand out = {0, -1};
+    for (const cand& c : part)  // thread order = index order: strict keeps the first
+        if (c.i >= 0 && (out.i < 0 || (MAX ? c.v > out.v : c.v < out.v))) out = c;
+    return out;
+}
+
+// ============================================================================
+// top-k
+// ============================================================================
+
+// The k best of x[lo, hi) as a heap whose front is the worst kept
+static vector<cand> topk_range(const float* x, size_t lo, size_t hi, size_t k) {
+    vector<cand> heap;
+    size_t i = lo;
+    for (; i < hi && heap.size() < k; i++) heap.push_back({x[i], (int64_t)i});
+    make_heap(heap.begin(), heap.end(), above);
+    if (heap.size() < k) return heap;
+
+    auto offer = [&](size_t j) {
+        // Strict >: an equal value at a larger index ranks below the front
+        if (x[j] > heap.front().v) {
+            pop_heap(heap.begin(), heap.end(), above);
+            heap.back() = {x[j], (int64_t)j};
+            push_heap(heap.begin(), heap.end(), above);
+        }
+    };
+    __m256 thr = _mm256_set1_ps(heap.front().v);
+    for (; i + 32 <= hi; i += 32) {
+        __m256 m0 = _mm256_cmp_ps(_mm256_loadu_ps(x + i), thr, _CMP_GT_OQ);
+        __m256 m1 = _mm256_cmp_ps(_mm256_loadu_ps(x + i + 8), thr, _CMP_GT_OQ);
+        __m256 m2 = _mm256_cmp_ps(_mm256_loadu_ps(x + i + 16), thr, _CMP_GT_OQ);
+        __m256 m3 = _mm256_cmp_ps(_mm256_loadu_ps(x + i + 24), thr, _CMP_GT_OQ);
+        __m256 any = _mm256_or_ps(_mm256_or_ps(m0, m1), _mm256_or_ps(m2, m3));
+        if (_mm256_movemask_ps(any) == 0) continue;
+        for (size_t j = i; j < i + 32; j++) offer(j);
+        thr = _mm256_set1_ps(heap.front().v);
+    }
+    for (; i < hi; i++) offer(i);
+    return heap;
+}
+
+// k best of x[0, n), best first
+static vector<cand> topk_parallel(thread_pool& pool, const float* x, size_t n, size_t k) {
+    vector<vector<cand>> part(pool.n);
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        part[id] = topk_range(x, lo, hi, k);
+    });
+    vector<cand> all;
+    for (auto& p : part) all.insert(all.end(), p.begin(), p.end());
+    size_t keep = min(k, all.size());
+    partial_sort(all.begin(), all.begin() + keep, all.end(), above);
+    all.resize(keep);
+    return all;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+template <class F>
+static double best_time(int reps, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        double t0 = now();
+        f();
+        best = min(best, now() - t0);
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000000;
+    if (n < 64 || n >= (1ull << 31)) {
+        fprintf(stderr, "n must be in [64, 2^31)\n");
+        return 1;
+    }
+    float* x = (float*)aligned_alloc(64, (n * sizeof(float) + 63) / 64 * 64);
+    if (!x) abort();
+
+    vector<int> cpus = cpu_order("compact");
+    thread_pool pool((int)cpus.size(), cpus);
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        uint64_t s = 0x9E3779B97F4A7C15ull ^ (lo * 0x2545F4914F6CDD1Dull);
+        for (size_t i = lo; i < hi; i++) {
+            s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+            x[i] = (float)((s >> 40) & 0xFFFFFF) * (1.0f / 16777216.0f) - 0.5f;
+        }
+    });
+    // Ties at the extremes: both winners appear twice
+    x[n / 3] = x[2 * n / 3] = 2.0f;
+    x[n / 5] = x[4 * n / 5] = -2.0f;
+    double bytes = (double)n * sizeof(float);
+
+    printf("\nargmax / argmin / top-k over %zu floats (%.0f MB), %d thread%s\n", n, bytes / 1e6,
+           pool.n, pool.n > 1 ? "s" : "");
+    printf("%-34s %10s %8s %9s  %s\n", "Kernel", "Time ms", "GB/s", "Speedup", "Check");
+
+    cand amax = {0, 0}, amin = {0, 0};
+    const float *smax = x, *smin = x;
+    double t_std_max = best_time(3, [&] { smax = max_element(x, x + n); });
+    double t_max = best_time(5, [&] { amax = arg_extreme_parallel<true>(pool, x, n); });
+    double t_std_min = best_time(3, [&] { smin = min_element(x, x + n); });
+    double t_min = best_time(5, [&] { amin = arg_extreme_parallel<false>(pool, x, n); });
+    auto line = [&](const char* name, double t, double base, bool ok) {
+        printf("%-34s %10.2f %8.1f %8.1fx  %s\n", name, t * 1e3, bytes / t / 1e9, base / t,
+               ok ? "ok" : "MISMATCH");
+    };
+    line("std::max_element", t_std_max, t_std_max, true);
+    line("argmax AVX2 block blend", t_max, t_std_max, amax.i == smax - x);
+    line("std::min_element", t_std_min, t_std_min, true);
+    line("argmin AVX2 block blend", t_min, t_std_min, amin.i == smin - x);
+
+    vector<int32_t> idx(n);
+    for (size_t k : {10, 100, 1000}) {
+        if (k > n) break;
+        vector<cand> fast;
+        double t_fast = best_time(3, [&] { fast = topk_parallel(pool, x, n, k); });
+        double t_std = best_time(1, [&] {
+            iota(idx.begin(), idx.end(), 0);
+            partial_sort(idx.begin(), idx.begin() + k, idx.end(), [&](int32_t a, int32_t b) {
+                return x[a] > x[b] || (x[a] == x[b] && a < b);
+            });
+        });
+        bool ok = fast.size() == k;
+        for (size_t j = 0; ok && j < k; j++) ok = fast[j].i == idx[j];
+        char name[64];
+        snprintf(name, sizeof(name), "std::partial_sort (indices) k=%zu", k);
+        line(name, t_std, t_std, true);
+        snprintf(name, sizeof(name), "top-k AVX2 threshold k=%zu", k);
+        line(name, t_fast, t_std, ok);
+    }
+    printf("\nargmax = x[%lld] = %g, argmin = x[%lld] = %g (first of two ties each)\n",
+           (long long)amax.i, amax.v, (long long)amin.i, amin.v);
+
+    free(x);
+    return 0;
+}
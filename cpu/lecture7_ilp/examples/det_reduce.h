@@ -0,0 +1,103 @@
+// det_reduce.h - Deterministic parallel reduction: fixed chunks, fixed tree
+//
+// Floating-point addition is not associative, so a parallel sum that
+// gives each thread n/T elements changes its result with T. Here the
+// summation order depends only on n:
+//
+//   1. The array is cut into DET_CHUNK-element chunks (the last may be
+//      short). Each chunk is reduced by the same AVX2 kernel, 4 vector
+//      accumulators (16 lanes) combined in a fixed order.
+//   2. Chunk partials land in partials[c], whichever thread computed them.
+//   3. Partials are combined by a fixed pairwise tree (split at half).
+//
+// Threads only decide *who* computes a chunk, never the order of adds,
+// so the result is bitwise identical for any thread count. The price is
+// one double store per chunk (1/512 of the input at 4096 doubles) and a
+// serial tree over the partials: ~25k adds for 100M elements.
+//
+// Needs thread_pool.h (cpu/lecture10_roofline/examples, via -I).
+
+#ifndef DET_REDUCE_H
+#define DET_REDUCE_H
+
+#include <immintrin.h>
+#include <cstddef>
+#include <vector>
+#include "thread_pool.h"
+
+const size_t DET_CHUNK = 4096;  // elements per chunk, a multiple of 16
+
+// Fixed-order horizontal sum of 4 accumulators
+static inline double det_hsum(__m256d a0, __m256d a1, __m256d a2, __m256d a3) {
+    __m256d s = _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3));
+    __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+}
+
+// Chunk kernels: x[lo, hi), 16 elements per step, scalar tail
+static inline double det_chunk_sum(const double* x, size_t lo, size_t hi) {
+    __m256d a0 = _mm256_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = lo;
+    for (; i + 16 <= hi; i += 16) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(x + i));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(x + i + 4));
+        a2 = _mm256_add_pd(a2, _mm256_loadu_pd(x + i + 8));
+        a3 = _mm256_add_pd(a3, _mm256_loadu_pd(x + i + 12));
+    }
+    double s = det_hsum(a0, a1, a2, a3);
+    for (; i < hi; i++) s += x[i];
+    return s;
+}
+
+static inline double det_chunk_dot(const double* x, const double* y, size_t lo, size_t hi) {
+    __m256d a0 = _mm256_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = lo;
+    for (; i + 16 <= hi; i += 16) {
+        a0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), a0);
+        a1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), a1);
+        a2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), a2);
+        a3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), a3);
+    }
+    double s = det_hsum(a0, a1, a2, a3);
+    for (; i < hi; i++) s += x[i] * y[i];
+    return s;
+}
+
+// Pairwise tree over p[0, n): the shape depends only on n
+static inline double det_tree(const double* p, size_t n) {
+    if (n == 0) return 0.0;
+    if (n == 1) return p[0];
+    size_t h = n / 2;
+    return det_tree(p, h) + det_tree(p + h, n - h);
+}
+
+// Reduce [0, n) with chunk(lo, hi) -> partial; threads take contiguous
+// runs of chunks. `partials` is scratch, reused across calls.
+template <class Chunk>
+static double det_reduce(thread_pool& pool, size_t n, Chunk chunk_fn,
+                         std::vector<double>& partials) {
+    size_t chunks = (n + DET_CHUNK - 1) / DET_CHUNK;
+    partials.resize(chunks);
+    pool.run([&](int id) {
+        size_t c0, c1;
+        chunk(chunks, pool.n, id, &c0, &c1, 1);
+        for (size_t c = c0; c < c1; c++)
+            partials[c] = chunk_fn(c * DET_CHUNK, std::min(n, (c + 1) * DET_CHUNK));
+    });
+    return det_tree(partials.data(), chunks);
+}
+
+static inline double det_sum(thread_pool& pool, const double* x, size_t n,
+                             std::vector<double>& partials) {
+    return det_reduce(pool, n, [x](size_t lo, size_t hi) { return det_chunk_sum(x, lo, hi); },
+                      partials);
+}
+
+static inline double det_dot(thread_pool& pool, const double* x, const double* y, size_t n,
+                             std::vector<double>& partials) {
+    return det_reduce(pool, n,
+                      [x, y](size_t lo, size_t hi) { return det_chunk_dot(x, y, lo, hi); },
+                      partials);
+}
+
+#endif // DET_REDUCE_H
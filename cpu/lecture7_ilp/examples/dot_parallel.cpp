@@ -0,0 +1,140 @@
+// dot_parallel.cpp - Parallel dot product that gives the same bits for any thread count
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread -I../../lecture10_roofline/examples dot_parallel.cpp -o dot_parallel
+// Run: ./dot_parallel [n]      (default 100M doubles per vector)
+//
+// dot_v2 breaks the dependency chain with 4 accumulators, which already
+// changes the rounding relative to dot_v1. Splitting the array across T
+// threads changes it again, differently for every T:
+//
+//   naive parallel   thread t sums its n/T block, partials added in order
+//   det_dot          fixed 4096-element chunks, fixed pairwise tree over
+//                    chunk partials (det_reduce.h): order depends on n only
+//
+// Both use the same 4-accumulator AVX2 FMA kernel, so the difference in
+// time is only the cost of determinism.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "det_reduce.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Dot_v1: one accumulator, program order
+__attribute__((optimize("no-tree-vectorize")))
+static double dot_serial(const double* x, const double* y, size_t n) {
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += x[i] * y[i];
+    return s;
+}
+
+// Same kernel as det_dot, but thread t reduces its own n/T block
+static double dot_naive_parallel(thread_pool& pool, const double* x, const double* y, size_t n) {
+    vector<double> part(pool.n);
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        part[id] = det_chunk_dot(x, y, lo, hi);
+    });
+    double s = 0;
+    for (double p : part) s += p;
+    return s;
+}
+
+// `threads` workers over the allowed CPUs, wrapping around if there are fewer
+static vector<int> pool_cpus(int threads) {
+    vector<int> cpus = cpu_order("compact"), out;
+    for (int t = 0; t < threads; t++) out.push_back(cpus[t % cpus.size()]);
+    return out;
+}
+
+static uint64_t bits(double d) {
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    return u;
+}
+
+// Best of `reps` runs, seconds
+template <class F>
+static double best_time(int reps, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        double t0 = now();
+        f();
+        best = min(best, now() - t0);
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000000;
+    double* x = (double*)aligned_alloc(64, (n * sizeof(double) + 63) / 64 * 64);
+    double* y = (double*)aligned_alloc(64, (n * sizeof(double) + 63) / 64 * 64);
+    if (!x || !y) abort();
+
+    int hw = (int)cpu_order("compact").size();
+    thread_pool pool(hw, pool_cpus(hw));
+
+    // Mixed magnitudes and signs, so reassociation visibly changes low bits;
+    // first touch by the pool that later reads the data
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        uint64_t s = 0x9E3779B97F4A7C15ull ^ lo;
+        for (size_t i = lo; i < hi; i++) {
+            s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+            double u = (double)(s >> 11) / 9007199254740992.0;
+            x[i] = (u - 0.5) * ldexp(1.0, (int)(s & 15) - 8);
+            y[i] = 1.0 + (double)(i % 1000) * 1e-3;
+        }
+    });
+
+    long double exact = 0;
+    for (size_t i = 0; i < n; i++) exact += (long double)x[i] * y[i];
+    double bytes = 16.0 * n;
+
+    printf("\nDot product, n = %zu (%.0f MB), %d thread%s\n", n, bytes / 1e6, hw,
+           hw > 1 ? "s" : "");
+    printf("%-22s %10s %10s %26s %10s\n", "Version", "Time ms", "GB/s", "Result", "Rel err");
+    vector<double> partials;
+    double r_serial = 0, r_naive = 0, r_det = 0;
+    double t_serial = best_time(3, [&] { r_serial = dot_serial(x, y, n); });
+    double t_naive = best_time(5, [&] { r_naive = dot_naive_parallel(pool, x, y, n); });
+    double t_det = best_time(5, [&] { r_det = det_dot(pool, x, y, n, partials); });
+    struct { const char* name; double t, r; } rows[] = {
+        {"serial (dot_v1)", t_serial, r_serial},
+        {"naive parallel AVX2", t_naive, r_naive},
+        {"det_dot AVX2", t_det, r_det},
+    };
+    for (auto& r : rows)
+        printf("%-22s %10.2f %10.1f %26.17g %10.1e\n", r.name, r.t * 1e3, bytes / r.t / 1e9, r.r,
+               (double)fabsl((r.r - exact) / exact));
+    printf("det_dot / naive parallel time: %.2fx\n", t_det / t_naive);
+
+    // Same data, different thread counts (oversubscribed beyond the CPU count)
+    printf("\nResult bits by thread count:\n");
+    printf("%8s %20s %20s\n", "Threads", "naive parallel", "det_dot");
+    uint64_t naive1 = 0, det1 = 0;
+    bool naive_same = true, det_same = true;
+    for (int t : {1, 2, 3, 4, 6, 8, 12, 16}) {
+        thread_pool p(t, pool_cpus(t));
+        double rn = dot_naive_parallel(p, x, y, n), rd = det_dot(p, x, y, n, partials);
+        if (t == 1) naive1 = bits(rn), det1 = bits(rd);
+        naive_same &= bits(rn) == naive1;
+        det_same &= bits(rd) == det1;
+        printf("%8d   %016llx   %016llx\n", t, (unsigned long long)bits(rn),
+               (unsigned long long)bits(rd));
+    }
+    printf("naive parallel: %s\n", naive_same ? "identical" : "changes with thread count");
+    printf("det_dot:        %s\n", det_same ? "bitwise identical" : "MISMATCH");
+
+    free(x);
+    free(y);
+    return det_same ? 0 : 1;
+}
@@ -0,0 +1,293 @@
+// fused_stats.cpp - count / sum / min / max / sum of squares in one pass
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -pthread -I../../lecture10_roofline/examples fused_stats.cpp -o fused_stats
+// Run: ./fused_stats [n] [stats]      (default 100M doubles, count,sum,min,max,sumsq)
+//
+// count_v*, sum_v* and max_v* each stream the whole array. Over data far
+// larger than cache every pass costs the same n x 8 bytes from DRAM and
+// the arithmetic is free, so k statistics in k passes take ~k times as
+// long as one. Fused, the data is loaded once and every statistic is
+// updated from the same register:
+//
+//   count  x > threshold: compare, subtract the all-ones mask (epi64)
+//   sum    add          min / max  vminpd / vmaxpd
+//   sumsq  FMA x * x
+//
+// scan<STATS> is instantiated per bitmask of statistics, so a kernel
+// carries only the accumulators it needs (2 of each, so all five x 2
+// still fit in 16 ymm registers). scan_table maps a runtime mask to its
+// instantiation. The separate passes below run the same kernel with
+// one bit set per pass, so the only difference measured is fusion; each
+// statistic's summation order is the same either way, so the results
+// match bitwise. Both are also checked against a plain scalar loop
+// (long double sums): count, min and max exactly, the sums to 1e-9.
+
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include "thread_pool.h"
+using namespace std;
+
+enum { ST_COUNT = 1, ST_SUM = 2, ST_MIN = 4, ST_MAX = 8, ST_SUMSQ = 16, ST_ALL = 31 };
+static const char* stat_names[] = {"count", "sum", "min", "max", "sumsq"};
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct stats {
+    int64_t count;
+    double sum, min, max, sumsq;
+};
+
+static stats stats_identity() {
+    return {0, 0.0, numeric_limits<double>::infinity(), -numeric_limits<double>::infinity(), 0.0};
+}
+
+// b after a (thread order)
+static void stats_merge(stats& a, const stats& b) {
+    a.count += b.count;
+    a.sum += b.sum;
+    a.min = min(a.min, b.min);
+    a.max = max(a.max, b.max);
+    a.sumsq += b.sumsq;
+}
+
+static inline double hadd(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+// Software prefetch distance, elements (4 KB). One core's bandwidth is
+// bounded by the cache-line misses in flight; five statistics put ~3x
+// the uops between loads, the out-of-order window then covers fewer lines
+// and a fused pass without prefetch drops from ~9 to ~6.5 GB/s here.
+const size_t SCAN_PREFETCH = 512;
+
+// ============================================================================
+// Kernel: statistics in STATS over x[lo, hi)
+// ============================================================================
+template <unsigned STATS>
+static stats scan(const double* x, size_t lo, size_t hi, double threshold) {
+    const int U = 2;
+    const bool C = STATS & ST_COUNT, S = STATS & ST_SUM, MN = STATS & ST_MIN,
+               MX = STATS & ST_MAX, SQ = STATS & ST_SUMSQ;
+    stats r = stats_identity();
+    __m256d thr = _mm256_set1_pd(threshold);
+    __m256i cnt[U];
+    __m256d sum[U], mn[U], mx[U], sq[U];
+    for (int u = 0; u < U; u++) {
+        cnt[u] = _mm256_setzero_si256();
+        sum[u] = sq[u] = _mm256_setzero_pd();
+        mn[u] = _mm256_set1_pd(r.min);
+        mx[u] = _mm256_set1_pd(r.max);
+    }
+    size_t i = lo;
+    for (; i + 4 * U <= hi; i += 4 * U) {
+        _mm_prefetch((const char*)(x + i + SCAN_PREFETCH), _MM_HINT_T0);
+        for (int u = 0; u < U; u++) {
+            __m256d v = _mm256_loadu_pd(x + i + 4 * u);
+            if (C) cnt[u] = _mm256_sub_epi64(cnt[u], _mm256_castpd_si256(
+                                                         _mm256_cmp_pd(v, thr, _CMP_GT_OQ)));
+            if (S) sum[u] = _mm256_add_pd(sum[u], v);
+            if (MN) mn[u] = _mm256_min_pd(mn[u], v);
+            if (MX) mx[u] = _mm256_max_pd(mx[u], v);
+            if (SQ) sq[u] = _mm256_fmadd_pd(v, v, sq[u]);
+        }
+    }
+    for (int u = 1; u < U; u++) {
+        cnt[0] = _mm256_add_epi64(cnt[0], cnt[u]);
+        sum[0] = _mm256_add_pd(sum[0], sum[u]);
+        mn[0] = _mm256_min_pd(mn[0], mn[u]);
+        mx[0] = _mm256_max_pd(mx[0], mx[u]);
+        sq[0] = _mm256_add_pd(sq[0], sq[u]);
+    }
+    alignas(32) int64_t c[4];
+    alignas(32) double lmin[4], lmax[4];
+    _mm256_store_si256((__m256i*)c, cnt[0]);
+    _mm256_store_pd(lmin, mn[0]);
+    _mm256_store_pd(lmax, mx[0]);
+    if (C) r.count = c[0] + c[1] + c[2] + c[3];
+    if (S) r.sum = hadd(sum[0]);
+    if (MN) r.min = min(min(lmin[0], lmin[1]), min(lmin[2], lmin[3]));
+    if (MX) r.max = max(max(lmax[0], lmax[1]), max(lmax[2], lmax[3]));
+    if (SQ) r.sumsq = hadd(sq[0]);
+    for (; i < hi; i++) {
+        double v = x[i];
+        if (C) r.count += v > threshold;
+        if (S) r.sum += v;
+        if (MN) r.min = min(r.min, v);
+        if (MX) r.max = max(r.max, v);
+        if (SQ) r.sumsq += v * v;
+    }
+    return r;
+}
+
+typedef stats (*scan_fn)(const double*, size_t, size_t, double);
+
+// scan_table<ST_ALL>::fill(t): t[m] = scan<m> for every mask m
+template <unsigned M>
+struct scan_table {
+    static void fill(scan_fn* t) {
+        t[M] = scan<M>;
+        scan_table<M - 1>::fill(t);
+    }
+};
+template <>
+struct scan_table<0> {
+    static void fill(scan_fn* t) { t[0] = scan<0>; }
+};
+
+static stats scan_parallel(thread_pool& pool, scan_fn f, const double* x, size_t n,
+                           double threshold) {
+    vector<stats> part(pool.n, stats_identity());
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        part[id] = f(x, lo, hi, threshold);
+    });
+    stats r = stats_identity();
+    for (const stats& p : part) stats_merge(r, p);
+    return r;
+}
+
+// Independent reference: one scalar loop, sums in long double
+static stats scan_reference(const double* x, size_t n, double threshold) {
+    stats r = stats_identity();
+    long double sum = 0, sumsq = 0;
+    for (size_t i = 0; i < n; i++) {
+        r.count += x[i] > threshold;
+        sum += x[i];
+        r.min = min(r.min, x[i]);
+        r.max = max(r.max, x[i]);
+        sumsq += (long double)x[i] * x[i];
+    }
+    r.sum = (double)sum;
+    r.sumsq = (double)sumsq;
+    return r;
+}
+
+static bool close_to(double got, double ref) { return fabs(got - ref) <= 1e-9 * fabs(ref); }
+
+// The statistics in `m` agree with the reference
+static bool matches_reference(const stats& s, const stats& ref, unsigned m) {
+    return (!(m & ST_COUNT) || s.count == ref.count) &&
+           (!(m & ST_SUM) || close_to(s.sum, ref.sum)) && (!(m & ST_MIN) || s.min == ref.min) &&
+           (!(m & ST_MAX) || s.max == ref.max) && (!(m & ST_SUMSQ) || close_to(s.sumsq, ref.sumsq));
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+static unsigned parse_stats(const char* s) {
+    unsigned m = 0;
+    string list = s;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(',', pos);
+        string name = list.substr(pos, end == string::npos ? string::npos : end - pos);
+        bool found = false;
+        for (int b = 0; b < 5; b++)
+            if (name == stat_names[b]) m |= 1u << b, found = true;
+        if (!found) return 0;
+        if (end == string::npos) break;
+        pos = end + 1;
+    }
+    return m;
+}
+
+static string mask_name(unsigned m) {
+    string s;
+    for (int b = 0; b < 5; b++)
+        if (m & (1u << b)) s += (s.empty() ? "" : "+") + string(stat_names[b]);
+    return s;
+}
+
+template <class F>
+static double best_time(int reps, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        double t0 = now();
+        f();
+        best = min(best, now() - t0);
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000000;
+    unsigned want = argc > 2 ? parse_stats(argv[2]) : (unsigned)ST_ALL;
+    if (n == 0 || want == 0) {
+        fprintf(stderr, "usage: %s [n] [count,sum,min,max,sumsq]\n", argv[0]);
+        return 1;
+    }
+    scan_fn table[ST_ALL + 1];
+    scan_table<ST_ALL>::fill(table);
+
+    vector<int> cpus = cpu_order("compact");
+    thread_pool pool((int)cpus.size(), cpus);
+    double* x = (double*)aligned_alloc(64, (n * sizeof(double) + 63) / 64 * 64);
+    if (!x) abort();
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        for (size_t i = lo; i < hi; i++) x[i] = 50.0 + 40.0 * sin(0.001 * i) + (double)(i % 7);
+    });
+    const double threshold = 75.0;
+    double bytes = 8.0 * n;
+    stats ref = scan_reference(x, n, threshold);
+
+    printf("\n");
+    printf("╔════════════════════════════════════════════════════════════════════╗\n");
+    printf("║  Fused statistics scan: %10zu doubles (%5.0f MB), %2d thread%s  ║\n", n,
+           bytes / 1e6, pool.n, pool.n > 1 ? "s" : " ");
+    printf("╟────────────────────────────────────────────────────────────────────╢\n");
+    printf("║ Statistics                   Separate ms   Fused ms  Speedup  GB/s ║\n");
+    printf("╟────────────────────────────────────────────────────────────────────╢\n");
+
+    // Growing prefixes of the requested set: 1, 2, ... statistics
+    stats fused = stats_identity(), sep = stats_identity();
+    bool match = true, correct = true;
+    unsigned m = 0;
+    for (int b = 0; b < 5; b++) {
+        if (!(want & (1u << b))) continue;
+        m |= 1u << b;
+        double t_fused = best_time(3, [&] { fused = scan_parallel(pool, table[m], x, n, threshold); });
+        double t_sep = best_time(3, [&] {
+            sep = stats_identity();
+            for (int s = 0; s < 5; s++)
+                if (m & (1u << s)) {
+                    stats one = scan_parallel(pool, table[1u << s], x, n, threshold);
+                    if (s == 0) sep.count = one.count;
+                    if (s == 1) sep.sum = one.sum;
+                    if (s == 2) sep.min = one.min;
+                    if (s == 3) sep.max = one.max;
+                    if (s == 4) sep.sumsq = one.sumsq;
+                }
+        });
+        match &= memcmp(&fused, &sep, sizeof(stats)) == 0;
+        correct &= matches_reference(fused, ref, m) && matches_reference(sep, ref, m);
+        printf("║ %-28s %11.2f %10.2f %7.2fx %5.1f ║\n", mask_name(m).c_str(), t_sep * 1e3,
+               t_fused * 1e3, t_sep / t_fused, bytes / t_fused / 1e9);
+    }
+    printf("╚════════════════════════════════════════════════════════════════════╝\n");
+
+    if (want & ST_COUNT) printf("count(x > %g) = %lld\n", threshold, (long long)fused.count);
+    if (want & ST_SUM) printf("sum = %.6f\n", fused.sum);
+    if (want & ST_MIN) printf("min = %g\n", fused.min);
+    if (want & ST_MAX) printf("max = %g\n", fused.max);
+    if (want & ST_SUMSQ) printf("sumsq = %.6e\n", fused.sumsq);
+    printf("fused vs separate results: %s\n", match ? "bitwise identical" : "MISMATCH");
+    printf("vs scalar reference: %s\n", correct ? "ok" : "MISMATCH");
+
+    free(x);
+    return match && correct ? 0 : 1;
+}
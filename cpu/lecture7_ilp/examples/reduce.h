@@ -0,0 +1,369 @@
+// reduce.h - One reduction template for sum / max / count with K accumulators
+//
+// sum_v1..v3, max_v1..v3 and count_v1..v3 are the same loop with 1, 2 or
+// 4 hand-written accumulators. Here the loop is written once:
+//
+//   reduce<op_sum, double, 8, 256>(x, n)          8 AVX2 accumulators
+//   reduce<op_max, float, 4, 128>(x, n)           4 SSE accumulators
+//   reduce<op_count, int32_t, 2, 0>(x, n, thr)    2 scalar counters of x > thr
+//
+// Template parameters: the operator, the element type (float, double,
+// int32_t), K accumulators and the SIMD width in bits (0 = scalar, 128,
+// 256). The K-way body is unrolled at compile time, so K = 8 is eight
+// independent registers exactly like sum_v3's s1..s8.
+//
+// How many accumulators are enough is latency x throughput of the
+// operation: an FP add with 4-cycle latency and 2 ports needs 8 in
+// flight, an integer add (1 cycle) needs ~2. reduce_autotune() measures
+// that on the running CPU instead of guessing: it times every K on an
+// L1-resident buffer and keeps the smallest K within 5% of the fastest.
+// reduce_auto() binds that choice on first use.
+//
+// Lanes combine in a fixed order (accumulator 0 + 1 + ... then lanes
+// low to high), so a given <Op, T, K, BITS> is deterministic; different
+// K or width reassociate a float sum, as sum_v2 does relative to sum_v1.
+
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include <immintrin.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// static_for<0, N>::run(f) calls f(integral_constant<int, 0>) ... f(<N-1>)
+template <int I, int N>
+struct static_for {
+    template <class F>
+    static inline __attribute__((always_inline)) void run(F&& f) {
+        f(std::integral_constant<int, I>());
+        static_for<I + 1, N>::run(f);
+    }
+};
+template <int N>
+struct static_for<N, N> {
+    template <class F>
+    static inline __attribute__((always_inline)) void run(F&&) {}
+};
+
+// ============================================================================
+// SIMD traits: simd<T, BITS>
+//   V            value vector, W lanes of T
+//   C            count accumulator (integer lanes, same width as V)
+//   load/set1/add/max, count_gt(c, x, thr) = c + (x > thr), cadd(c, c),
+//   horizontal ops
+// ============================================================================
+template <class T, int BITS>
+struct simd;
+
+// Scalar (BITS = 0): one lane, the compiler's own code
+template <class T>
+struct simd<T, 0> {
+    typedef T V;
+    typedef int64_t C;
+    static const int W = 1;
+    static V load(const T* p) { return *p; }
+    static V set1(T a) { return a; }
+    static V add(V a, V b) { return a + b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static C czero() { return 0; }
+    static C cadd(C a, C b) { return a + b; }
+    static C count_gt(C c, V x, V thr) { return c + (x > thr); }
+    static T hadd(V a) { return a; }
+    static T hmax(V a) { return a; }
+    static int64_t hcount(C c) { return c; }
+};
+
+template <>
+struct simd<float, 128> {
+    typedef __m128 V;
+    typedef __m128i C;
+    static const int W = 4;
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static V set1(float a) { return _mm_set1_ps(a); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+    static C czero() { return _mm_setzero_si128(); }
+    static C cadd(C a, C b) { return _mm_add_epi32(a, b); }
+    static C count_gt(C c, V x, V thr) {
+        return _mm_sub_epi32(c, _mm_castps_si128(_mm_cmpgt_ps(x, thr)));
+    }
+    static float hadd(V a) {
+        a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_add_ss(a, _mm_movehdup_ps(a)));
+    }
+    static float hmax(V a) {
+        a = _mm_max_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_max_ss(a, _mm_movehdup_ps(a)));
+    }
+    static int64_t hcount(C c) {
+        alignas(16) int32_t l[4];
+        _mm_store_si128((__m128i*)l, c);
+        return (int64_t)l[0] + l[1] + l[2] + l[3];
+    }
+};
+
+template <>
+struct simd<float, 256> {
+    typedef __m256 V;
+    typedef __m256i C;
+    static const int W = 8;
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static V set1(float a) { return _mm256_set1_ps(a); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+    static C czero() { return _mm256_setzero_si256(); }
+    static C cadd(C a, C b) { return _mm256_add_epi32(a, b); }
+    static C count_gt(C c, V x, V thr) {
+        return _mm256_sub_epi32(c, _mm256_castps_si256(_mm256_cmp_ps(x, thr, _CMP_GT_OQ)));
+    }
+    static float hadd(V a) {
+        return simd<float, 128>::hadd(
+            _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+    }
+    static float hmax(V a) {
+        return simd<float, 128>::hmax(
+            _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+    }
+    static int64_t hcount(C c) {
+        return simd<float, 128>::hcount(_mm256_castsi256_si128(c)) +
+               simd<float, 128>::hcount(_mm256_extracti128_si256(c, 1));
+    }
+};
+
+template <>
+struct simd<double, 128> {
+    typedef __m128d V;
+    typedef __m128i C;
+    static const int W = 2;
+    static V load(const double* p) { return _mm_loadu_pd(p); }
+    static V set1(double a) { return _mm_set1_pd(a); }
+    static V add(V a, V b) { return _mm_add_pd(a, b); }
+    static V max(V a, V b) { return _mm_max_pd(a, b); }
+    static C czero() { return _mm_setzero_si128(); }
+    static C cadd(C a, C b) { return _mm_add_epi64(a, b); }
+    static C count_gt(C c, V x, V thr) {
+        return _mm_sub_epi64(c, _mm_castpd_si128(_mm_cmpgt_pd(x, thr)));
+    }
+    static double hadd(V a) { return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a))); }
+    static double hmax(V a) { return _mm_cvtsd_f64(_mm_max_sd(a, _mm_unpackhi_pd(a, a))); }
+    static int64_t hcount(C c) {
+        return _mm_cvtsi128_si64(c) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(c, c));
+    }
+};
+
+template <>
+struct simd<double, 256> {
+    typedef __m256d V;
+    typedef __m256i C;
+    static const int W = 4;
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static V set1(double a) { return _mm256_set1_pd(a); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static C czero() { return _mm256_setzero_si256(); }
+    static C cadd(C a, C b) { return _mm256_add_epi64(a, b); }
+    static C count_gt(C c, V x, V thr) {
+        return _mm256_sub_epi64(c, _mm256_castpd_si256(_mm256_cmp_pd(x, thr, _CMP_GT_OQ)));
+    }
+    static double hadd(V a) {
+        return simd<double, 128>::hadd(
+            _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1)));
+    }
+    static double hmax(V a) {
+        return simd<double, 128>::hmax(
+            _mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1)));
+    }
+    static int64_t hcount(C c) {
+        return simd<double, 128>::hcount(
+            _mm_add_epi64(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1)));
+    }
+};
+
+template <>
+struct simd<int32_t, 128> {
+    typedef __m128i V;
+    typedef __m128i C;
+    static const int W = 4;
+    static V load(const int32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static V set1(int32_t a) { return _mm_set1_epi32(a); }
+    static V add(V a, V b) { return _mm_add_epi32(a, b); }
+    static V max(V a, V b) { return _mm_max_epi32(a, b); }
+    static C czero() { return _mm_setzero_si128(); }
+    static C cadd(C a, C b) { return _mm_add_epi32(a, b); }
+    static C count_gt(C c, V x, V thr) { return _mm_sub_epi32(c, _mm_cmpgt_epi32(x, thr)); }
+    static int32_t hadd(V a) {
+        a = _mm_add_epi32(a, _mm_shuffle_epi32(a, 0x4E));
+        return _mm_cvtsi128_si32(_mm_add_epi32(a, _mm_shuffle_epi32(a, 0xB1)));
+    }
+    static int32_t hmax(V a) {
+        a = _mm_max_epi32(a, _mm_shuffle_epi32(a, 0x4E));
+        return _mm_cvtsi128_si32(_mm_max_epi32(a, _mm_shuffle_epi32(a, 0xB1)));
+    }
+    static int64_t hcount(C c) { return simd<float, 128>::hcount(c); }
+};
+
+template <>
+struct simd<int32_t, 256> {
+    typedef __m256i V;
+    typedef __m256i C;
+    static const int W = 8;
+    static V load(const int32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static V set1(int32_t a) { return _mm256_set1_epi32(a); }
+    static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+    static V max(V a, V b) { return _mm256_max_epi32(a, b); }
+    static C czero() { return _mm256_setzero_si256(); }
+    static C cadd(C a, C b) { return _mm256_add_epi32(a, b); }
+    static C count_gt(C c, V x, V thr) { return _mm256_sub_epi32(c, _mm256_cmpgt_epi32(x, thr)); }
+    static int32_t hadd(V a) {
+        return simd<int32_t, 128>::hadd(
+            _mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1)));
+    }
+    static int32_t hmax(V a) {
+        return simd<int32_t, 128>::hmax(
+            _mm_max_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1)));
+    }
+    static int64_t hcount(C c) { return simd<float, 256>::hcount(c); }
+};
+
+// ============================================================================
+// Operators: accumulator type, identity, step, merge, horizontal finish
+// and the scalar tail step. `p` is the operator's parameter (threshold).
+// ============================================================================
+struct op_sum {
+    static const char* name() { return "sum"; }
+    template <class T> using result = T;
+    template <class S> using acc = typename S::V;
+    template <class S, class T> static acc<S> init() { return S::set1(T(0)); }
+    template <class S> static acc<S> step(acc<S> a, typename S::V x, typename S::V) {
+        return S::add(a, x);
+    }
+    template <class S> static acc<S> merge(acc<S> a, acc<S> b) { return S::add(a, b); }
+    template <class S, class T> static T finish(acc<S> a) { return S::hadd(a); }
+    template <class T> static T tail(T r, T x, T) { return r + x; }
+};
+
+struct op_max {
+    static const char* name() { return "max"; }
+    template <class T> using result = T;
+    template <class S> using acc = typename S::V;
+    template <class S, class T> static acc<S> init() {
+        return S::set1(std::numeric_limits<T>::lowest());
+    }
+    template <class S> static acc<S> step(acc<S> a, typename S::V x, typename S::V) {
+        return S::max(a, x);
+    }
+    template <class S> static acc<S> merge(acc<S> a, acc<S> b) { return S::max(a, b); }
+    template <class S, class T> static T finish(acc<S> a) { return S::hmax(a); }
+    template <class T> static T tail(T r, T x, T) { return x > r ? x : r; }
+};
+
+// Number of elements > p
+struct op_count {
+    static const char* name() { return "count"; }
+    template <class T> using result = int64_t;
+    template <class S> using acc = typename S::C;
+    template <class S, class T> static acc<S> init() { return S::czero(); }
+    template <class S> static acc<S> step(acc<S> a, typename S::V x, typename S::V thr) {
+        return S::count_gt(a, x, thr);
+    }
+    template <class S> static acc<S> merge(acc<S> a, acc<S> b) { return S::cadd(a, b); }
+    template <class S, class T> static int64_t finish(acc<S> a) { return S::hcount(a); }
+    template <class T> static int64_t tail(int64_t r, T x, T p) { return r + (x > p); }
+};
+
+// ============================================================================
+// The engine
+// ============================================================================
+
+// Reduce x[0, n) with K accumulators of BITS-wide vectors; p is passed
+// to the operator (threshold for op_count, ignored otherwise)
+template <class Op, class T, int K, int BITS>
+static typename Op::template result<T> reduce(const T* x, size_t n, T p = T(0)) {
+    typedef simd<T, BITS> S;
+    typedef typename Op::template acc<S> A;
+    const size_t W = S::W, step = K * S::W;
+    typename S::V pv = S::set1(p);
+    A acc[K];
+    static_for<0, K>::run([&](auto k) { acc[decltype(k)::value] = Op::template init<S, T>(); });
+    size_t i = 0;
+    for (; i + step <= n; i += step)
+        static_for<0, K>::run([&](auto k) {
+            const int j = decltype(k)::value;
+            acc[j] = Op::template step<S>(acc[j], S::load(x + i + j * W), pv);
+        });
+    for (; i + W <= n; i += W) acc[0] = Op::template step<S>(acc[0], S::load(x + i), pv);
+    static_for<1, K>::run([&](auto k) { acc[0] = Op::template merge<S>(acc[0], acc[decltype(k)::value]); });
+    typename Op::template result<T> r = Op::template finish<S, T>(acc[0]);
+    for (; i < n; i++) r = Op::tail(r, x[i], p);
+    return r;
+}
+
+// ============================================================================
+// Autotune
+// ============================================================================
+
+const int REDUCE_TUNE_K[] = {1, 2, 4, 8, 16};
+const int REDUCE_TUNE_COUNT = 5;
+
+template <class Op, class T, int BITS>
+struct reduce_table {
+    typedef typename Op::template result<T> (*fn)(const T*, size_t, T);
+    static fn at(int idx) {
+        static const fn table[REDUCE_TUNE_COUNT] = {
+            reduce<Op, T, 1, BITS>, reduce<Op, T, 2, BITS>, reduce<Op, T, 4, BITS>,
+            reduce<Op, T, 8, BITS>, reduce<Op, T, 16, BITS>};
+        return table[idx];
+    }
+};
+
+// Best time (ns) of fn over x[0, n): 5 tries of ~200K elements each,
+// tens of microseconds from L1, so autotuning stays cheap on first call
+template <class F, class T>
+static double reduce_time_ns(F fn, const T* x, size_t n, T p) {
+    volatile double sink = 0;
+    double best = 1e30;
+    int reps = (int)(200000 / n) + 1;
+    for (int t = 0; t < 5; t++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; r++) sink = sink + (double)fn(x, n, p);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0)
+                        .count() / reps;
+        best = ns < best ? ns : best;
+    }
+    return best;
+}
+
+// Smallest accumulator count within 5% of the fastest on an L1-resident
+// buffer (4096 elements): the point where the FP/ALU ports saturate.
+// times_ns, if given, receives the time per REDUCE_TUNE_K entry.
+template <class Op, class T, int BITS>
+static int reduce_autotune(double* times_ns = nullptr) {
+    const size_t n = 4096;
+    alignas(64) static T buf[n];
+    for (size_t i = 0; i < n; i++) buf[i] = (T)(i % 17);
+    double t[REDUCE_TUNE_COUNT], best = 1e30;
+    for (int k = 0; k < REDUCE_TUNE_COUNT; k++) {
+        t[k] = reduce_time_ns(reduce_table<Op, T, BITS>::at(k), buf, n, T(8));
+        best = t[k] < best ? t[k] : best;
+        if (times_ns) times_ns[k] = t[k];
+    }
+    for (int k = 0; k < REDUCE_TUNE_COUNT; k++)
+        if (t[k] <= 1.05 * best) return REDUCE_TUNE_K[k];
+    return REDUCE_TUNE_K[REDUCE_TUNE_COUNT - 1];
+}
+
+// reduce<Op, T, K, BITS> with K from reduce_autotune(), tuned on first call
+template <class Op, class T, int BITS = 256>
+static typename Op::template result<T> reduce_auto(const T* x, size_t n, T p = T(0)) {
+    static const typename reduce_table<Op, T, BITS>::fn fn = [] {
+        int k = reduce_autotune<Op, T, BITS>(), idx = 0;
+        while (REDUCE_TUNE_K[idx] != k) idx++;
+        return reduce_table<Op, T, BITS>::at(idx);
+    }();
+    return fn(x, n, p);
+}
+
+#endif // REDUCE_H
@@ -0,0 +1,126 @@
+// reduce_bench.cpp - sum / max / count x type x width x accumulators, one template
+// Compile: g++ -O3 -std=c++14 -mavx2 -mfma -fno-tree-vectorize reduce_bench.cpp -o reduce_bench
+// Run: ./reduce_bench [n]      (n for the in-memory pass, default 100M)
+//
+// Every cell is reduce<Op, T, K, BITS> from reduce.h on a 4096-element
+// L1-resident buffer, in elements per ns. -fno-tree-vectorize keeps the
+// scalar (BITS = 0) rows scalar; the SIMD rows use intrinsics directly.
+// "pick" is reduce_autotune()'s choice: the smallest K within 5% of the
+// best, i.e. where the add / max / compare ports saturate.
+//
+// The last table runs the autotuned AVX2 kernels over n elements from
+// memory, where (as sum_v3 notes) bandwidth, not ILP, sets the speed.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "reduce.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const char* type_name(float) { return "float"; }
+static const char* type_name(double) { return "double"; }
+static const char* type_name(int32_t) { return "int32"; }
+
+static bool results_match(double a, double b) {
+    return a == b || fabs(a - b) <= 1e-5 * fabs(b);
+}
+
+// One row: all K for <Op, T, BITS>, checked against scalar K = 1 on an
+// odd length so the vector and scalar tails both run
+template <class Op, class T, int BITS>
+static void row() {
+    double ns[REDUCE_TUNE_COUNT];
+    int pick = reduce_autotune<Op, T, BITS>(ns);
+
+    const size_t n = 4099;
+    static T x[n];
+    for (size_t i = 0; i < n; i++) x[i] = (T)((i * 7919) % 1001) / (T)8;
+    T p = (T)50;
+    double ref = (double)reduce<Op, T, 1, 0>(x, n, p);
+    bool ok = true;
+    for (int k = 0; k < REDUCE_TUNE_COUNT; k++)
+        ok &= results_match((double)reduce_table<Op, T, BITS>::at(k)(x, n, p), ref);
+
+    const char* width = BITS == 0 ? "scalar" : BITS == 128 ? "SSE" : "AVX2";
+    printf("║ %-5s %-6s %-6s", Op::name(), type_name(T()), width);
+    for (int k = 0; k < REDUCE_TUNE_COUNT; k++) printf(" %6.2f", 4096 / ns[k]);
+    printf("  %4d %-4s ║\n", pick, ok ? "ok" : "FAIL");
+}
+
+template <class Op, class T>
+static void rows() {
+    row<Op, T, 0>();
+    row<Op, T, 128>();
+    row<Op, T, 256>();
+}
+
+template <class Op>
+static void rows_for_types() {
+    rows<Op, float>();
+    rows<Op, double>();
+    rows<Op, int32_t>();
+}
+
+// K = 1 scalar (sum_v1 style) vs autotuned AVX2 over n elements, GB/s
+template <class Op, class T>
+static void memory_row(size_t n) {
+    T* x = (T*)aligned_alloc(64, (n * sizeof(T) + 63) / 64 * 64);
+    if (!x) abort();
+    for (size_t i = 0; i < n; i++) x[i] = (T)(i % 1001) / (T)8;
+    T p = (T)50;
+    reduce_auto<Op, T, 256>(x, 1024, p);  // tune outside the timing
+
+    double t_scalar = 1e30, t_auto = 1e30;
+    volatile double sink = 0;
+    for (int r = 0; r < 3; r++) {
+        double t0 = now();
+        sink = sink + (double)reduce<Op, T, 1, 0>(x, n, p);
+        double t1 = now();
+        sink = sink + (double)reduce_auto<Op, T, 256>(x, n, p);
+        double t2 = now();
+        t_scalar = min(t_scalar, t1 - t0);
+        t_auto = min(t_auto, t2 - t1);
+    }
+    double bytes = (double)n * sizeof(T);
+    printf("║ %-6s %-7s   %8.1f   %8.1f   %6.1fx                    ║\n", Op::name(),
+           type_name(T()), bytes / t_scalar / 1e9, bytes / t_auto / 1e9, t_scalar / t_auto);
+    free(x);
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000000;
+
+    printf("\n");
+    printf("╔═══════════════════════════════════════════════════════════════════╗\n");
+    printf("║  reduce<Op, T, K, BITS>: elements/ns, 4096 elements in L1         ║\n");
+    printf("╟───────────────────────────────────────────────────────────────────╢\n");
+    printf("║ op    type   width     K=1    K=2    K=4    K=8   K=16  pick chk  ║\n");
+    printf("╟───────────────────────────────────────────────────────────────────╢\n");
+    rows_for_types<op_sum>();
+    printf("╟───────────────────────────────────────────────────────────────────╢\n");
+    rows_for_types<op_max>();
+    printf("╟───────────────────────────────────────────────────────────────────╢\n");
+    rows_for_types<op_count>();
+    printf("╚═══════════════════════════════════════════════════════════════════╝\n");
+
+    printf("\n");
+    printf("╔═══════════════════════════════════════════════════════════════════╗\n");
+    printf("║  %9zu elements from memory: GB/s                             ║\n", n);
+    printf("╟───────────────────────────────────────────────────────────────────╢\n");
+    printf("║ op     type      scalar K=1  AVX2 auto  speedup                   ║\n");
+    printf("╟───────────────────────────────────────────────────────────────────╢\n");
+    memory_row<op_sum, float>(n);
+    memory_row<op_sum, double>(n);
+    memory_row<op_max, float>(n);
+    memory_row<op_max, double>(n);
+    memory_row<op_count, float>(n);
+    memory_row<op_count, int32_t>(n);
+    printf("╚═══════════════════════════════════════════════════════════════════╝\n");
+    return 0;
+}
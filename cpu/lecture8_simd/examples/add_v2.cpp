@@ -1,20 +1,30 @@
 // add_v2.cpp - SIMD vector addition using AVX
 // Compile: g++ -O1 -mavx2 add_v2.cpp -o add_v2
 // Run: ./add_v2
+//
+// Any n: the loop (simd_loop.h) peels to the 32-byte boundary of c, stores
+// aligned, and finishes with one masked vector.
 
 #include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <immintrin.h>
+#include "simd_loop.h"
 using namespace std;
 
 void add_simd(double* a, double* b, double* c, int n) {
-    for (int i = 0; i < n; i += 4) {
-        __m256d va = _mm256_loadu_pd(a + i);
-        __m256d vb = _mm256_loadu_pd(b + i);
-        __m256d vc = _mm256_add_pd(va, vb);
-        _mm256_storeu_pd(c + i, vc);
-    }
+    sl_for<double, 2>(c, n,
+        [&](size_t i, int) {
+            __m256d va = _mm256_loadu_pd(a + i);
+            __m256d vb = _mm256_loadu_pd(b + i);
+            __m256d vc = _mm256_add_pd(va, vb);
+            _mm256_store_pd(c + i, vc);  // c + i is 32-byte aligned
+        },
+        [&](size_t i, __m256i m) {
+            __m256d va = _mm256_maskload_pd(a + i, m);
+            __m256d vb = _mm256_maskload_pd(b + i, m);
+            _mm256_maskstore_pd(c + i, m, _mm256_add_pd(va, vb));
+        });
 }
 
 int main() {
@@ -0,0 +1,267 @@
+// compact.h - Stream compaction: keep x[i] > threshold, with their indices
+//
+// conditional_simd blends and keeps every element; a filter must write
+// only the survivors, packed to the left:
+//
+//   x      0.7 0.2 0.9 0.1 0.6 0.3 0.8 0.4     threshold 0.5
+//   mask     1   0   1   0   1   0   1   0  -> 0x55
+//   lut    [0, 2, 4, 6, 0, 0, 0, 0]         -> vpermps -> 0.7 0.9 0.6 0.8 ...
+//
+// AVX2 has no compress instruction, so the 8-bit compare mask indexes a
+// 256-entry table of vpermd/vpermps lane orders (8 KB, stays in L1). The
+// full vector is stored at out + k and k advances by popcount(mask): the
+// garbage lanes are overwritten by the next store. Since k <= i, a store
+// never passes index i + 8, so an output sized like the input is enough.
+// Doubles (4 lanes) reuse the table: mask bit j becomes bits 2j, 2j+1,
+// selecting both float halves of lane j.
+//
+// AVX-512 has the instruction: vcompressps / pd / d packs the selected
+// lanes in one step; the compressed register is then stored with a plain
+// (or, in the tail, masked) store, which is much faster than a compress
+// straight to memory.
+//
+// compact_dispatch() binds AVX-512, AVX2 or scalar through isa_selected()
+// (isa_dispatch.h); SSE2 has no variable lane permute and gets scalar.
+// idx may be NULL when only values are wanted.
+
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <immintrin.h>
+#include <cstddef>
+#include <cstdint>
+#include "isa_dispatch.h"
+
+#define COMPACT_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#define COMPACT_AVX2 __attribute__((target("avx2,popcnt")))
+#define COMPACT_AVX512 __attribute__((target("avx512f,popcnt")))
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+// The if-statement filter: one unpredictable branch per element near 50%
+template <class T>
+COMPACT_SCALAR static size_t compact_branchy(const T* x, size_t n, T threshold, T* out,
+                                             uint32_t* idx) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++)
+        if (x[i] > threshold) {
+            out[k] = x[i];
+            if (idx) idx[k] = (uint32_t)i;
+            k++;
+        }
+    return k;
+}
+
+// Always store, advance k by the predicate: no branch to mispredict.
+// Elements [i, n) after k already kept; returns the new k.
+template <class T>
+COMPACT_SCALAR static size_t compact_branchless_from(const T* x, size_t i, size_t n, T threshold,
+                                                     T* out, uint32_t* idx, size_t k) {
+    for (; i < n; i++) {
+        out[k] = x[i];
+        if (idx) idx[k] = (uint32_t)i;
+        k += x[i] > threshold;
+    }
+    return k;
+}
+
+template <class T>
+static size_t compact_branchless(const T* x, size_t n, T threshold, T* out, uint32_t* idx) {
+    return compact_branchless_from(x, 0, n, threshold, out, idx, 0);
+}
+
+// ============================================================================
+// AVX2: permutation lookup table
+// ============================================================================
+
+struct compact_lut_t {
+    alignas(32) int32_t perm[256][8];  // lanes of set bits in order, then 0
+    uint8_t widen[16];                 // 4-bit double mask -> 8-bit float mask
+};
+
+static const compact_lut_t& compact_lut() {
+    static const compact_lut_t lut = [] {
+        compact_lut_t t = {};
+        for (int m = 0; m < 256; m++) {
+            int k = 0;
+            for (int b = 0; b < 8; b++)
+                if (m & (1 << b)) t.perm[m][k++] = b;
+        }
+        for (int m = 0; m < 16; m++)
+            for (int b = 0; b < 4; b++)
+                if (m & (1 << b)) t.widen[m] |= (uint8_t)(3 << (2 * b));
+        return t;
+    }();
+    return lut;
+}
+
+COMPACT_AVX2 static inline __m256i compact_perm(const compact_lut_t& lut, int mask) {
+    return _mm256_load_si256((const __m256i*)lut.perm[mask]);
+}
+
+COMPACT_AVX2 static size_t compact_avx2_f32(const float* x, size_t n, float threshold,
+                                            float* out, uint32_t* idx) {
+    const compact_lut_t& lut = compact_lut();
+    __m256 thr = _mm256_set1_ps(threshold);
+    __m256i vi = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), step = _mm256_set1_epi32(8);
+    size_t k = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        int m = _mm256_movemask_ps(_mm256_cmp_ps(v, thr, _CMP_GT_OQ));
+        __m256i p = compact_perm(lut, m);
+        _mm256_storeu_ps(out + k, _mm256_permutevar8x32_ps(v, p));
+        if (idx) _mm256_storeu_si256((__m256i*)(idx + k), _mm256_permutevar8x32_epi32(vi, p));
+        k += _mm_popcnt_u32(m);
+        vi = _mm256_add_epi32(vi, step);
+    }
+    return compact_branchless_from(x, i, n, threshold, out, idx, k);
+}
+
+COMPACT_AVX2 static size_t compact_avx2_i32(const int32_t* x, size_t n, int32_t threshold,
+                                            int32_t* out, uint32_t* idx) {
+    const compact_lut_t& lut = compact_lut();
+    __m256i thr = _mm256_set1_epi32(threshold);
+    __m256i vi = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), step = _mm256_set1_epi32(8);
+    size_t k = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(x + i));
+        int m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, thr)));
+        __m256i p = compact_perm(lut, m);
+        _mm256_storeu_si256((__m256i*)(out + k), _mm256_permutevar8x32_epi32(v, p));
+        if (idx) _mm256_storeu_si256((__m256i*)(idx + k), _mm256_permutevar8x32_epi32(vi, p));
+        k += _mm_popcnt_u32(m);
+        vi = _mm256_add_epi32(vi, step);
+    }
+    return compact_branchless_from(x, i, n, threshold, out, idx, k);
+}
+
+COMPACT_AVX2 static size_t compact_avx2_f64(const double* x, size_t n, double threshold,
+                                            double* out, uint32_t* idx) {
+    const compact_lut_t& lut = compact_lut();
+    __m256d thr = _mm256_set1_pd(threshold);
+    __m128i vi = _mm_setr_epi32(0, 1, 2, 3), step = _mm_set1_epi32(4);
+    size_t k = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        int m = _mm256_movemask_pd(_mm256_cmp_pd(v, thr, _CMP_GT_OQ));
+        __m256i p = compact_perm(lut, lut.widen[m]);
+        _mm256_storeu_pd(out + k, _mm256_castps_pd(
+                                      _mm256_permutevar8x32_ps(_mm256_castpd_ps(v), p)));
+        if (idx) {
+            // perm[m] (m < 16) only names lanes 0..3: the 4 indices
+            __m256i q = _mm256_permutevar8x32_epi32(_mm256_zextsi128_si256(vi),
+                                                    compact_perm(lut, m));
+            _mm_storeu_si128((__m128i*)(idx + k), _mm256_castsi256_si128(q));
+        }
+        k += _mm_popcnt_u32(m);
+        vi = _mm_add_epi32(vi, step);
+    }
+    return compact_branchless_from(x, i, n, threshold, out, idx, k);
+}
+
+// ============================================================================
+// AVX-512: vcompress
+// ============================================================================
+
+COMPACT_AVX512 static size_t compact_avx512_f32(const float* x, size_t n, float threshold,
+                                                float* out, uint32_t* idx) {
+    __m512 thr = _mm512_set1_ps(threshold);
+    __m512i vi = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i step = _mm512_set1_epi32(16);
+    size_t k = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(x + i);
+        __mmask16 m = _mm512_cmp_ps_mask(v, thr, _CMP_GT_OQ);
+        _mm512_storeu_ps(out + k, _mm512_maskz_compress_ps(m, v));
+        if (idx) _mm512_storeu_si512(idx + k, _mm512_maskz_compress_epi32(m, vi));
+        k += _mm_popcnt_u32(m);
+        vi = _mm512_add_epi32(vi, step);
+    }
+    if (i < n) {
+        __mmask16 tail = (__mmask16)((1u << (n - i)) - 1);
+        __m512 v = _mm512_maskz_loadu_ps(tail, x + i);
+        __mmask16 m = _mm512_mask_cmp_ps_mask(tail, v, thr, _CMP_GT_OQ);
+        __mmask16 keep = (__mmask16)((1u << _mm_popcnt_u32(m)) - 1);
+        _mm512_mask_storeu_ps(out + k, keep, _mm512_maskz_compress_ps(m, v));
+        if (idx) _mm512_mask_storeu_epi32(idx + k, keep, _mm512_maskz_compress_epi32(m, vi));
+        k += _mm_popcnt_u32(m);
+    }
+    return k;
+}
+
+COMPACT_AVX512 static size_t compact_avx512_i32(const int32_t* x, size_t n, int32_t threshold,
+                                                int32_t* out, uint32_t* idx) {
+    __m512i thr = _mm512_set1_epi32(threshold);
+    __m512i vi = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i step = _mm512_set1_epi32(16);
+    size_t k = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(x + i);
+        __mmask16 m = _mm512_cmpgt_epi32_mask(v, thr);
+        _mm512_storeu_si512(out + k, _mm512_maskz_compress_epi32(m, v));
+        if (idx) _mm512_storeu_si512(idx + k, _mm512_maskz_compress_epi32(m, vi));
+        k += _mm_popcnt_u32(m);
+        vi = _mm512_add_epi32(vi, step);
+    }
+    if (i < n) {
+        __mmask16 tail = (__mmask16)((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(tail, x + i);
+        __mmask16 m = _mm512_mask_cmpgt_epi32_mask(tail, v, thr);
+        __mmask16 keep = (__mmask16)((1u << _mm_popcnt_u32(m)) - 1);
+        _mm512_mask_storeu_epi32(out + k, keep, _mm512_maskz_compress_epi32(m, v));
+        if (idx) _mm512_mask_storeu_epi32(idx + k, keep, _mm512_maskz_compress_epi32(m, vi));
+        k += _mm_popcnt_u32(m);
+    }
+    return k;
+}
+
+COMPACT_AVX512 static size_t compact_avx512_f64(const double* x, size_t n, double threshold,
+                                                double* out, uint32_t* idx) {
+    __m512d thr = _mm512_set1_pd(threshold);
+    __m512i vi = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m512i step = _mm512_set1_epi32(8);
+    size_t k = 0, i = 0;
+    for (; i < n; i += 8) {
+        __mmask8 tail = n - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m512d v = _mm512_maskz_loadu_pd(tail, x + i);
+        __mmask8 m = _mm512_mask_cmp_pd_mask(tail, v, thr, _CMP_GT_OQ);
+        if (tail == 0xFF) _mm512_storeu_pd(out + k, _mm512_maskz_compress_pd(m, v));
+        else _mm512_mask_storeu_pd(out + k, (__mmask8)((1u << _mm_popcnt_u32(m)) - 1),
+                                   _mm512_maskz_compress_pd(m, v));
+        // 8 indices: a masked 16-lane store writes only the packed ones
+        if (idx) _mm512_mask_storeu_epi32(idx + k, (__mmask16)((1u << _mm_popcnt_u32(m)) - 1),
+                                          _mm512_maskz_compress_epi32(m, vi));
+        k += _mm_popcnt_u32(m);
+        vi = _mm512_add_epi32(vi, step);
+    }
+    return k;
+}
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+struct compact_kernels {
+    isa_level isa;
+    size_t (*f32)(const float* x, size_t n, float threshold, float* out, uint32_t* idx);
+    size_t (*f64)(const double* x, size_t n, double threshold, double* out, uint32_t* idx);
+    size_t (*i32)(const int32_t* x, size_t n, int32_t threshold, int32_t* out, uint32_t* idx);
+};
+
+// Kernels for `level`: AVX-512 and AVX2 their own, anything lower scalar
+static inline compact_kernels compact_kernels_for(isa_level level) {
+    if (level >= ISA_AVX512)
+        return {ISA_AVX512, compact_avx512_f32, compact_avx512_f64, compact_avx512_i32};
+    if (level >= ISA_AVX2) return {ISA_AVX2, compact_avx2_f32, compact_avx2_f64, compact_avx2_i32};
+    return {ISA_SCALAR, compact_branchless<float>, compact_branchless<double>,
+            compact_branchless<int32_t>};
+}
+
+static inline const compact_kernels& compact_dispatch() {
+    static const compact_kernels bound = compact_kernels_for(isa_selected());
+    return bound;
+}
+
+#endif // COMPACT_H
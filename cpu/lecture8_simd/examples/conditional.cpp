@@ -4,12 +4,15 @@
 //
 // Demonstrates how to handle if/else in SIMD using blendv.
 // Instead of branching, compute both paths and select with a mask.
+// The same blend runs on the masked peel and tail (simd_loop.h), so n
+// need not be a multiple of 4.
 
 #include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <random>
 #include <immintrin.h>
+#include "simd_loop.h"
 using namespace std;
 
 // Scalar version with branch
@@ -28,18 +31,19 @@ void conditional_simd(double* a, double* b, int n) {
     __m256d ones = _mm256_set1_pd(1.0);
     __m256d mones = _mm256_set1_pd(-1.0);
 
-    for (int i = 0; i < n; i += 4) {
-        __m256d v = _mm256_loadu_pd(a + i);
-
+    auto update = [&](__m256d v) {
         // Compare: creates mask (all 1s or all 0s per element)
         __m256d mask = _mm256_cmp_pd(v, threshold, _CMP_GT_OQ);
 
         // Blend: select from ones or mones based on mask
         __m256d delta = _mm256_blendv_pd(mones, ones, mask);
 
-        __m256d result = _mm256_add_pd(v, delta);
-        _mm256_storeu_pd(b + i, result);
-    }
+        return _mm256_add_pd(v, delta);
+    };
+
+    sl_for<double, 2>(b, n,
+        [&](size_t i, int) { _mm256_store_pd(b + i, update(_mm256_loadu_pd(a + i))); },
+        [&](size_t i, __m256i m) { _mm256_maskstore_pd(b + i, m, update(_mm256_maskload_pd(a + i, m))); });
 }
 
 int main() {
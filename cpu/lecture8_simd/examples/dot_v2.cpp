@@ -3,22 +3,29 @@
 // Run: ./dot_v2
 //
 // Uses FMA (fused multiply-add): vsum = a*b + vsum in one instruction.
+// Any n: the loop is aligned on a (b is read unaligned), and peel and
+// tail are masked loads, 0 * 0 in the missing lanes.
 
 #include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <immintrin.h>
+#include "simd_loop.h"
 using namespace std;
 
 double dot_simd(double* a, double* b, int n) {
     __m256d vsum = _mm256_setzero_pd();
 
-    for (int i = 0; i < n; i += 4) {
-        __m256d va = _mm256_loadu_pd(a + i);
-        __m256d vb = _mm256_loadu_pd(b + i);
-        // FMA: vsum = va * vb + vsum (one instruction!)
-        vsum = _mm256_fmadd_pd(va, vb, vsum);
-    }
+    sl_for<double>(a, n,
+        [&](size_t i, int) {
+            __m256d va = _mm256_load_pd(a + i);
+            __m256d vb = _mm256_loadu_pd(b + i);
+            // FMA: vsum = va * vb + vsum (one instruction!)
+            vsum = _mm256_fmadd_pd(va, vb, vsum);
+        },
+        [&](size_t i, __m256i m) {
+            vsum = _mm256_fmadd_pd(_mm256_maskload_pd(a + i, m), _mm256_maskload_pd(b + i, m), vsum);
+        });
 
     // Horizontal reduction
     __m128d low = _mm256_castpd256_pd128(vsum);
@@ -0,0 +1,484 @@
+// expr.h - Expression templates: elementwise array expressions as one fused AVX2 loop
+//
+//   ex_array<float> x(n), z(n), w(n), y(n);
+//   y = a * x + b * z - relu(w);
+//
+// computes nothing until the assignment: every operator returns a small
+// node holding its operands (arrays as pointer + length, scalars by
+// value), and assigning the finished tree runs one loop that loads x, z
+// and w, does all the arithmetic in registers and stores y. An array
+// type whose operators return arrays makes a memory pass per operator
+// instead, with a temporary for each intermediate; in the expression
+// above, five passes and four temporaries.
+//
+// Each node has eval(at), its value for one vector of elements. `at` is
+// either a full vector at element i or the tail (maskload, missing lanes
+// read as 0), so the last n % W elements take one masked iteration
+// rather than a scalar loop. a * b + c and a * b - c become one FMA.
+//
+// Element types are float and double, one per expression. Operators:
+// + - * / with arrays or scalars on either side, unary -, comparisons
+// > < >= <= (masks, for where(m, a, b)), maximum, minimum, relu, abs,
+// sqrt, and exp, tanh, sigmoid, gelu from vmath.h.
+//
+// y = e runs in the calling thread, ex_assign(pool, y, e) splits it over
+// a thread_pool. y may appear in e (y = a * x + y): each element is read
+// before it is written. Outputs of at least EX_STREAM_BYTES use
+// non-temporal stores when 32-byte aligned (ex_array always is), as in
+// scan.h: the result is not read back soon, and the stores skip the
+// read-for-ownership of every output line. Every array in the expression
+// is prefetched EX_PREFETCH bytes ahead, once per cache line: the more
+// arithmetic per element, the fewer misses the loop keeps in flight on
+// its own (the fused saxpy -> conditional -> scale chain in expr_bench
+// is about 20% slower without it).
+//
+// Needs -mavx2 -mfma and thread_pool.h (cpu/lecture10_roofline/examples, via -I).
+
+#ifndef EXPR_H
+#define EXPR_H
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include "simd_loop.h"
+#include "thread_pool.h"
+#include "vmath.h"
+
+template <class T>
+struct ex_simd;
+
+template <>
+struct ex_simd<float> {
+    typedef __m256 V;
+    static const size_t W = 8;
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static V load_tail(const float* p, __m256i m) { return _mm256_maskload_ps(p, m); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static void stream(float* p, V v) { _mm256_stream_ps(p, v); }
+    static void store_tail(float* p, __m256i m, V v) { _mm256_maskstore_ps(p, m, v); }
+    static V set1(float a) { return _mm256_set1_ps(a); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    static V fmsub(V a, V b, V c) { return _mm256_fmsub_ps(a, b, c); }
+    static V fnmadd(V a, V b, V c) { return _mm256_fnmadd_ps(a, b, c); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+    static V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V neg(V a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+    static V abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+    template <int P>
+    static V cmp(V a, V b) { return _mm256_cmp_ps(a, b, P); }
+    static V select(V m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+    static V exp(V a) { return vm_exp_ps(a); }
+    static V tanh(V a) { return vm_tanh_ps(a); }
+    static V sigmoid(V a) { return vm_sigmoid_ps(a); }
+    static V gelu(V a) { return vm_gelu_ps(a); }
+};
+
+template <>
+struct ex_simd<double> {
+    typedef __m256d V;
+    static const size_t W = 4;
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static V load_tail(const double* p, __m256i m) { return _mm256_maskload_pd(p, m); }
+    static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static void stream(double* p, V v) { _mm256_stream_pd(p, v); }
+    static void store_tail(double* p, __m256i m, V v) { _mm256_maskstore_pd(p, m, v); }
+    static V set1(double a) { return _mm256_set1_pd(a); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+    static V fmsub(V a, V b, V c) { return _mm256_fmsub_pd(a, b, c); }
+    static V fnmadd(V a, V b, V c) { return _mm256_fnmadd_pd(a, b, c); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static V min(V a, V b) { return _mm256_min_pd(a, b); }
+    static V neg(V a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+    static V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+    template <int P>
+    static V cmp(V a, V b) { return _mm256_cmp_pd(a, b, P); }
+    static V select(V m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+    static V exp(V a) { return vm_exp_pd(a); }
+    static V tanh(V a) { return vm_tanh_pd(a); }
+    static V sigmoid(V a) { return vm_sigmoid_pd(a); }
+    static V gelu(V a) { return vm_gelu_pd(a); }
+};
+
+// Where eval() reads: the full vector at element i, or the masked tail at i
+struct ex_full {
+    size_t i;
+};
+struct ex_tail {
+    size_t i;
+    __m256i m;
+};
+
+template <class T>
+static inline typename ex_simd<T>::V ex_load(const T* p, ex_full at) {
+    return ex_simd<T>::load(p + at.i);
+}
+template <class T>
+static inline typename ex_simd<T>::V ex_load(const T* p, ex_tail at) {
+    return ex_simd<T>::load_tail(p + at.i, at.m);
+}
+
+// ============================================================
+// Operations
+// ============================================================
+
+struct ex_add {
+    template <class S, class V> static V apply(V a, V b) { return S::add(a, b); }
+};
+struct ex_sub {
+    template <class S, class V> static V apply(V a, V b) { return S::sub(a, b); }
+};
+struct ex_mul {
+    template <class S, class V> static V apply(V a, V b) { return S::mul(a, b); }
+};
+struct ex_div {
+    template <class S, class V> static V apply(V a, V b) { return S::div(a, b); }
+};
+struct ex_max {
+    template <class S, class V> static V apply(V a, V b) { return S::max(a, b); }
+};
+struct ex_min {
+    template <class S, class V> static V apply(V a, V b) { return S::min(a, b); }
+};
+template <int P>
+struct ex_cmp {
+    template <class S, class V> static V apply(V a, V b) { return S::template cmp<P>(a, b); }
+};
+
+struct ex_neg {
+    template <class S, class V> static V apply(V a) { return S::neg(a); }
+};
+struct ex_abs {
+    template <class S, class V> static V apply(V a) { return S::abs(a); }
+};
+struct ex_sqrt {
+    template <class S, class V> static V apply(V a) { return S::sqrt(a); }
+};
+struct ex_relu {
+    template <class S, class V> static V apply(V a) { return S::max(a, S::set1(0)); }
+};
+struct ex_exp {
+    template <class S, class V> static V apply(V a) { return S::exp(a); }
+};
+struct ex_tanh {
+    template <class S, class V> static V apply(V a) { return S::tanh(a); }
+};
+struct ex_sigmoid {
+    template <class S, class V> static V apply(V a) { return S::sigmoid(a); }
+};
+struct ex_gelu {
+    template <class S, class V> static V apply(V a) { return S::gelu(a); }
+};
+
+// ============================================================
+// Nodes
+// ============================================================
+
+template <class D>
+struct ex_base {
+    const D& self() const { return static_cast<const D&>(*this); }
+};
+
+template <class T>
+struct ex_scalar : ex_base<ex_scalar<T>> {
+    typedef T value_type;
+    T a;
+    explicit ex_scalar(T a) : a(a) {}
+    size_t size() const { return 0; }  // fits any length
+    void prefetch(size_t) const {}
+    template <class At>
+    typename ex_simd<T>::V eval(At) const { return ex_simd<T>::set1(a); }
+};
+
+template <class Op, class L, class R>
+struct ex_binary;
+
+// Op(l, r) for one vector; a * b + c, c + a * b, a * b - c and c - a * b fuse
+template <class Op, class L, class R, class At>
+static inline auto ex_eval(Op, const L& l, const R& r, At at) {
+    return Op::template apply<ex_simd<typename L::value_type>>(l.eval(at), r.eval(at));
+}
+template <class A, class B, class R, class At>
+static inline auto ex_eval(ex_add, const ex_binary<ex_mul, A, B>& l, const R& r, At at) {
+    return ex_simd<typename R::value_type>::fmadd(l.l.eval(at), l.r.eval(at), r.eval(at));
+}
+template <class L, class A, class B, class At>
+static inline auto ex_eval(ex_add, const L& l, const ex_binary<ex_mul, A, B>& r, At at) {
+    return ex_simd<typename L::value_type>::fmadd(r.l.eval(at), r.r.eval(at), l.eval(at));
+}
+template <class A, class B, class C, class D, class At>
+static inline auto ex_eval(ex_add, const ex_binary<ex_mul, A, B>& l,
+                           const ex_binary<ex_mul, C, D>& r, At at) {
+    return ex_simd<typename A::value_type>::fmadd(l.l.eval(at), l.r.eval(at), r.eval(at));
+}
+template <class A, class B, class R, class At>
+static inline auto ex_eval(ex_sub, const ex_binary<ex_mul, A, B>& l, const R& r, At at) {
+    return ex_simd<typename R::value_type>::fmsub(l.l.eval(at), l.r.eval(at), r.eval(at));
+}
+template <class L, class A, class B, class At>
+static inline auto ex_eval(ex_sub, const L& l, const ex_binary<ex_mul, A, B>& r, At at) {
+    return ex_simd<typename L::value_type>::fnmadd(r.l.eval(at), r.r.eval(at), l.eval(at));
+}
+template <class A, class B, class C, class D, class At>
+static inline auto ex_eval(ex_sub, const ex_binary<ex_mul, A, B>& l,
+                           const ex_binary<ex_mul, C, D>& r, At at) {
+    return ex_simd<typename A::value_type>::fmsub(l.l.eval(at), l.r.eval(at), r.eval(at));
+}
+
+template <class Op, class L, class R>
+struct ex_binary : ex_base<ex_binary<Op, L, R>> {
+    typedef typename L::value_type value_type;
+    static_assert(std::is_same<value_type, typename R::value_type>::value,
+                  "operands of different element types");
+    L l;
+    R r;
+    ex_binary(const L& l, const R& r) : l(l), r(r) {}
+    size_t size() const { return std::max(l.size(), r.size()); }
+    void prefetch(size_t i) const {
+        l.prefetch(i);
+        r.prefetch(i);
+    }
+    template <class At>
+    typename ex_simd<value_type>::V eval(At at) const { return ex_eval(Op(), l, r, at); }
+};
+
+template <class Op, class E>
+struct ex_unary : ex_base<ex_unary<Op, E>> {
+    typedef typename E::value_type value_type;
+    E e;
+    explicit ex_unary(const E& e) : e(e) {}
+    size_t size() const { return e.size(); }
+    void prefetch(size_t i) const { e.prefetch(i); }
+    template <class At>
+    typename ex_simd<value_type>::V eval(At at) const {
+        return Op::template apply<ex_simd<value_type>>(e.eval(at));
+    }
+};
+
+// m ? a : b per lane, m from a comparison
+template <class M, class A, class B>
+struct ex_where : ex_base<ex_where<M, A, B>> {
+    typedef typename A::value_type value_type;
+    M m;
+    A a;
+    B b;
+    ex_where(const M& m, const A& a, const B& b) : m(m), a(a), b(b) {}
+    size_t size() const { return std::max(m.size(), std::max(a.size(), b.size())); }
+    void prefetch(size_t i) const {
+        m.prefetch(i);
+        a.prefetch(i);
+        b.prefetch(i);
+    }
+    template <class At>
+    typename ex_simd<value_type>::V eval(At at) const {
+        return ex_simd<value_type>::select(m.eval(at), a.eval(at), b.eval(at));
+    }
+};
+
+// ============================================================
+// Arrays
+// ============================================================
+
+template <class T>
+struct ex_view;
+template <class T, class E>
+static void ex_assign(ex_view<T> dst, const ex_base<E>& e);
+
+// Non-owning: wraps existing memory; assignment writes through to it
+template <class T>
+struct ex_view : ex_base<ex_view<T>> {
+    typedef T value_type;
+    T* p;
+    size_t n;
+    ex_view(T* p, size_t n) : p(p), n(n) {}
+    ex_view(const ex_view&) = default;
+    size_t size() const { return n; }
+    T* data() const { return p; }
+    T& operator[](size_t i) const { return p[i]; }
+    void prefetch(size_t i) const { _mm_prefetch((const char*)(p + i), _MM_HINT_T0); }
+    template <class At>
+    typename ex_simd<T>::V eval(At at) const { return ex_load<T>(p, at); }
+
+    template <class E>
+    ex_view& operator=(const ex_base<E>& e) {
+        ex_assign(*this, e);
+        return *this;
+    }
+    ex_view& operator=(const ex_view& v) {
+        ex_assign(*this, v);
+        return *this;
+    }
+    ex_view& operator=(T a) {
+        ex_assign(*this, ex_scalar<T>(a));
+        return *this;
+    }
+};
+
+// Owning, 64-byte aligned, not copyable (assignment copies elements)
+template <class T>
+struct ex_array : ex_view<T> {
+    explicit ex_array(size_t n) : ex_view<T>(alloc(n), n) {}
+    ex_array(const ex_array&) = delete;
+    ~ex_array() { free(this->p); }
+    using ex_view<T>::operator=;
+    ex_array& operator=(const ex_array& a) {
+        ex_view<T>::operator=(a);
+        return *this;
+    }
+
+  private:
+    static T* alloc(size_t n) {
+        T* p = (T*)aligned_alloc(64, std::max<size_t>(64, (n * sizeof(T) + 63) / 64 * 64));
+        if (!p) abort();
+        return p;
+    }
+};
+
+// ============================================================
+// Operators and functions
+// ============================================================
+
+// name(e, e), name(e, scalar), name(scalar, e)
+#define EX_BINARY(name, Op)                                                                  \
+    template <class L, class R>                                                              \
+    static inline ex_binary<Op, L, R> name(const ex_base<L>& l, const ex_base<R>& r) {       \
+        return ex_binary<Op, L, R>(l.self(), r.self());                                      \
+    }                                                                                        \
+    template <class L>                                                                       \
+    static inline ex_binary<Op, L, ex_scalar<typename L::value_type>> name(                  \
+        const ex_base<L>& l, typename L::value_type a) {                                     \
+        return ex_binary<Op, L, ex_scalar<typename L::value_type>>(                          \
+            l.self(), ex_scalar<typename L::value_type>(a));                                 \
+    }                                                                                        \
+    template <class R>                                                                       \
+    static inline ex_binary<Op, ex_scalar<typename R::value_type>, R> name(                  \
+        typename R::value_type a, const ex_base<R>& r) {                                     \
+        return ex_binary<Op, ex_scalar<typename R::value_type>, R>(                          \
+            ex_scalar<typename R::value_type>(a), r.self());                                 \
+    }
+
+EX_BINARY(operator+, ex_add)
+EX_BINARY(operator-, ex_sub)
+EX_BINARY(operator*, ex_mul)
+EX_BINARY(operator/, ex_div)
+EX_BINARY(operator>, ex_cmp<_CMP_GT_OQ>)
+EX_BINARY(operator<, ex_cmp<_CMP_LT_OQ>)
+EX_BINARY(operator>=, ex_cmp<_CMP_GE_OQ>)
+EX_BINARY(operator<=, ex_cmp<_CMP_LE_OQ>)
+EX_BINARY(maximum, ex_max)
+EX_BINARY(minimum, ex_min)
+#undef EX_BINARY
+
+#define EX_UNARY(name, Op)                                                  \
+    template <class E>                                                      \
+    static inline ex_unary<Op, E> name(const ex_base<E>& e) {               \
+        return ex_unary<Op, E>(e.self());                                   \
+    }
+
+EX_UNARY(operator-, ex_neg)
+EX_UNARY(abs, ex_abs)
+EX_UNARY(sqrt, ex_sqrt)
+EX_UNARY(relu, ex_relu)
+EX_UNARY(exp, ex_exp)
+EX_UNARY(tanh, ex_tanh)
+EX_UNARY(sigmoid, ex_sigmoid)
+EX_UNARY(gelu, ex_gelu)
+#undef EX_UNARY
+
+template <class M, class A, class B>
+static inline ex_where<M, A, B> where(const ex_base<M>& m, const ex_base<A>& a,
+                                      const ex_base<B>& b) {
+    return ex_where<M, A, B>(m.self(), a.self(), b.self());
+}
+template <class M, class B>
+static inline ex_where<M, ex_scalar<typename M::value_type>, B> where(
+    const ex_base<M>& m, typename M::value_type a, const ex_base<B>& b) {
+    typedef ex_scalar<typename M::value_type> S;
+    return ex_where<M, S, B>(m.self(), S(a), b.self());
+}
+template <class M, class A>
+static inline ex_where<M, A, ex_scalar<typename M::value_type>> where(
+    const ex_base<M>& m, const ex_base<A>& a, typename M::value_type b) {
+    typedef ex_scalar<typename M::value_type> S;
+    return ex_where<M, A, S>(m.self(), a.self(), S(b));
+}
+template <class M>
+static inline ex_where<M, ex_scalar<typename M::value_type>, ex_scalar<typename M::value_type>>
+where(const ex_base<M>& m, typename M::value_type a, typename M::value_type b) {
+    typedef ex_scalar<typename M::value_type> S;
+    return ex_where<M, S, S>(m.self(), S(a), S(b));
+}
+
+// ============================================================
+// Evaluation
+// ============================================================
+
+const size_t EX_PREFETCH = 4096;          // bytes ahead of the loads
+const size_t EX_STREAM_BYTES = 8u << 20;  // outputs at least this large bypass the cache
+
+template <bool STREAM, class T, class E>
+static inline void ex_step(T* dst, const E& e, size_t i) {
+    typename ex_simd<T>::V v = e.eval(ex_full{i});
+    if (STREAM) ex_simd<T>::stream(dst + i, v);
+    else ex_simd<T>::store(dst + i, v);
+}
+
+// dst[lo, hi) = e[lo, hi): a 64-byte line (two vectors) per iteration with
+// a prefetch of every input array, then single vectors, then one masked
+template <bool STREAM, class T, class E>
+static void ex_kernel(T* dst, const E& e, size_t lo, size_t hi) {
+    typedef ex_simd<T> S;
+    size_t i = lo;
+    for (; i + 2 * S::W <= hi; i += 2 * S::W) {
+        e.prefetch(i + EX_PREFETCH / sizeof(T));
+        ex_step<STREAM>(dst, e, i);
+        ex_step<STREAM>(dst, e, i + S::W);
+    }
+    for (; i + S::W <= hi; i += S::W) ex_step<STREAM>(dst, e, i);
+    if (i < hi) {
+        ex_tail at = {i, sl_mask<T>(hi - i)};
+        S::store_tail(dst + i, at.m, e.eval(at));
+    }
+    if (STREAM) _mm_sfence();
+}
+
+template <class T>
+static bool ex_stream(ex_view<T> dst) {
+    return dst.n * sizeof(T) >= EX_STREAM_BYTES && (uintptr_t)dst.p % 32 == 0;
+}
+
+template <class T, class E>
+static void ex_assign(ex_view<T> dst, const ex_base<E>& e) {
+    assert(e.self().size() == 0 || e.self().size() == dst.n);
+    if (ex_stream(dst)) ex_kernel<true>(dst.p, e.self(), 0, dst.n);
+    else ex_kernel<false>(dst.p, e.self(), 0, dst.n);
+}
+
+// Threaded: every thread evaluates its chunk (boundaries on whole vectors)
+template <class T, class E>
+static void ex_assign(thread_pool& pool, ex_view<T> dst, const ex_base<E>& e) {
+    assert(e.self().size() == 0 || e.self().size() == dst.n);
+    bool stream = ex_stream(dst);
+    const E& x = e.self();
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(dst.n, pool.n, id, &lo, &hi);
+        if (stream) ex_kernel<true>(dst.p, x, lo, hi);
+        else ex_kernel<false>(dst.p, x, lo, hi);
+    });
+}
+
+#endif // EXPR_H
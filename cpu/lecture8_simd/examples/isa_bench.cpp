@@ -0,0 +1,146 @@
+// isa_bench.cpp - Every lecture-8 kernel at every SIMD level this CPU supports
+// Compile: g++ -O3 -std=c++14 isa_bench.cpp -o isa_bench      (no -m flags: runs on any x86-64)
+// Run: ./isa_bench [n]      (n for the in-memory table, default 20M)
+//      SIMD_ISA=sse2 ./isa_bench      (force the level simd_dispatch() binds)
+//
+// simd_kernels.h compiles each kernel for scalar, SSE2, AVX2 and AVX-512;
+// this prints them side by side. From L1 the width shows almost directly
+// (for the kernels that are not latency bound); from memory all levels
+// past SSE2 meet the same bandwidth wall, which is why dispatching to
+// AVX-512 pays off mainly for data already in cache. Levels the CPU lacks
+// print "-". Every result is checked against the scalar variant, element
+// by element for the kernels that write an array.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "simd_kernels.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct buffers {
+    double *a, *b, *c;
+    float *x, *y;
+};
+
+enum { K_ADD, K_SUM, K_DOT, K_SAXPY, K_COND, K_COUNT };
+static const char* kernel_names[K_COUNT] = {"add", "sum", "dot", "saxpy", "conditional"};
+static const double kernel_bytes[K_COUNT] = {24, 8, 16, 12, 16};  // per element
+
+// Runs kernel k once; returns a checksum of its output
+static double run(int k, const simd_kernels& t, buffers& m, size_t n) {
+    switch (k) {
+        case K_ADD: t.add(m.a, m.b, m.c, n); return m.c[0] + m.c[n / 2] + m.c[n - 1];
+        case K_SUM: return t.sum(m.a, n);
+        case K_DOT: return t.dot(m.a, m.b, n);
+        case K_SAXPY: t.saxpy(m.y, 0.5f, m.x, n); return m.y[0] + m.y[n / 2] + m.y[n - 1];
+        default: t.conditional(m.a, m.c, n); return m.c[0] + m.c[n / 2] + m.c[n - 1];
+    }
+}
+
+// Best seconds per call over `reps` timed batches of `calls` calls
+static double time_kernel(int k, const simd_kernels& t, buffers& m, size_t n, int calls,
+                          int reps) {
+    double best = 1e30;
+    volatile double sink = 0;
+    for (int r = 0; r < reps; r++) {
+        double t0 = now();
+        for (int c = 0; c < calls; c++) sink = sink + run(k, t, m, n);
+        best = min(best, (now() - t0) / calls);
+    }
+    return best;
+}
+
+// Output of kernel k at level l (fresh inputs) against the scalar variant:
+// the result of the reductions, every element of the array kernels.
+// saxpy and the reductions are reassociated / fused, hence the tolerance.
+static bool check(int k, isa_level l, buffers& m, size_t n) {
+    for (size_t i = 0; i < n; i++) m.c[i] = 0.0, m.y[i] = 1.0f;
+    double ref = run(k, simd_kernels_for(ISA_SCALAR), m, n);
+    vector<double> ref_c(m.c, m.c + n);
+    vector<float> ref_y(m.y, m.y + n);
+    for (size_t i = 0; i < n; i++) m.c[i] = 0.0, m.y[i] = 1.0f;
+    double got = run(k, simd_kernels_for(l), m, n);
+    if (k == K_SUM || k == K_DOT) return fabs(got - ref) <= 1e-6 * fabs(ref);
+    for (size_t i = 0; i < n; i++)
+        if (k == K_SAXPY ? fabsf(m.y[i] - ref_y[i]) > 1e-6f * fabsf(ref_y[i]) : m.c[i] != ref_c[i])
+            return false;
+    return true;
+}
+
+static void table(buffers& m, size_t n, bool from_memory) {
+    printf("║ %-12s", "kernel");
+    for (int l = 0; l < ISA_COUNT; l++) printf(" %9s", isa_names[l]);
+    printf("   %-16s║\n", "check");
+    printf("╟────────────────────────────────────────────────────────────────────────╢\n");
+    for (int k = 0; k < K_COUNT; k++) {
+        printf("║ %-12s", kernel_names[k]);
+        bool ok = true;
+        for (int l = 0; l < ISA_COUNT; l++) {
+            if (!isa_supported((isa_level)l)) {
+                printf(" %9s", "-");
+                continue;
+            }
+            ok &= check(k, (isa_level)l, m, n);
+            const simd_kernels& t = simd_kernels_for((isa_level)l);
+            double s = from_memory ? time_kernel(k, t, m, n, 1, 3)
+                                   : time_kernel(k, t, m, n, 2000, 5);
+            double v = from_memory ? kernel_bytes[k] * n / s / 1e9 : n / s / 1e9;
+            printf(" %8.2f%s", v, l == simd_dispatch().isa ? "*" : " ");
+        }
+        printf("   %-16s║\n", ok ? "ok" : "MISMATCH");
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t n_mem = argc > 1 ? strtoull(argv[1], NULL, 10) : 20000000;
+    const size_t n_l1 = 1000;  // 8 KB per double array: 3 arrays fit in L1
+    if (n_mem < n_l1) n_mem = n_l1;
+
+    buffers m;
+    m.a = (double*)aligned_alloc(64, (n_mem * sizeof(double) + 63) / 64 * 64);
+    m.b = (double*)aligned_alloc(64, (n_mem * sizeof(double) + 63) / 64 * 64);
+    m.c = (double*)aligned_alloc(64, (n_mem * sizeof(double) + 63) / 64 * 64);
+    m.x = (float*)aligned_alloc(64, (n_mem * sizeof(float) + 63) / 64 * 64);
+    m.y = (float*)aligned_alloc(64, (n_mem * sizeof(float) + 63) / 64 * 64);
+    if (!m.a || !m.b || !m.c || !m.x || !m.y) abort();
+    srand(42);
+    for (size_t i = 0; i < n_mem; i++) {
+        m.a[i] = rand() / (double)RAND_MAX;
+        m.b[i] = rand() / (double)RAND_MAX;
+        m.x[i] = (float)m.a[i];
+        m.y[i] = 1.0f;
+    }
+
+    const char* env = getenv("SIMD_ISA");
+    printf("\nCPU best level: %s, bound: %s%s%s%s\n", isa_names[isa_best()],
+           isa_names[simd_dispatch().isa], env ? " ($SIMD_ISA=" : "", env ? env : "",
+           env ? ")" : "");
+
+    printf("\n");
+    printf("╔════════════════════════════════════════════════════════════════════════╗\n");
+    printf("║  Elements/ns, %4zu elements (L1), * = level simd_dispatch() binds      ║\n", n_l1);
+    printf("╟────────────────────────────────────────────────────────────────────────╢\n");
+    table(m, n_l1, false);
+    printf("╚════════════════════════════════════════════════════════════════════════╝\n");
+
+    printf("\n");
+    printf("╔════════════════════════════════════════════════════════════════════════╗\n");
+    printf("║  GB/s, %10zu elements from memory                                 ║\n", n_mem);
+    printf("╟────────────────────────────────────────────────────────────────────────╢\n");
+    table(m, n_mem, true);
+    printf("╚════════════════════════════════════════════════════════════════════════╝\n");
+
+    free(m.a);
+    free(m.b);
+    free(m.c);
+    free(m.x);
+    free(m.y);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// isa_dispatch.h - Pick a SIMD level at run time: scalar / SSE2 / AVX2 / AVX-512
+//
+// The examples built with -mavx2 die with SIGILL on a CPU without AVX2,
+// and never use AVX-512 where it exists. A dispatched kernel is compiled
+// once per level (__attribute__((target(...))) on each variant, so the
+// file itself needs no -m flags), and a table of function pointers for
+// one level is chosen when the program starts.
+//
+// isa_selected() is the best level this CPU supports (cpuid, through
+// __builtin_cpu_supports), unless $SIMD_ISA asks for another:
+//
+//   SIMD_ISA=scalar | sse2 | avx2 | avx512 ./isa_bench
+//
+// A request above what the CPU has is lowered to the best supported
+// level, with a warning, rather than crashing.
+
+#ifndef ISA_DISPATCH_H
+#define ISA_DISPATCH_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+enum isa_level { ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_AVX512, ISA_COUNT };
+
+static const char* const isa_names[ISA_COUNT] = {"scalar", "sse2", "avx2", "avx512"};
+
+// AVX2 level includes FMA (every AVX2 CPU so far has it); AVX-512 is F only
+static inline bool isa_supported(isa_level level) {
+    __builtin_cpu_init();
+    switch (level) {
+        case ISA_SCALAR: return true;
+        case ISA_SSE2: return __builtin_cpu_supports("sse2");
+        case ISA_AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case ISA_AVX512: return __builtin_cpu_supports("avx512f");
+        default: return false;
+    }
+}
+
+static inline isa_level isa_best() {
+    int l = ISA_COUNT - 1;
+    while (l > ISA_SCALAR && !isa_supported((isa_level)l)) l--;
+    return (isa_level)l;
+}
+
+// $SIMD_ISA if set and supported, else the best level; evaluated once
+static inline isa_level isa_selected() {
+    static const isa_level level = [] {
+        isa_level best = isa_best();
+        const char* env = getenv("SIMD_ISA");
+        if (!env || !*env) return best;
+        for (int l = 0; l < ISA_COUNT; l++) {
+            if (strcmp(env, isa_names[l]) != 0) continue;
+            if (isa_supported((isa_level)l)) return (isa_level)l;
+            fprintf(stderr, "SIMD_ISA=%s not supported by this CPU, using %s\n", env,
+                    isa_names[best]);
+            return best;
+        }
+        fprintf(stderr, "SIMD_ISA=%s unknown (scalar, sse2, avx2, avx512), using %s\n", env,
+                isa_names[best]);
+        return best;
+    }();
+    return level;
+}
+
+#endif // ISA_DISPATCH_H
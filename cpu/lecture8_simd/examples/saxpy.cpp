@@ -3,11 +3,14 @@
 // Run: ./saxpy
 //
 // Classic BLAS operation, uses 8-way float SIMD with FMA.
+// The remainder is one masked vector instead of up to 7 scalar iterations,
+// and the loop peels to the 32-byte boundary of y to store aligned.
 
 #include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <immintrin.h>
+#include "simd_loop.h"
 using namespace std;
 
 // Scalar version
@@ -21,18 +24,18 @@ void saxpy_scalar(float* y, float a, float* x, int n) {
 void saxpy_simd(float* y, float a, float* x, int n) {
     __m256 va = _mm256_set1_ps(a);  // Broadcast a to all 8 lanes
 
-    int i = 0;
-    for (; i + 8 <= n; i += 8) {
-        __m256 vx = _mm256_loadu_ps(x + i);
-        __m256 vy = _mm256_loadu_ps(y + i);
-        vy = _mm256_fmadd_ps(va, vx, vy);  // y = a*x + y
-        _mm256_storeu_ps(y + i, vy);
-    }
-
-    // Handle remainder
-    for (; i < n; i++) {
-        y[i] = a * x[i] + y[i];
-    }
+    sl_for<float, 2>(y, n,
+        [&](size_t i, int) {
+            __m256 vx = _mm256_loadu_ps(x + i);
+            __m256 vy = _mm256_load_ps(y + i);
+            vy = _mm256_fmadd_ps(va, vx, vy);  // y = a*x + y
+            _mm256_store_ps(y + i, vy);
+        },
+        // Remainder (and peel): masked lanes are neither read nor written
+        [&](size_t i, __m256i m) {
+            __m256 vy = _mm256_fmadd_ps(va, _mm256_maskload_ps(x + i, m), _mm256_maskload_ps(y + i, m));
+            _mm256_maskstore_ps(y + i, m, vy);
+        });
 }
 
 int main() {
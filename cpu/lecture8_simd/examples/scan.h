@@ -0,0 +1,274 @@
+// scan.h - AVX2 prefix sums (inclusive / exclusive), single-thread and threaded
+//
+// In-register scan of one vector, log2(W) shift-and-add steps:
+//
+//   x          a    b    c    d  |  e    f    g    h
+//   + x << 1   0    a    b    c  |  0    e    f    g     (within 128-bit lanes)
+//   + x << 2   0    0    a   a+b |  0    0    e   e+f
+//   + low top  0    0    0    0  | abcd abcd abcd abcd   (permute2x128 + shuffle)
+//
+// AVX2 byte shifts (vpslldq) never cross the 128-bit halves, hence the
+// last step. Across vectors a carry register holds the running total in
+// every lane: out = scan(x) + carry, carry += broadcast(last of scan(x)).
+// The carry update takes last() of scan(x), not of the output, so the
+// loop-carried chain is a single add per vector.
+//
+// Exclusive scan moves the inclusive result one lane up and puts the old
+// carry in lane 0, so every output is the same sum the inclusive scan
+// forms (no x - in[i] round trip for floats).
+//
+// Large scans are memory bound, and two things close most of the gap to
+// memcpy: a software prefetch SCAN_PREFETCH bytes ahead (the extra
+// shuffles per vector otherwise leave fewer misses in flight), and, for
+// outputs past SCAN_STREAM_BYTES, non-temporal stores, which skip the
+// read-for-ownership of every output line as glibc's memcpy does.
+// Smaller outputs are stored normally: they are usually read next.
+//
+// scan_parallel is the two-pass scan: every thread sums its block, the T
+// block sums are scanned serially, then every thread scans its block from
+// its offset. It reads the input twice (3 x n x sizeof(T) of traffic
+// against memcpy's 2x), so with one thread it skips straight to pass 2.
+//
+// Floating-point scans are associated differently from a serial loop;
+// results match it exactly only when every partial sum is exact.
+//
+// Needs thread_pool.h (cpu/lecture10_roofline/examples, via -I).
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "simd_loop.h"
+#include "thread_pool.h"
+
+template <class T>
+struct scan_simd;
+
+template <>
+struct scan_simd<int32_t> {
+    typedef __m256i V;
+    static const int W = 8;
+    static V load(const int32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(int32_t* p, V v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static void stream(int32_t* p, V v) { _mm256_stream_si256((__m256i*)p, v); }
+    static V load_mask(const int32_t* p, __m256i m) { return _mm256_maskload_epi32(p, m); }
+    static void store_mask(int32_t* p, __m256i m, V v) { _mm256_maskstore_epi32(p, m, v); }
+    static V set1(int32_t a) { return _mm256_set1_epi32(a); }
+    static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+    static int32_t first(V v) { return _mm256_cvtsi256_si32(v); }
+    static V scan(V x) {
+        x = add(x, _mm256_slli_si256(x, 4));
+        x = add(x, _mm256_slli_si256(x, 8));
+        return add(x, _mm256_shuffle_epi32(_mm256_permute2x128_si256(x, x, 0x08), 0xFF));
+    }
+    static V last(V x) { return _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7)); }
+    // (c, x0, ..., x6)
+    static V shift_in(V x, V c) {
+        V up = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+        return _mm256_blend_epi32(up, c, 0x01);
+    }
+};
+
+template <>
+struct scan_simd<int64_t> {
+    typedef __m256i V;
+    static const int W = 4;
+    static V load(const int64_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(int64_t* p, V v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static void stream(int64_t* p, V v) { _mm256_stream_si256((__m256i*)p, v); }
+    static V load_mask(const int64_t* p, __m256i m) {
+        return _mm256_maskload_epi64((const long long*)p, m);
+    }
+    static void store_mask(int64_t* p, __m256i m, V v) {
+        _mm256_maskstore_epi64((long long*)p, m, v);
+    }
+    static V set1(int64_t a) { return _mm256_set1_epi64x(a); }
+    static V add(V a, V b) { return _mm256_add_epi64(a, b); }
+    static int64_t first(V v) { return _mm_cvtsi128_si64(_mm256_castsi256_si128(v)); }
+    static V scan(V x) {
+        x = add(x, _mm256_slli_si256(x, 8));
+        return add(x, _mm256_shuffle_epi32(_mm256_permute2x128_si256(x, x, 0x08), 0xEE));
+    }
+    static V last(V x) { return _mm256_permute4x64_epi64(x, 0xFF); }
+    static V shift_in(V x, V c) {
+        return _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x90), c, 0x03);
+    }
+};
+
+template <>
+struct scan_simd<float> {
+    typedef __m256 V;
+    static const int W = 8;
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static void stream(float* p, V v) { _mm256_stream_ps(p, v); }
+    static V load_mask(const float* p, __m256i m) { return _mm256_maskload_ps(p, m); }
+    static void store_mask(float* p, __m256i m, V v) { _mm256_maskstore_ps(p, m, v); }
+    static V set1(float a) { return _mm256_set1_ps(a); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static float first(V v) { return _mm256_cvtss_f32(v); }
+    static V shl(V x, int bytes) {  // bytes: 4 or 8
+        __m256i i = _mm256_castps_si256(x);
+        return _mm256_castsi256_ps(bytes == 4 ? _mm256_slli_si256(i, 4) : _mm256_slli_si256(i, 8));
+    }
+    static V scan(V x) {
+        x = add(x, shl(x, 4));
+        x = add(x, shl(x, 8));
+        return add(x, _mm256_permute_ps(_mm256_permute2f128_ps(x, x, 0x08), 0xFF));
+    }
+    static V last(V x) { return _mm256_permutevar8x32_ps(x, _mm256_set1_epi32(7)); }
+    static V shift_in(V x, V c) {
+        V up = _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+        return _mm256_blend_ps(up, c, 0x01);
+    }
+};
+
+template <>
+struct scan_simd<double> {
+    typedef __m256d V;
+    static const int W = 4;
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static void stream(double* p, V v) { _mm256_stream_pd(p, v); }
+    static V load_mask(const double* p, __m256i m) { return _mm256_maskload_pd(p, m); }
+    static void store_mask(double* p, __m256i m, V v) { _mm256_maskstore_pd(p, m, v); }
+    static V set1(double a) { return _mm256_set1_pd(a); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static double first(V v) { return _mm256_cvtsd_f64(v); }
+    static V scan(V x) {
+        x = add(x, _mm256_castsi256_pd(_mm256_slli_si256(_mm256_castpd_si256(x), 8)));
+        return add(x, _mm256_permute_pd(_mm256_permute2f128_pd(x, x, 0x08), 0x0F));
+    }
+    static V last(V x) { return _mm256_permute4x64_pd(x, 0xFF); }
+    static V shift_in(V x, V c) {
+        return _mm256_blend_pd(_mm256_permute4x64_pd(x, 0x90), c, 0x01);
+    }
+};
+
+const size_t SCAN_PREFETCH = 4096;         // bytes ahead of the loads
+const size_t SCAN_STREAM_BYTES = 8u << 20;  // outputs at least this large bypass the cache
+
+// Scalar steps over in[i, end); returns the new carry
+template <bool INCLUSIVE, class T>
+static inline T scan_scalar_steps(const T* in, T* out, size_t i, size_t end, T carry) {
+    for (; i < end; i++) {
+        T v = in[i];
+        out[i] = INCLUSIVE ? carry + v : carry;
+        carry += v;
+    }
+    return carry;
+}
+
+// One vector at in + i: store carry + scan, advance the carry
+template <bool INCLUSIVE, bool STREAM, class T>
+static inline void scan_step(const T* in, T* out, size_t i, typename scan_simd<T>::V& c) {
+    typedef scan_simd<T> S;
+    typename S::V x = S::scan(S::load(in + i));
+    typename S::V y = S::add(x, c);
+    if (!INCLUSIVE) y = S::shift_in(y, c);
+    if (STREAM) S::stream(out + i, y);
+    else S::store(out + i, y);
+    c = S::add(c, S::last(x));
+}
+
+// The first `rem` lanes at in + i (sl_mask): masked-off lanes load as 0,
+// so last(x) is still the sum of the lanes that exist
+template <bool INCLUSIVE, class T>
+static inline void scan_step_masked(const T* in, T* out, size_t i, size_t rem,
+                                    typename scan_simd<T>::V& c) {
+    typedef scan_simd<T> S;
+    __m256i m = sl_mask<T>(rem);
+    typename S::V x = S::scan(S::load_mask(in + i, m));
+    typename S::V y = S::add(x, c);
+    if (!INCLUSIVE) y = S::shift_in(y, c);
+    S::store_mask(out + i, m, y);
+    c = S::add(c, S::last(x));
+}
+
+// STREAM: non-temporal stores (out is peeled to 32-byte alignment first,
+// one masked vector). The last n % W elements are one masked vector too.
+template <bool INCLUSIVE, bool STREAM, class T>
+static T scan_kernel(const T* in, T* out, size_t n, T carry) {
+    typedef scan_simd<T> S;
+    size_t i = 0;
+    if (STREAM && (uintptr_t)out % sizeof(T) != 0)  // cannot align: all scalar
+        return scan_scalar_steps<INCLUSIVE>(in, out, 0, n, carry);
+    typename S::V c = S::set1(carry);
+    if (STREAM) {
+        i = std::min(sl_peel(out), n);
+        if (i) scan_step_masked<INCLUSIVE>(in, out, 0, i, c);
+    }
+    for (; i + 2 * S::W <= n; i += 2 * S::W) {  // one 64-byte line
+        _mm_prefetch((const char*)(in + i) + SCAN_PREFETCH, _MM_HINT_T0);
+        scan_step<INCLUSIVE, STREAM>(in, out, i, c);
+        scan_step<INCLUSIVE, STREAM>(in, out, i + S::W, c);
+    }
+    if (i + S::W <= n) {
+        scan_step<INCLUSIVE, STREAM>(in, out, i, c);
+        i += S::W;
+    }
+    if (STREAM) _mm_sfence();
+    if (i < n) scan_step_masked<INCLUSIVE>(in, out, i, n - i, c);
+    return S::first(c);
+}
+
+// out[i] = carry + in[0..i] (inclusive) or carry + in[0..i) (exclusive),
+// i in [0, n); returns carry + the sum of in[0, n). out may equal in.
+template <bool INCLUSIVE, class T>
+static T scan_range(const T* in, T* out, size_t n, T carry) {
+    return n * sizeof(T) >= SCAN_STREAM_BYTES ? scan_kernel<INCLUSIVE, true>(in, out, n, carry)
+                                              : scan_kernel<INCLUSIVE, false>(in, out, n, carry);
+}
+
+// Sum of in[0, n), 4 vector accumulators
+template <class T>
+static T scan_block_sum(const T* in, size_t n) {
+    typedef scan_simd<T> S;
+    typedef typename S::V V;
+    V a0 = S::set1(0), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+    for (; i + 4 * S::W <= n; i += 4 * S::W) {
+        a0 = S::add(a0, S::load(in + i));
+        a1 = S::add(a1, S::load(in + i + S::W));
+        a2 = S::add(a2, S::load(in + i + 2 * S::W));
+        a3 = S::add(a3, S::load(in + i + 3 * S::W));
+    }
+    for (; i + S::W <= n; i += S::W) a1 = S::add(a1, S::load(in + i));
+    if (i < n) a2 = S::add(a2, S::load_mask(in + i, sl_mask<T>(n - i)));
+    V s = S::scan(S::add(S::add(a0, a1), S::add(a2, a3)));
+    return S::first(S::last(s));
+}
+
+// Two-pass threaded scan over [0, n), starting from 0
+template <bool INCLUSIVE, class T>
+static void scan_parallel(thread_pool& pool, const T* in, T* out, size_t n) {
+    if (pool.n == 1) {
+        scan_range<INCLUSIVE>(in, out, n, T(0));
+        return;
+    }
+    bool stream = n * sizeof(T) >= SCAN_STREAM_BYTES;
+    std::vector<T> offset(pool.n);
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        offset[id] = scan_block_sum(in + lo, hi - lo);
+    });
+    T carry = 0;
+    for (int t = 0; t < pool.n; t++) {
+        T s = offset[t];
+        offset[t] = carry;
+        carry += s;
+    }
+    pool.run([&](int id) {
+        size_t lo, hi;
+        chunk(n, pool.n, id, &lo, &hi);
+        if (stream) scan_kernel<INCLUSIVE, true>(in + lo, out + lo, hi - lo, offset[id]);
+        else scan_kernel<INCLUSIVE, false>(in + lo, out + lo, hi - lo, offset[id]);
+    });
+}
+
+#endif // SCAN_H
@@ -0,0 +1,298 @@
+// simd_kernels.h - The lecture-8 kernels, one variant per SIMD level, bound at startup
+//
+//   add          c = a + b            (add_v2)
+//   sum          sum of a             (sum_v2: 2 vector accumulators)
+//   dot          sum of a * b         (dot_v2, with sum_v2's 2 accumulators)
+//   saxpy        y = a * x + y, float (saxpy_simd)
+//   conditional  b = a > 0.5 ? a + 1 : a - 1  (conditional_simd)
+//
+// Each kernel exists as _scalar, _sse2, _avx2 and _avx512, built for its
+// level with a target attribute. simd_kernels_for(level) is the table for
+// one level; simd_dispatch() is the table for isa_selected(), looked up
+// on first use, so a call through it costs one indirect call.
+//
+// Unlike the original examples these take any n: SSE2 finishes with a
+// scalar loop, AVX2 peels to alignment and finishes with one masked
+// vector (sl_for, simd_loop.h), AVX-512 with one masked load / store
+// (k-registers make a partial vector free). SSE2 has no FMA and no
+// blendv, so its dot and saxpy multiply then add, and conditional selects
+// with and/andnot/or.
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <immintrin.h>
+#include <cstddef>
+#include "isa_dispatch.h"
+#include "simd_loop.h"
+
+#define SIMD_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#define SIMD_SSE2 __attribute__((target("sse2")))
+#define SIMD_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_AVX512 __attribute__((target("avx512f")))
+
+// ============================================================================
+// Scalar: the plain loops, kept scalar
+// ============================================================================
+
+SIMD_SCALAR static void add_scalar(const double* a, const double* b, double* c, size_t n) {
+    for (size_t i = 0; i < n; i++) c[i] = a[i] + b[i];
+}
+
+SIMD_SCALAR static double sum_scalar(const double* a, size_t n) {
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += a[i];
+    return s;
+}
+
+SIMD_SCALAR static double dot_scalar(const double* a, const double* b, size_t n) {
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+SIMD_SCALAR static void saxpy_scalar(float* y, float a, const float* x, size_t n) {
+    for (size_t i = 0; i < n; i++) y[i] = a * x[i] + y[i];
+}
+
+SIMD_SCALAR static void conditional_scalar(const double* a, double* b, size_t n) {
+    for (size_t i = 0; i < n; i++) b[i] = a[i] > 0.5 ? a[i] + 1.0 : a[i] - 1.0;
+}
+
+// ============================================================================
+// SSE2: 2 doubles / 4 floats
+// ============================================================================
+
+SIMD_SSE2 static void add_sse2(const double* a, const double* b, double* c, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(c + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    for (; i < n; i++) c[i] = a[i] + b[i];
+}
+
+SIMD_SSE2 static double sum_sse2(const double* a, size_t n) {
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 = _mm_add_pd(s0, _mm_loadu_pd(a + i));
+        s1 = _mm_add_pd(s1, _mm_loadu_pd(a + i + 2));
+    }
+    __m128d s = _mm_add_pd(s0, s1);
+    double r = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    for (; i < n; i++) r += a[i];
+    return r;
+}
+
+SIMD_SSE2 static double dot_sse2(const double* a, const double* b, size_t n) {
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    __m128d s = _mm_add_pd(s0, s1);
+    double r = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    for (; i < n; i++) r += a[i] * b[i];
+    return r;
+}
+
+SIMD_SSE2 static void saxpy_sse2(float* y, float a, const float* x, size_t n) {
+    __m128 va = _mm_set1_ps(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(x + i)), _mm_loadu_ps(y + i)));
+    for (; i < n; i++) y[i] = a * x[i] + y[i];
+}
+
+SIMD_SSE2 static void conditional_sse2(const double* a, double* b, size_t n) {
+    __m128d threshold = _mm_set1_pd(0.5), ones = _mm_set1_pd(1.0), mones = _mm_set1_pd(-1.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(a + i);
+        __m128d mask = _mm_cmpgt_pd(v, threshold);
+        __m128d delta = _mm_or_pd(_mm_and_pd(mask, ones), _mm_andnot_pd(mask, mones));
+        _mm_storeu_pd(b + i, _mm_add_pd(v, delta));
+    }
+    for (; i < n; i++) b[i] = a[i] > 0.5 ? a[i] + 1.0 : a[i] - 1.0;
+}
+
+// ============================================================================
+// AVX2 + FMA: 4 doubles / 8 floats (the original examples)
+// ============================================================================
+
+SIMD_AVX2 static void add_avx2(const double* a, const double* b, double* c, size_t n) {
+    sl_for<double, 2>(c, n,
+        [&](size_t i, int) SIMD_AVX2 {
+            _mm256_store_pd(c + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        },
+        [&](size_t i, __m256i m) SIMD_AVX2 {
+            _mm256_maskstore_pd(c + i, m, _mm256_add_pd(_mm256_maskload_pd(a + i, m),
+                                                        _mm256_maskload_pd(b + i, m)));
+        });
+}
+
+SIMD_AVX2 static double hsum_avx2(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+SIMD_AVX2 static double sum_avx2(const double* a, size_t n) {
+    __m256d s[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    sl_for<double, 2>(a, n,
+        [&](size_t i, int k) SIMD_AVX2 { s[k] = _mm256_add_pd(s[k], _mm256_load_pd(a + i)); },
+        [&](size_t i, __m256i m) SIMD_AVX2 {
+            s[0] = _mm256_add_pd(s[0], _mm256_maskload_pd(a + i, m));
+        });
+    return hsum_avx2(_mm256_add_pd(s[0], s[1]));
+}
+
+SIMD_AVX2 static double dot_avx2(const double* a, const double* b, size_t n) {
+    __m256d s[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    sl_for<double, 2>(a, n,
+        [&](size_t i, int k) SIMD_AVX2 {
+            s[k] = _mm256_fmadd_pd(_mm256_load_pd(a + i), _mm256_loadu_pd(b + i), s[k]);
+        },
+        [&](size_t i, __m256i m) SIMD_AVX2 {
+            s[0] = _mm256_fmadd_pd(_mm256_maskload_pd(a + i, m), _mm256_maskload_pd(b + i, m), s[0]);
+        });
+    return hsum_avx2(_mm256_add_pd(s[0], s[1]));
+}
+
+SIMD_AVX2 static void saxpy_avx2(float* y, float a, const float* x, size_t n) {
+    __m256 va = _mm256_set1_ps(a);
+    sl_for<float, 2>(y, n,
+        [&](size_t i, int) SIMD_AVX2 {
+            _mm256_store_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_load_ps(y + i)));
+        },
+        [&](size_t i, __m256i m) SIMD_AVX2 {
+            _mm256_maskstore_ps(y + i, m, _mm256_fmadd_ps(va, _mm256_maskload_ps(x + i, m),
+                                                          _mm256_maskload_ps(y + i, m)));
+        });
+}
+
+SIMD_AVX2 static void conditional_avx2(const double* a, double* b, size_t n) {
+    __m256d threshold = _mm256_set1_pd(0.5), ones = _mm256_set1_pd(1.0),
+            mones = _mm256_set1_pd(-1.0);
+    auto update = [&](__m256d v) SIMD_AVX2 {
+        __m256d mask = _mm256_cmp_pd(v, threshold, _CMP_GT_OQ);
+        return _mm256_add_pd(v, _mm256_blendv_pd(mones, ones, mask));
+    };
+    sl_for<double, 2>(b, n,
+        [&](size_t i, int) SIMD_AVX2 { _mm256_store_pd(b + i, update(_mm256_loadu_pd(a + i))); },
+        [&](size_t i, __m256i m) SIMD_AVX2 {
+            _mm256_maskstore_pd(b + i, m, update(_mm256_maskload_pd(a + i, m)));
+        });
+}
+
+// ============================================================================
+// AVX-512F: 8 doubles / 16 floats, masked tail
+// ============================================================================
+
+SIMD_AVX512 static void add_avx512(const double* a, const double* b, double* c, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(c + i, _mm512_add_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+    if (i < n) {
+        __mmask8 m = (__mmask8)((1u << (n - i)) - 1);
+        _mm512_mask_storeu_pd(c + i, m, _mm512_add_pd(_mm512_maskz_loadu_pd(m, a + i),
+                                                      _mm512_maskz_loadu_pd(m, b + i)));
+    }
+}
+
+// Fixed-order horizontal sum. Zero-masked extracts: GCC 12's plain
+// extract / cast (and so _mm512_reduce_add_pd) trip -Wuninitialized.
+SIMD_AVX512 static double hsum_avx512(__m512d v) {
+    __m256d h = _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xF, v, 0),
+                              _mm512_maskz_extractf64x4_pd(0xF, v, 1));
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(h), _mm256_extractf128_pd(h, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+SIMD_AVX512 static double sum_avx512(const double* a, size_t n) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm512_add_pd(s0, _mm512_loadu_pd(a + i));
+        s1 = _mm512_add_pd(s1, _mm512_loadu_pd(a + i + 8));
+    }
+    for (; i < n; i += 8) {
+        __mmask8 m = n - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        s0 = _mm512_add_pd(s0, _mm512_maskz_loadu_pd(m, a + i));
+    }
+    return hsum_avx512(_mm512_add_pd(s0, s1));
+}
+
+SIMD_AVX512 static double dot_avx512(const double* a, const double* b, size_t n) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), s1);
+    }
+    for (; i < n; i += 8) {
+        __mmask8 m = n - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i), s0);
+    }
+    return hsum_avx512(_mm512_add_pd(s0, s1));
+}
+
+SIMD_AVX512 static void saxpy_avx512(float* y, float a, const float* x, size_t n) {
+    __m512 va = _mm512_set1_ps(a);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+    if (i < n) {
+        __mmask16 m = (__mmask16)((1u << (n - i)) - 1);
+        _mm512_mask_storeu_ps(y + i, m, _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(m, x + i),
+                                                        _mm512_maskz_loadu_ps(m, y + i)));
+    }
+}
+
+SIMD_AVX512 static void conditional_avx512(const double* a, double* b, size_t n) {
+    __m512d threshold = _mm512_set1_pd(0.5), ones = _mm512_set1_pd(1.0),
+            mones = _mm512_set1_pd(-1.0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_loadu_pd(a + i);
+        __mmask8 gt = _mm512_cmp_pd_mask(v, threshold, _CMP_GT_OQ);
+        _mm512_storeu_pd(b + i, _mm512_add_pd(v, _mm512_mask_blend_pd(gt, mones, ones)));
+    }
+    if (i < n) {
+        __mmask8 m = (__mmask8)((1u << (n - i)) - 1);
+        __m512d v = _mm512_maskz_loadu_pd(m, a + i);
+        __mmask8 gt = _mm512_cmp_pd_mask(v, threshold, _CMP_GT_OQ);
+        _mm512_mask_storeu_pd(b + i, m, _mm512_add_pd(v, _mm512_mask_blend_pd(gt, mones, ones)));
+    }
+}
+
+// ============================================================================
+// Dispatch table
+// ============================================================================
+
+struct simd_kernels {
+    isa_level isa;
+    void (*add)(const double* a, const double* b, double* c, size_t n);
+    double (*sum)(const double* a, size_t n);
+    double (*dot)(const double* a, const double* b, size_t n);
+    void (*saxpy)(float* y, float a, const float* x, size_t n);
+    void (*conditional)(const double* a, double* b, size_t n);
+};
+
+// Table for one level; the caller checks isa_supported(level)
+static inline const simd_kernels& simd_kernels_for(isa_level level) {
+    static const simd_kernels table[ISA_COUNT] = {
+        {ISA_SCALAR, add_scalar, sum_scalar, dot_scalar, saxpy_scalar, conditional_scalar},
+        {ISA_SSE2, add_sse2, sum_sse2, dot_sse2, saxpy_sse2, conditional_sse2},
+        {ISA_AVX2, add_avx2, sum_avx2, dot_avx2, saxpy_avx2, conditional_avx2},
+        {ISA_AVX512, add_avx512, sum_avx512, dot_avx512, saxpy_avx512, conditional_avx512},
+    };
+    return table[level];
+}
+
+// Table for isa_selected(), bound on first use
+static inline const simd_kernels& simd_dispatch() {
+    static const simd_kernels& bound = simd_kernels_for(isa_selected());
+    return bound;
+}
+
+#endif // SIMD_KERNELS_H
@@ -0,0 +1,83 @@
+// simd_loop.h - AVX2 loop skeleton: peel to alignment, aligned unrolled body, masked tail
+//
+// The examples assume n is a multiple of the vector width (add_v2, sum_v2,
+// conditional) or finish with a scalar loop (saxpy): up to 7 scalar
+// iterations plus a mispredicted exit, which is most of the time for
+// short arrays. sl_for runs the same loop over any n and any offset:
+//
+//   peel   [0, p)           one masked vector, p < W elements, so that
+//                           `align` + p is on a 32-byte boundary
+//   body   [p, p + m W)     whole vectors, `align` + i aligned, U per
+//                           iteration (U = 1..4)
+//   tail   [.., n)          one masked vector, the last < W elements
+//
+// n <= W is a single masked vector. body(i, k) gets the element index and
+// which of the U copies it is (k = 0 outside the unrolled loop), so a
+// reduction can keep U accumulators; part(i, mask) does the peel and the
+// tail with a lane mask for _mm256_maskload / _mm256_maskstore (masked
+// lanes load as 0 and are not stored, and cannot fault).
+//
+//   sl_for<double, 2>(c, n,
+//       [&](size_t i, int) { _mm256_store_pd(c + i, f(_mm256_loadu_pd(a + i))); },
+//       [&](size_t i, __m256i m) { _mm256_maskstore_pd(c + i, m, f(_mm256_maskload_pd(a + i, m))); });
+//
+// `align` is the array the loop stores to (the one read for a reduction):
+// stores that split a cache line cost more than split loads. Other arrays
+// with the same offset are aligned too; the rest are read with loadu.
+// Element order inside the vectors is unchanged, but a reduction's sums
+// are grouped by the offset of `align`. A masked store does not forward
+// to a later load of the same bytes, which waits for the store to
+// reach L1. That matters for short in-place loops run back to back
+// (tail_bench).
+//
+// Everything here carries target("avx2,fma"), so it can be included from
+// a -mavx2 build or from the dispatched kernels in simd_kernels.h, whose
+// lambdas need the same attribute.
+
+#ifndef SIMD_LOOP_H
+#define SIMD_LOOP_H
+
+#include <immintrin.h>
+#include <cstddef>
+#include <cstdint>
+
+#define SL_AVX2 __attribute__((target("avx2,fma")))
+
+// 8 x -1 then 8 x 0: the mask for the first r lanes is one unaligned load
+alignas(64) static const int32_t sl_mask_table[16] = {-1, -1, -1, -1, -1, -1, -1, -1,
+                                                      0,  0,  0,  0,  0,  0,  0,  0};
+
+// First `rem` lanes set, rem = 0..W
+template <class T>
+SL_AVX2 static inline __m256i sl_mask(size_t rem) {
+    return _mm256_loadu_si256(
+        (const __m256i*)(sl_mask_table + 8 - rem * (sizeof(T) / sizeof(int32_t))));
+}
+
+// Elements before `p` reaches a 32-byte boundary (p must be T-aligned)
+template <class T>
+static inline size_t sl_peel(const T* p) {
+    return (32 - (uintptr_t)p % 32) % 32 / sizeof(T);
+}
+
+template <class T, int U = 1, class Body, class Part>
+SL_AVX2 static inline void sl_for(const T* align, size_t n, Body body, Part part) {
+    static_assert(U >= 1 && U <= 4, "unroll 1 to 4 times");
+    const size_t W = 32 / sizeof(T);
+    if (n <= W) {
+        if (n) part(0, sl_mask<T>(n));
+        return;
+    }
+    size_t i = sl_peel(align);
+    if (i) part(0, sl_mask<T>(i));
+    for (; i + U * W <= n; i += U * W) {
+        body(i, 0);
+        if (U > 1) body(i + W, 1);
+        if (U > 2) body(i + 2 * W, 2);
+        if (U > 3) body(i + 3 * W, 3);
+    }
+    for (; i + W <= n; i += W) body(i, 0);
+    if (i < n) part(i, sl_mask<T>(n - i));
+}
+
+#endif // SIMD_LOOP_H
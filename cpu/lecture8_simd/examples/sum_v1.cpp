@@ -4,20 +4,24 @@
 //
 // Uses 4 parallel accumulators via SIMD (one __m256d register).
 // This gives same ILP as scalar 4x unrolled.
+// Any n: peel and tail are masked loads, which read the missing lanes as 0.
 
 #include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <immintrin.h>
+#include "simd_loop.h"
 using namespace std;
 
 double sum_simd(double* a, int n) {
     __m256d vsum = _mm256_setzero_pd();  // [0, 0, 0, 0]
 
-    for (int i = 0; i < n; i += 4) {
-        __m256d v = _mm256_loadu_pd(a + i);
-        vsum = _mm256_add_pd(vsum, v);   // 4 parallel sums
-    }
+    sl_for<double>(a, n,
+        [&](size_t i, int) {
+            __m256d v = _mm256_load_pd(a + i);
+            vsum = _mm256_add_pd(vsum, v);   // 4 parallel sums
+        },
+        [&](size_t i, __m256i m) { vsum = _mm256_add_pd(vsum, _mm256_maskload_pd(a + i, m)); });
 
     // Horizontal reduction
     __m128d low = _mm256_castpd256_pd128(vsum);
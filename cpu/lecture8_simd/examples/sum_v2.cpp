@@ -4,29 +4,28 @@
 //
 // Uses 8 parallel accumulators via 2 SIMD registers.
 // Maximum ILP for FP add (latency=4, throughput=2/cycle -> need 8 in flight).
+// sl_for<double, 2> unrolls twice and passes k = 0 / 1 to pick the
+// accumulator; peel and tail are masked loads into the first one.
 
 #include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <immintrin.h>
+#include "simd_loop.h"
 using namespace std;
 
 double sum_simd_unrolled(double* a, int n) {
-    __m256d vsum1 = _mm256_setzero_pd();
-    __m256d vsum2 = _mm256_setzero_pd();  // Two vector accumulators!
+    __m256d vsum[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};  // Two vector accumulators!
 
-    for (int i = 0; i < n; i += 8) {
-        __m256d v1 = _mm256_loadu_pd(a + i);
-        __m256d v2 = _mm256_loadu_pd(a + i + 4);
-        vsum1 = _mm256_add_pd(vsum1, v1);
-        vsum2 = _mm256_add_pd(vsum2, v2);
-    }
+    sl_for<double, 2>(a, n,
+        [&](size_t i, int k) { vsum[k] = _mm256_add_pd(vsum[k], _mm256_load_pd(a + i)); },
+        [&](size_t i, __m256i m) { vsum[0] = _mm256_add_pd(vsum[0], _mm256_maskload_pd(a + i, m)); });
 
-    __m256d vsum = _mm256_add_pd(vsum1, vsum2);
+    __m256d vsum12 = _mm256_add_pd(vsum[0], vsum[1]);
 
     // Horizontal reduction
-    __m128d low = _mm256_castpd256_pd128(vsum);
-    __m128d high = _mm256_extractf128_pd(vsum, 1);
+    __m128d low = _mm256_castpd256_pd128(vsum12);
+    __m128d high = _mm256_extractf128_pd(vsum12, 1);
     __m128d sum128 = _mm_add_pd(low, high);
     sum128 = _mm_hadd_pd(sum128, sum128);
     return _mm_cvtsd_f64(sum128);
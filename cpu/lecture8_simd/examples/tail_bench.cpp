@@ -0,0 +1,241 @@
+// tail_bench.cpp - Short, odd-length arrays: scalar remainder loop vs masked peel / tail
+// Compile: g++ -O3 -std=c++14 tail_bench.cpp -o tail_bench      (kernels carry their own target)
+// Run: ./tail_bench
+//
+// At n = 100M the loop shape does not matter; at n = 1..1000 it is most
+// of the time. "remainder" is the AVX2 kernel as it was: unaligned loads
+// and stores, then up to W - 1 scalar iterations, whose count changes
+// with every n and mispredicts the loop exit. "sl_for" is the AVX2
+// kernel in simd_kernels.h: one masked vector to reach the 32-byte
+// boundary of the output, aligned unrolled body, one masked vector for
+// the tail (simd_loop.h). AVX-512 does the same tail with k-registers.
+//
+// Every call gets a length from the range and independent random offsets
+// (0..W-1 elements) for each array, in shuffled order, so neither the
+// lengths nor the alignment repeat. Times are ns per call, data in L1.
+// The check compares every length 0..1000 at every offset against the
+// scalar kernels and verifies nothing outside [0, n) is written, for the
+// AVX2 and (where supported) AVX-512 kernels: "sl_for/avx512" in the table.
+//
+// The masked version wins from about 8 elements on. Below that a few
+// scalar iterations are cheaper than a masked store. In-place saxpy
+// also loses up to about a hundred elements, because its next call
+// loads bytes that a masked store just wrote: a masked store cannot
+// forward to a load, so that load waits for the store to reach L1
+// (~10 ns here).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "simd_kernels.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ============================================================
+// The AVX2 kernels with a scalar remainder loop
+// ============================================================
+
+SIMD_AVX2 static void add_rem(const double* a, const double* b, double* c, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(c + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    for (; i < n; i++) c[i] = a[i] + b[i];
+}
+
+SIMD_AVX2 static double sum_rem(const double* a, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(a + i));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(a + i + 4));
+    }
+    double r = hsum_avx2(_mm256_add_pd(s0, s1));
+    for (; i < n; i++) r += a[i];
+    return r;
+}
+
+SIMD_AVX2 static double dot_rem(const double* a, const double* b, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), s1);
+    }
+    double r = hsum_avx2(_mm256_add_pd(s0, s1));
+    for (; i < n; i++) r += a[i] * b[i];
+    return r;
+}
+
+SIMD_AVX2 static void saxpy_rem(float* y, float a, const float* x, size_t n) {
+    __m256 va = _mm256_set1_ps(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    for (; i < n; i++) y[i] = a * x[i] + y[i];
+}
+
+SIMD_AVX2 static void conditional_rem(const double* a, double* b, size_t n) {
+    __m256d threshold = _mm256_set1_pd(0.5), ones = _mm256_set1_pd(1.0),
+            mones = _mm256_set1_pd(-1.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(a + i);
+        __m256d mask = _mm256_cmp_pd(v, threshold, _CMP_GT_OQ);
+        _mm256_storeu_pd(b + i, _mm256_add_pd(v, _mm256_blendv_pd(mones, ones, mask)));
+    }
+    for (; i < n; i++) b[i] = a[i] > 0.5 ? a[i] + 1.0 : a[i] - 1.0;
+}
+
+static const simd_kernels rem_kernels = {ISA_AVX2, add_rem, sum_rem, dot_rem, saxpy_rem,
+                                         conditional_rem};
+
+// ============================================================
+// Calls: a length and an offset per array
+// ============================================================
+
+const size_t N_MAX = 1000, PAD = 16;
+
+enum { K_ADD, K_SUM, K_DOT, K_SAXPY, K_COND, K_COUNT };
+static const char* kernel_names[K_COUNT] = {"add", "sum", "dot", "saxpy", "conditional"};
+
+struct call {
+    uint16_t n;
+    uint8_t off[3];  // a / x, b, c / y
+};
+
+struct buffers {
+    double *a, *b, *c;
+    float *x, *y;
+};
+
+static double run(int k, const simd_kernels& t, buffers& m, const call& c) {
+    const double *a = m.a + c.off[0], *b = m.b + c.off[1];
+    double* out = m.c + c.off[2];
+    switch (k) {
+        case K_ADD: t.add(a, b, out, c.n); return out[0];
+        case K_SUM: return t.sum(a, c.n);
+        case K_DOT: return t.dot(a, b, c.n);
+        case K_SAXPY: t.saxpy(m.y + c.off[2], 0.5f, m.x + c.off[0], c.n); return m.y[c.off[2]];
+        default: t.conditional(a, out, c.n); return out[0];
+    }
+}
+
+// Best ns per call over 7 passes of `reps` x the call list
+static double time_calls(int k, const simd_kernels& t, buffers& m, const vector<call>& calls) {
+    const int reps = max(1, 200000 / (int)calls.size());
+    double best = 1e30;
+    volatile double sink = 0;
+    for (int r = 0; r < 7; r++) {
+        double t0 = now();
+        for (int rep = 0; rep < reps; rep++)
+            for (const call& c : calls) sink = sink + run(k, t, m, c);
+        best = min(best, (now() - t0) / reps / calls.size());
+    }
+    return best * 1e9;
+}
+
+static vector<call> make_calls(size_t lo, size_t hi) {
+    vector<call> calls;
+    srand(7);
+    for (int r = 0; r < 4; r++)  // at least a few hundred calls per range
+        for (size_t n = lo; n <= hi; n++) {
+            call c = {(uint16_t)n, {(uint8_t)(rand() % 8), (uint8_t)(rand() % 8),
+                                    (uint8_t)(rand() % 8)}};
+            calls.push_back(c);
+        }
+    for (size_t i = calls.size() - 1; i > 0; i--) swap(calls[i], calls[rand() % (i + 1)]);
+    return calls;
+}
+
+// ============================================================
+// Check: every length and output offset, no write outside [0, n)
+// ============================================================
+
+static bool check(int k, const simd_kernels& t, buffers& m) {
+    const double guard = -1234.5;
+    for (size_t n = 0; n <= N_MAX; n++)
+        for (int o = 0; o < 8; o++) {
+            call c = {(uint16_t)n, {(uint8_t)((o * 3) % 8), (uint8_t)((o * 5 + 1) % 8), (uint8_t)o}};
+            for (size_t i = 0; i < N_MAX + PAD; i++) m.c[i] = guard, m.y[i] = 1.0f;
+            double want = run(k, simd_kernels_for(ISA_SCALAR), m, c);
+            vector<double> ref(m.c + o, m.c + o + n);
+            vector<float> ref_y(m.y + o, m.y + o + n);
+            for (size_t i = 0; i < N_MAX + PAD; i++) m.c[i] = guard, m.y[i] = 1.0f;
+            double got = run(k, t, m, c);
+            if (n && fabs(got - want) > 1e-9 * (1 + fabs(want))) return false;
+            for (size_t i = 0; i < N_MAX + PAD; i++) {
+                bool inside = i >= (size_t)o && i < o + n;
+                if (k == K_ADD || k == K_COND) {
+                    if (inside ? m.c[i] != ref[i - o] : m.c[i] != guard) return false;
+                } else if (k == K_SAXPY) {
+                    if (inside ? fabsf(m.y[i] - ref_y[i - o]) > 1e-6f : m.y[i] != 1.0f) return false;
+                }
+            }
+        }
+    return true;
+}
+
+int main() {
+    if (!isa_supported(ISA_AVX2)) {
+        fprintf(stderr, "tail_bench needs AVX2 + FMA\n");
+        return 1;
+    }
+    bool avx512 = isa_supported(ISA_AVX512);
+    const simd_kernels& masked = simd_kernels_for(ISA_AVX2);
+
+    buffers m;
+    m.a = (double*)aligned_alloc(64, (N_MAX + PAD) * sizeof(double));
+    m.b = (double*)aligned_alloc(64, (N_MAX + PAD) * sizeof(double));
+    m.c = (double*)aligned_alloc(64, (N_MAX + PAD) * sizeof(double));
+    m.x = (float*)aligned_alloc(64, (N_MAX + PAD) * sizeof(float));
+    m.y = (float*)aligned_alloc(64, (N_MAX + PAD) * sizeof(float));
+    if (!m.a || !m.b || !m.c || !m.x || !m.y) abort();
+    srand(42);
+    for (size_t i = 0; i < N_MAX + PAD; i++) {
+        m.a[i] = rand() / (double)RAND_MAX;
+        m.b[i] = rand() / (double)RAND_MAX;
+        m.x[i] = (float)m.a[i];
+        m.y[i] = 1.0f;
+    }
+
+    const size_t ranges[][2] = {{1, 7}, {8, 31}, {32, 127}, {128, 1000}, {1, 1000}};
+    printf("\n");
+    printf("╔═════════════════════════════════════════════════════════════════════════╗\n");
+    printf("║  ns per call, random length in range, random offsets, data in L1        ║\n");
+    printf("╟─────────────────────────────────────────────────────────────────────────╢\n");
+    printf("║ %-12s %-9s %10s %10s %8s %8s  %-7s ║\n", "kernel", "n", "remainder", "sl_for",
+           "speedup", "avx512", "check");
+    for (int k = 0; k < K_COUNT; k++) {
+        char ok[16];
+        snprintf(ok, sizeof ok, "%s/%s", check(k, masked, m) ? "ok" : "FAIL",
+                 !avx512 ? "-" : check(k, simd_kernels_for(ISA_AVX512), m) ? "ok" : "FAIL");
+        printf("╟─────────────────────────────────────────────────────────────────────────╢\n");
+        for (const auto& r : ranges) {
+            vector<call> calls = make_calls(r[0], r[1]);
+            double t_rem = time_calls(k, rem_kernels, m, calls);
+            double t_sl = time_calls(k, masked, m, calls);
+            char len[16], t512[16] = "-";
+            snprintf(len, sizeof len, "%zu-%zu", r[0], r[1]);
+            if (avx512)
+                snprintf(t512, sizeof t512, "%.1f",
+                         time_calls(k, simd_kernels_for(ISA_AVX512), m, calls));
+            printf("║ %-12s %-9s %10.1f %10.1f %7.2fx %8s  %-7s ║\n",
+                   &r == &ranges[0] ? kernel_names[k] : "", len, t_rem, t_sl, t_rem / t_sl, t512,
+                   &r == &ranges[0] ? ok : "");
+        }
+    }
+    printf("╚═════════════════════════════════════════════════════════════════════════╝\n");
+
+    free(m.a);
+    free(m.b);
+    free(m.c);
+    free(m.x);
+    free(m.y);
+    return 0;
+}
@@ -0,0 +1,499 @@
+// vmath.h - AVX2 exp, log, tanh, sigmoid, erf and GELU for float and double
+//
+// A call to std::exp per element costs 10-30x an FMA kernel on the same
+// data: the call cannot be vectorized, and libm handles every edge case
+// with branches. These are the usual SIMD replacements, range reduction
+// plus a polynomial, all lanes on the same path (specials fixed up with
+// blends at the end), inline so a kernel can apply them to a register
+// it already holds:
+//
+//   __m256 v = _mm256_fmadd_ps(va, vx, vy);      // saxpy_simd body
+//   _mm256_storeu_ps(y + i, vm_gelu_ps(v));      // fused activation
+//
+// vm_map_ps / vm_map_pd apply one of them to an array (sl_for from
+// simd_loop.h: aligned stores, masked peel and tail).
+//
+//   exp      x = n ln2 + r, |r| <= ln2/2 (Cody-Waite, ln2 in two parts),
+//            e^r by a polynomial (Cephes for float, degree-13 Taylor for
+//            double), times 2^n built in the exponent bits. 2^n is
+//            applied as 2^(n/2) * 2^(n - n/2) so results that overflow
+//            give inf and gradual underflow gives denormals.
+//   log      x = 2^k m, m in [sqrt(1/2), sqrt 2), log(m) = log(1 + f):
+//            Cephes polynomial in f (float), fdlibm's s = f / (2 + f)
+//            series (double). Denormal inputs are scaled up first.
+//   tanh     expm1(2|x|) / (expm1(2|x|) + 2), sign put back; expm1 from
+//            the exp reduction as 2^n (e^r - 1) + (2^n - 1), which keeps
+//            full relative accuracy down to tiny |x|.
+//   sigmoid  1 / (1 + exp(-x)).
+//   erf      |x| < 0.84375: x + x P(x^2). Above that erf = 1 - erfc, with
+//            erfc(a) = exp(-a^2) h(a), h a polynomial in a on [0.84375, 2)
+//            and in 1/a beyond (Chebyshev fits to exp(a^2) erfc(a)).
+//            a^2 is kept as an exact hi + lo pair (FMA): exp(-a^2) needs it.
+//   gelu     x/2 erfc(-x / sqrt 2), the exact (erf) GELU. Through erfc
+//            rather than 1 + erf so it stays accurate for negative x,
+//            where the result is tiny; x^2/2 comes from x directly.
+//
+// Max error against a higher-precision reference, in ulps of the exact
+// result (vmath_bench, random inputs over each function's useful range;
+// glibc's own exp, log and erf are within about 1 ulp, tanh about 2):
+//
+//              exp    log    tanh   sigmoid  erf    gelu
+//   float      1.0    0.8    2.3    2.4      1.1    5.2
+//   double     1.0    0.7    2.4    2.4      1.0    6.7
+//
+// NaN in gives NaN out; exp(+-inf) = inf / 0, log(0) = -inf, log(x < 0)
+// = NaN, tanh, sigmoid and erf go to their limits at +-inf, gelu(-inf)
+// = 0. Nothing here sets errno or raises floating-point exceptions on
+// purpose. Needs -mavx2 -mfma.
+
+#ifndef VMATH_H
+#define VMATH_H
+
+#include <immintrin.h>
+#include <cstddef>
+#include <cstdint>
+#include "simd_loop.h"
+
+// Polynomial, coefficients highest degree first. Horner's rule up to
+// degree 6; longer ones are split into even and odd powers (two Horner
+// chains in t^2, half the dependent FMAs) since they are latency bound.
+template <size_t N>
+static inline __m256 vm_poly_ps(__m256 t, const float (&c)[N]) {
+    if (N <= 7) {
+        __m256 p = _mm256_set1_ps(c[0]);
+        for (size_t i = 1; i < N; i++) p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(c[i]));
+        return p;
+    }
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 p0 = _mm256_set1_ps(c[0]), p1 = _mm256_set1_ps(c[1]);
+    size_t i = 2;
+    for (; i + 1 < N; i += 2) {
+        p0 = _mm256_fmadd_ps(p0, t2, _mm256_set1_ps(c[i]));
+        p1 = _mm256_fmadd_ps(p1, t2, _mm256_set1_ps(c[i + 1]));
+    }
+    // c[N - 1] is the constant term: it ends p0 (N odd) or p1 (N even)
+    if (i < N) return _mm256_fmadd_ps(p1, t, _mm256_fmadd_ps(p0, t2, _mm256_set1_ps(c[i])));
+    return _mm256_fmadd_ps(p0, t, p1);
+}
+
+template <size_t N>
+static inline __m256d vm_poly_pd(__m256d t, const double (&c)[N]) {
+    if (N <= 7) {
+        __m256d p = _mm256_set1_pd(c[0]);
+        for (size_t i = 1; i < N; i++) p = _mm256_fmadd_pd(p, t, _mm256_set1_pd(c[i]));
+        return p;
+    }
+    __m256d t2 = _mm256_mul_pd(t, t);
+    __m256d p0 = _mm256_set1_pd(c[0]), p1 = _mm256_set1_pd(c[1]);
+    size_t i = 2;
+    for (; i + 1 < N; i += 2) {
+        p0 = _mm256_fmadd_pd(p0, t2, _mm256_set1_pd(c[i]));
+        p1 = _mm256_fmadd_pd(p1, t2, _mm256_set1_pd(c[i + 1]));
+    }
+    if (i < N) return _mm256_fmadd_pd(p1, t, _mm256_fmadd_pd(p0, t2, _mm256_set1_pd(c[i])));
+    return _mm256_fmadd_pd(p0, t, p1);
+}
+
+// ============================================================
+// float: coefficients
+// ============================================================
+
+// e^r - 1 = r + r^2 P(r), |r| <= ln2/2 (Cephes expf)
+static const float vm_exp_f[] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                                 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+
+// log(1 + f) = f - f^2/2 + f^3 P(f), f in [sqrt(1/2) - 1, sqrt 2 - 1] (Cephes logf)
+static const float vm_log_f[] = {7.0376836292e-2f,  -1.1514610310e-1f, 1.1676998740e-1f,
+                                 -1.2420140846e-1f, 1.4249322787e-1f,  -1.6668057665e-1f,
+                                 2.0000714765e-1f,  -2.4999993993e-1f, 3.3333331174e-1f};
+
+// erf(a) / a - 1 on a^2 in [0, 0.84375^2], t = 2.80932784 a^2 - 1
+static const float vm_erf_small_f[] = {1.8082936e-07f, -3.63251752e-06f, 6.2769599e-05f,
+                                       -0.000920535822f, 0.0111198612f, -0.108613171f,
+                                       0.00765901618f};
+
+// exp(a^2) erfc(a) on a in [0.84375, 2], t = 1.72972977 a - 2.45945954
+static const float vm_erfc_near_f[] = {-7.30016666e-07f, 3.83672477e-06f, -1.76232952e-05f,
+                                       8.51865916e-05f,  -0.000395338517f, 0.0017396122f,
+                                       -0.00723520434f,  0.0282037761f,    -0.1018373f,
+                                       0.334849477f};
+
+// a exp(a^2) erfc(a) on 1/a in [0.1, 0.5], t = 5 / a - 1.5
+static const float vm_erfc_far_f[] = {-7.17306023e-07f, -2.39832616e-06f, 2.20271304e-05f,
+                                      -5.14620187e-05f, -0.000130521919f, 0.00166478974f,
+                                      -0.00542335073f,  -0.026920218f,    0.541633189f};
+
+// ============================================================
+// float: 8 lanes
+// ============================================================
+
+// 2^n for integral n in [-126, 127]
+static inline __m256 vm_pow2i_ps(__m256 n) {
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+}
+
+// x = n ln2 + r; returns e^r - 1 and n
+static inline __m256 vm_exp_reduce_ps(__m256 x, __m256* n) {
+    *n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)),
+                         _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(*n, _mm256_set1_ps(0.693359375f), x);
+    r = _mm256_fnmadd_ps(*n, _mm256_set1_ps(-2.12194440e-4f), r);
+    return _mm256_fmadd_ps(_mm256_mul_ps(r, r), vm_poly_ps(r, vm_exp_f), r);
+}
+
+static inline __m256 vm_exp_ps(__m256 x) {
+    // max/min return the second operand for NaN: x stays NaN
+    x = _mm256_max_ps(_mm256_set1_ps(-104.0f), x);
+    x = _mm256_min_ps(_mm256_set1_ps(89.0f), x);
+    __m256 n;
+    __m256 y = _mm256_add_ps(vm_exp_reduce_ps(x, &n), _mm256_set1_ps(1.0f));
+    __m256 n1 = _mm256_floor_ps(_mm256_mul_ps(n, _mm256_set1_ps(0.5f)));
+    y = _mm256_mul_ps(y, vm_pow2i_ps(n1));
+    return _mm256_mul_ps(y, vm_pow2i_ps(_mm256_sub_ps(n, n1)));
+}
+
+// e^x - 1 for x in [0, 20] (tanh's range)
+static inline __m256 vm_expm1_ps(__m256 x) {
+    __m256 n;
+    __m256 p = vm_exp_reduce_ps(x, &n);
+    __m256 s = vm_pow2i_ps(n);
+    return _mm256_fmadd_ps(s, p, _mm256_sub_ps(s, _mm256_set1_ps(1.0f)));
+}
+
+static inline __m256 vm_log_ps(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 tiny = _mm256_cmp_ps(x, _mm256_set1_ps(1.17549435e-38f), _CMP_LT_OQ);
+    __m256 xs = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(8388608.0f)), tiny);
+
+    // xs = 2^e m, m in [0.5, 1)
+    __m256i bits = _mm256_castps_si256(xs);
+    __m256 e = _mm256_cvtepi32_ps(
+        _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+    e = _mm256_sub_ps(e, _mm256_and_ps(tiny, _mm256_set1_ps(23.0f)));
+    __m256 m = _mm256_castsi256_ps(
+        _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                        _mm256_set1_epi32(0x3f000000)));
+
+    // m < sqrt(1/2): f = 2m - 1, e - 1; else f = m - 1
+    __m256 lo = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781f), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(lo, one));
+    __m256 f = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(lo, m)), one);
+
+    __m256 z = _mm256_mul_ps(f, f);
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(vm_poly_ps(f, vm_log_f), f), z);
+    y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+    y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+    __m256 r = _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), _mm256_add_ps(f, y));
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 inf = _mm256_set1_ps(__builtin_inff());
+    r = _mm256_blendv_ps(r, _mm256_set1_ps(__builtin_nanf("")),
+                         _mm256_cmp_ps(x, zero, _CMP_NGE_UQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(zero, inf), _mm256_cmp_ps(x, zero, _CMP_EQ_OQ));
+    return _mm256_blendv_ps(r, inf, _mm256_cmp_ps(x, inf, _CMP_EQ_OQ));
+}
+
+static inline __m256 vm_tanh_ps(__m256 x) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 a = _mm256_add_ps(_mm256_andnot_ps(sign, x), _mm256_andnot_ps(sign, x));
+    __m256 e = vm_expm1_ps(_mm256_min_ps(_mm256_set1_ps(20.0f), a));
+    __m256 t = _mm256_div_ps(e, _mm256_add_ps(e, _mm256_set1_ps(2.0f)));
+    return _mm256_or_ps(t, _mm256_and_ps(sign, x));
+}
+
+static inline __m256 vm_sigmoid_ps(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 e = vm_exp_ps(_mm256_sub_ps(_mm256_setzero_ps(), x));
+    return _mm256_div_ps(one, _mm256_add_ps(one, e));
+}
+
+// erfc(a) for a >= 0.84375 (clamped to <= 10.5, past the underflow),
+// a^2 = a2_hi + a2_lo exactly
+static inline __m256 vm_erfc_tail_ps(__m256 a, __m256 a2_hi, __m256 a2_lo) {
+    __m256 near = _mm256_cmp_ps(a, _mm256_set1_ps(2.0f), _CMP_LT_OQ);
+    __m256 h = _mm256_setzero_ps();
+    int m = _mm256_movemask_ps(near);
+    if (m != 0xFF) {
+        __m256 u = _mm256_div_ps(_mm256_set1_ps(1.0f), a);
+        __m256 t = _mm256_fmadd_ps(u, _mm256_set1_ps(5.0f), _mm256_set1_ps(-1.5f));
+        h = _mm256_mul_ps(vm_poly_ps(t, vm_erfc_far_f), u);
+    }
+    if (m != 0) {
+        __m256 t = _mm256_fmadd_ps(a, _mm256_set1_ps(1.72972977f), _mm256_set1_ps(-2.45945954f));
+        h = _mm256_blendv_ps(h, vm_poly_ps(t, vm_erfc_near_f), near);
+    }
+    // exp(-hi - lo) = exp(-hi) (1 - lo)
+    __m256 e = vm_exp_ps(_mm256_sub_ps(_mm256_setzero_ps(), a2_hi));
+    e = _mm256_fnmadd_ps(e, a2_lo, e);
+    return _mm256_mul_ps(e, h);
+}
+
+// erf(a) / a - 1 for a^2 = z < 0.84375^2
+static inline __m256 vm_erf_small_ps(__m256 z) {
+    __m256 t = _mm256_fmadd_ps(z, _mm256_set1_ps(2.80932784f), _mm256_set1_ps(-1.0f));
+    return vm_poly_ps(t, vm_erf_small_f);
+}
+
+static inline __m256 vm_erf_ps(__m256 x) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 a = _mm256_min_ps(_mm256_set1_ps(10.5f), _mm256_andnot_ps(sign, x));
+    __m256 z = _mm256_mul_ps(a, a);
+    __m256 small = _mm256_cmp_ps(a, _mm256_set1_ps(0.84375f), _CMP_LT_OQ);
+    __m256 r = _mm256_fmadd_ps(a, vm_erf_small_ps(z), a);
+    if (_mm256_movemask_ps(small) != 0xFF) {
+        __m256 c = vm_erfc_tail_ps(a, z, _mm256_fmsub_ps(a, a, z));
+        r = _mm256_blendv_ps(_mm256_sub_ps(one, c), r, small);
+    }
+    return _mm256_or_ps(r, _mm256_and_ps(sign, x));
+}
+
+static inline __m256 vm_gelu_ps(__m256 x) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 lim = _mm256_set1_ps(15.0f);  // |x| / sqrt 2 > 10.5: erfc is 0 or 2
+    __m256 xc = _mm256_max_ps(_mm256_sub_ps(_mm256_setzero_ps(), lim), _mm256_min_ps(lim, x));
+
+    // w = -x / sqrt 2. erfc(w) = 1 - w - w P(w^2), as 0.5 - (w P(w^2) + (w - 0.5))
+    // (fdlibm: w - 0.5 is exact where 1 - w cancels), or exp(-w^2) h(|w|), 2 - that for w < 0
+    __m256 w = _mm256_mul_ps(xc, _mm256_set1_ps(-0.707106781f));
+    __m256 a = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), w);
+    __m256 x2 = _mm256_mul_ps(xc, xc);
+    __m256 w2 = _mm256_mul_ps(x2, half);
+    __m256 small = _mm256_cmp_ps(a, _mm256_set1_ps(0.84375f), _CMP_LT_OQ);
+    __m256 c = _mm256_fmadd_ps(w, vm_erf_small_ps(w2), _mm256_sub_ps(w, half));
+    c = _mm256_sub_ps(half, c);
+    if (_mm256_movemask_ps(small) != 0xFF) {
+        __m256 lo = _mm256_mul_ps(_mm256_fmsub_ps(xc, xc, x2), half);
+        __m256 t = vm_erfc_tail_ps(a, w2, lo);
+        __m256 neg = _mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_LT_OQ);
+        t = _mm256_blendv_ps(t, _mm256_sub_ps(_mm256_set1_ps(2.0f), t), neg);
+        c = _mm256_blendv_ps(t, c, small);
+    }
+    __m256 r = _mm256_mul_ps(_mm256_mul_ps(x, half), c);
+    // x = -inf would give -inf * 0
+    return _mm256_andnot_ps(_mm256_cmp_ps(x, _mm256_sub_ps(_mm256_setzero_ps(), lim), _CMP_LT_OQ),
+                            r);
+}
+
+// ============================================================
+// double: coefficients
+// ============================================================
+
+// e^r - 1 = r + r^2 P(r), |r| <= ln2/2: Taylor to r^13, 1/k!
+static const double vm_exp_d[] = {
+    1.6059043836821613e-10, 2.08767569878681e-09,   2.505210838544172e-08,
+    2.7557319223985888e-07, 2.7557319223985893e-06, 2.4801587301587302e-05,
+    0.00019841269841269841, 0.0013888888888888889,  0.0083333333333333332,
+    0.041666666666666664,   0.16666666666666666,    0.5};
+
+// fdlibm e_log.c: log(1 + f) = 2s + s R(s^2), s = f / (2 + f); R split in
+// even / odd powers of s^4
+static const double vm_log_even_d[] = {1.531383769920937332e-01, 2.222219843214978396e-01,
+                                       3.999999999940941908e-01};
+static const double vm_log_odd_d[] = {1.479819860511658591e-01, 1.818357216161805012e-01,
+                                      2.857142874366239149e-01, 6.666666666666735130e-01};
+
+// erf(a) / a - 1 on a^2 in [0, 0.84375^2], t = 2.8093278463648832 a^2 - 1
+static const double vm_erf_small_d[] = {
+    -1.0322187932929335e-14, 3.5036748179450159e-13, -1.0885734063203792e-11,
+    3.087437924286809e-10,   -7.8998548884111645e-09, 1.8028828558048106e-07,
+    -3.6186688985076554e-06, 6.2769872965387431e-05, -0.00092054276640591984,
+    0.011119860785142642,    -0.10861317050846143,   0.0076590159855080032};
+
+// exp(a^2) erfc(a) on a in [0.84375, 2], t = 1.7297297297297298 a - 2.4594594594594597
+static const double vm_erfc_near_d[] = {
+    3.0077080533973681e-12,  -1.9232018925011221e-11, 1.0740034090225248e-10,
+    -6.5136104231987248e-10, 3.8706147197715985e-09,  -2.2254344058839262e-08,
+    1.2420168661837907e-07,  -6.7162945654542439e-07, 3.509888804315126e-06,
+    -1.7675165053898635e-05, 8.5477206694092528e-05,  -0.00039531987865507436,
+    0.0017395076316340367,   -0.0072352065405148977,  0.028203788853347955,
+    -0.10183730171958422,    0.33484946240551772};
+
+// a exp(a^2) erfc(a) on 1/a in [1/28, 0.5], t = 4.3076923076923075 / a - 1.1538461538461537
+static const double vm_erfc_far_d[] = {
+    8.7264215339183434e-11,  -2.8359931970365934e-10, -1.2530390501269781e-11,
+    1.5521010915370732e-09,  -3.8469721885803331e-09, 3.8919680337327843e-09,
+    7.8806103888267134e-09,  -4.954547876657044e-08,  1.1755825655110731e-07,
+    -7.028193427643478e-08,  -5.7584918819985094e-07, 2.488352040020667e-06,
+    -4.1040349132134946e-06, -6.6428003660232841e-06, 6.1542231190819664e-05,
+    -0.00015477853675618364, -0.0001466544893173525,  0.0027107642171356667,
+    -0.0084120186609679837,  -0.029071267753604389,   0.54581259294607298};
+
+// ============================================================
+// double: 4 lanes
+// ============================================================
+
+// 2^n for integral n in [-1022, 1023]: n + 1023 lands in the low mantissa
+// bits of 1.5 * 2^52 + n + 1023; shifted up 52 it becomes the exponent
+static inline __m256d vm_pow2i_pd(__m256d n) {
+    __m256d t = _mm256_add_pd(n, _mm256_set1_pd(6755399441055744.0 + 1023.0));
+    return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(t), 52));
+}
+
+static inline __m256d vm_exp_reduce_pd(__m256d x, __m256d* n) {
+    *n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)),
+                         _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(*n, _mm256_set1_pd(6.93145751953125e-1), x);
+    r = _mm256_fnmadd_pd(*n, _mm256_set1_pd(1.42860682030941723212e-6), r);
+    return _mm256_fmadd_pd(_mm256_mul_pd(r, r), vm_poly_pd(r, vm_exp_d), r);
+}
+
+static inline __m256d vm_exp_pd(__m256d x) {
+    x = _mm256_max_pd(_mm256_set1_pd(-746.0), x);
+    x = _mm256_min_pd(_mm256_set1_pd(710.0), x);
+    __m256d n;
+    __m256d y = _mm256_add_pd(vm_exp_reduce_pd(x, &n), _mm256_set1_pd(1.0));
+    __m256d n1 = _mm256_floor_pd(_mm256_mul_pd(n, _mm256_set1_pd(0.5)));
+    y = _mm256_mul_pd(y, vm_pow2i_pd(n1));
+    return _mm256_mul_pd(y, vm_pow2i_pd(_mm256_sub_pd(n, n1)));
+}
+
+// e^x - 1 for x in [0, 40] (tanh's range)
+static inline __m256d vm_expm1_pd(__m256d x) {
+    __m256d n;
+    __m256d p = vm_exp_reduce_pd(x, &n);
+    __m256d s = vm_pow2i_pd(n);
+    return _mm256_fmadd_pd(s, p, _mm256_sub_pd(s, _mm256_set1_pd(1.0)));
+}
+
+static inline __m256d vm_log_pd(__m256d x) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d tiny = _mm256_cmp_pd(x, _mm256_set1_pd(2.2250738585072014e-308), _CMP_LT_OQ);
+    __m256d xs = _mm256_blendv_pd(x, _mm256_mul_pd(x, _mm256_set1_pd(18014398509481984.0)), tiny);
+
+    // xs = 2^k m, m in [1, 2); the biased exponent is or-ed into 2^52 to convert it
+    __m256i bits = _mm256_castpd_si256(xs);
+    const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+    __m256d k = _mm256_sub_pd(
+        _mm256_castsi256_pd(
+            _mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_castpd_si256(two52))),
+        _mm256_add_pd(two52, _mm256_set1_pd(1023.0)));
+    k = _mm256_sub_pd(k, _mm256_and_pd(tiny, _mm256_set1_pd(54.0)));
+    __m256d m = _mm256_castsi256_pd(
+        _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000fffffffffffffll)),
+                        _mm256_castpd_si256(one)));
+
+    // m > sqrt 2: m / 2, k + 1
+    __m256d hi = _mm256_cmp_pd(m, _mm256_set1_pd(1.4142135623730951), _CMP_GT_OQ);
+    k = _mm256_add_pd(k, _mm256_and_pd(hi, one));
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), hi);
+
+    __m256d f = _mm256_sub_pd(m, one);
+    __m256d s = _mm256_div_pd(f, _mm256_add_pd(f, _mm256_set1_pd(2.0)));
+    __m256d z = _mm256_mul_pd(s, s);
+    __m256d w = _mm256_mul_pd(z, z);
+    __m256d R = _mm256_add_pd(_mm256_mul_pd(z, vm_poly_pd(w, vm_log_odd_d)),
+                              _mm256_mul_pd(w, vm_poly_pd(w, vm_log_even_d)));
+    __m256d hfsq = _mm256_mul_pd(_mm256_mul_pd(f, f), _mm256_set1_pd(0.5));
+    // k ln2_hi - ((hfsq - (s (hfsq + R) + k ln2_lo)) - f)
+    __m256d t = _mm256_fmadd_pd(s, _mm256_add_pd(hfsq, R),
+                                _mm256_mul_pd(k, _mm256_set1_pd(1.90821492927058770002e-10)));
+    t = _mm256_sub_pd(_mm256_sub_pd(hfsq, t), f);
+    __m256d r = _mm256_fmsub_pd(k, _mm256_set1_pd(6.93147180369123816490e-01), t);
+
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d inf = _mm256_set1_pd(__builtin_inf());
+    r = _mm256_blendv_pd(r, _mm256_set1_pd(__builtin_nan("")), _mm256_cmp_pd(x, zero, _CMP_NGE_UQ));
+    r = _mm256_blendv_pd(r, _mm256_sub_pd(zero, inf), _mm256_cmp_pd(x, zero, _CMP_EQ_OQ));
+    return _mm256_blendv_pd(r, inf, _mm256_cmp_pd(x, inf, _CMP_EQ_OQ));
+}
+
+static inline __m256d vm_tanh_pd(__m256d x) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d a = _mm256_add_pd(_mm256_andnot_pd(sign, x), _mm256_andnot_pd(sign, x));
+    __m256d e = vm_expm1_pd(_mm256_min_pd(_mm256_set1_pd(40.0), a));
+    __m256d t = _mm256_div_pd(e, _mm256_add_pd(e, _mm256_set1_pd(2.0)));
+    return _mm256_or_pd(t, _mm256_and_pd(sign, x));
+}
+
+static inline __m256d vm_sigmoid_pd(__m256d x) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d e = vm_exp_pd(_mm256_sub_pd(_mm256_setzero_pd(), x));
+    return _mm256_div_pd(one, _mm256_add_pd(one, e));
+}
+
+// erfc(a) for a >= 0.84375 (clamped to <= 27.5, past the underflow),
+// a^2 = a2_hi + a2_lo exactly
+static inline __m256d vm_erfc_tail_pd(__m256d a, __m256d a2_hi, __m256d a2_lo) {
+    __m256d near = _mm256_cmp_pd(a, _mm256_set1_pd(2.0), _CMP_LT_OQ);
+    __m256d h = _mm256_setzero_pd();
+    int m = _mm256_movemask_pd(near);
+    if (m != 0xF) {
+        __m256d u = _mm256_div_pd(_mm256_set1_pd(1.0), a);
+        __m256d t = _mm256_fmadd_pd(u, _mm256_set1_pd(4.3076923076923075),
+                                    _mm256_set1_pd(-1.1538461538461537));
+        h = _mm256_mul_pd(vm_poly_pd(t, vm_erfc_far_d), u);
+    }
+    if (m != 0) {
+        __m256d t = _mm256_fmadd_pd(a, _mm256_set1_pd(1.7297297297297298),
+                                    _mm256_set1_pd(-2.4594594594594597));
+        h = _mm256_blendv_pd(h, vm_poly_pd(t, vm_erfc_near_d), near);
+    }
+    __m256d e = vm_exp_pd(_mm256_sub_pd(_mm256_setzero_pd(), a2_hi));
+    e = _mm256_fnmadd_pd(e, a2_lo, e);
+    return _mm256_mul_pd(e, h);
+}
+
+static inline __m256d vm_erf_small_pd(__m256d z) {
+    __m256d t = _mm256_fmadd_pd(z, _mm256_set1_pd(2.8093278463648832), _mm256_set1_pd(-1.0));
+    return vm_poly_pd(t, vm_erf_small_d);
+}
+
+static inline __m256d vm_erf_pd(__m256d x) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d a = _mm256_min_pd(_mm256_set1_pd(27.5), _mm256_andnot_pd(sign, x));
+    __m256d z = _mm256_mul_pd(a, a);
+    __m256d small = _mm256_cmp_pd(a, _mm256_set1_pd(0.84375), _CMP_LT_OQ);
+    __m256d r = _mm256_fmadd_pd(a, vm_erf_small_pd(z), a);
+    if (_mm256_movemask_pd(small) != 0xF) {
+        __m256d c = vm_erfc_tail_pd(a, z, _mm256_fmsub_pd(a, a, z));
+        r = _mm256_blendv_pd(_mm256_sub_pd(one, c), r, small);
+    }
+    return _mm256_or_pd(r, _mm256_and_pd(sign, x));
+}
+
+static inline __m256d vm_gelu_pd(__m256d x) {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d lim = _mm256_set1_pd(39.0);  // |x| / sqrt 2 > 27.5: erfc is 0 or 2
+    __m256d xc = _mm256_max_pd(_mm256_sub_pd(_mm256_setzero_pd(), lim), _mm256_min_pd(lim, x));
+
+    __m256d w = _mm256_mul_pd(xc, _mm256_set1_pd(-0.70710678118654757));
+    __m256d a = _mm256_andnot_pd(_mm256_set1_pd(-0.0), w);
+    __m256d x2 = _mm256_mul_pd(xc, xc);
+    __m256d w2 = _mm256_mul_pd(x2, half);
+    __m256d small = _mm256_cmp_pd(a, _mm256_set1_pd(0.84375), _CMP_LT_OQ);
+    __m256d c = _mm256_fmadd_pd(w, vm_erf_small_pd(w2), _mm256_sub_pd(w, half));
+    c = _mm256_sub_pd(half, c);
+    if (_mm256_movemask_pd(small) != 0xF) {
+        __m256d lo = _mm256_mul_pd(_mm256_fmsub_pd(xc, xc, x2), half);
+        __m256d t = vm_erfc_tail_pd(a, w2, lo);
+        __m256d neg = _mm256_cmp_pd(w, _mm256_setzero_pd(), _CMP_LT_OQ);
+        t = _mm256_blendv_pd(t, _mm256_sub_pd(_mm256_set1_pd(2.0), t), neg);
+        c = _mm256_blendv_pd(t, c, small);
+    }
+    __m256d r = _mm256_mul_pd(_mm256_mul_pd(x, half), c);
+    return _mm256_andnot_pd(_mm256_cmp_pd(x, _mm256_sub_pd(_mm256_setzero_pd(), lim), _CMP_LT_OQ),
+                            r);
+}
+
+// ============================================================
+// Arrays: y[i] = f(x[i]), in place allowed
+// ============================================================
+
+template <class F>
+static inline void vm_map_ps(F f, const float* x, float* y, size_t n) {
+    sl_for<float>(y, n,
+        [&](size_t i, int) { _mm256_store_ps(y + i, f(_mm256_loadu_ps(x + i))); },
+        [&](size_t i, __m256i m) { _mm256_maskstore_ps(y + i, m, f(_mm256_maskload_ps(x + i, m))); });
+}
+
+template <class F>
+static inline void vm_map_pd(F f, const double* x, double* y, size_t n) {
+    sl_for<double>(y, n,
+        [&](size_t i, int) { _mm256_store_pd(y + i, f(_mm256_loadu_pd(x + i))); },
+        [&](size_t i, __m256i m) { _mm256_maskstore_pd(y + i, m, f(_mm256_maskload_pd(x + i, m))); });
+}
+
+#endif // VMATH_H
@@ -0,0 +1,263 @@
+// vmath_bench.cpp - vmath.h against libm: max ulp error and elements/ns
+// Compile: g++ -O3 -mavx2 -mfma -std=c++14 vmath_bench.cpp -o vmath_bench
+// Run: ./vmath_bench [samples]      (accuracy samples per function, default 2M)
+//
+// Error is measured in ulps of the exact result, taken from the next
+// precision up (double libm for float, long double for double), over
+// random inputs in the range shown (log: every positive finite bit
+// pattern, denormals included). libm's own error is in the next column:
+// the vector versions give up a few ulps at most for running 8 (4) lanes
+// without per-element branches. Throughput is from L1 (4096 elements,
+// repeated).
+// GELU has no libm function; its libm column is x/2 erfc(-x / sqrt 2)
+// with erfcf / erfc, which also loses accuracy for negative x, where
+// the rounding of x / sqrt 2 is amplified by x^2.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "vmath.h"
+using namespace std;
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+enum { F_EXP, F_LOG, F_TANH, F_SIGMOID, F_ERF, F_GELU, F_COUNT };
+static const char* fn_names[F_COUNT] = {"exp", "log", "tanh", "sigmoid", "erf", "gelu"};
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint64_t next_u64() {
+    rng ^= rng << 13, rng ^= rng >> 7, rng ^= rng << 17;
+    return rng;
+}
+static double next_unit() { return (double)(next_u64() >> 11) / 9007199254740992.0; }
+
+// ============================================================
+// Per-type glue: ranges, reference, libm and vector versions
+// ============================================================
+
+template <class T>
+struct vm;
+
+template <>
+struct vm<float> {
+    typedef double ref_t;
+    static const char* name() { return "float"; }
+    static const int mant = 24, min_exp = -149;
+    static constexpr double range[F_COUNT] = {88.0, 0, 10.0, 30.0, 5.0, 10.0};
+
+    static float random_positive() {
+        for (;;) {
+            uint32_t b = (uint32_t)next_u64() & 0x7fffffffu;
+            float x;
+            memcpy(&x, &b, sizeof x);
+            if (isfinite(x) && x > 0) return x;
+        }
+    }
+    static double ref(int f, float x) {
+        double d = x;
+        switch (f) {
+            case F_EXP: return exp(d);
+            case F_LOG: return log(d);
+            case F_TANH: return tanh(d);
+            case F_SIGMOID: return 1.0 / (1.0 + exp(-d));
+            case F_ERF: return erf(d);
+            default: return 0.5 * d * erfc(-d * M_SQRT1_2);
+        }
+    }
+    static float libm(int f, float x) {
+        switch (f) {
+            case F_EXP: return expf(x);
+            case F_LOG: return logf(x);
+            case F_TANH: return tanhf(x);
+            case F_SIGMOID: return 1.0f / (1.0f + expf(-x));
+            case F_ERF: return erff(x);
+            default: return 0.5f * x * erfcf(-x * (float)M_SQRT1_2);
+        }
+    }
+    static void simd(int f, const float* x, float* y, size_t n) {
+        switch (f) {
+            case F_EXP: vm_map_ps([](__m256 v) { return vm_exp_ps(v); }, x, y, n); break;
+            case F_LOG: vm_map_ps([](__m256 v) { return vm_log_ps(v); }, x, y, n); break;
+            case F_TANH: vm_map_ps([](__m256 v) { return vm_tanh_ps(v); }, x, y, n); break;
+            case F_SIGMOID: vm_map_ps([](__m256 v) { return vm_sigmoid_ps(v); }, x, y, n); break;
+            case F_ERF: vm_map_ps([](__m256 v) { return vm_erf_ps(v); }, x, y, n); break;
+            default: vm_map_ps([](__m256 v) { return vm_gelu_ps(v); }, x, y, n); break;
+        }
+    }
+};
+constexpr double vm<float>::range[F_COUNT];
+
+template <>
+struct vm<double> {
+    typedef long double ref_t;
+    static const char* name() { return "double"; }
+    static const int mant = 53, min_exp = -1074;
+    static constexpr double range[F_COUNT] = {708.0, 0, 20.0, 60.0, 7.0, 10.0};
+
+    static double random_positive() {
+        for (;;) {
+            uint64_t b = next_u64() & 0x7fffffffffffffffull;
+            double x;
+            memcpy(&x, &b, sizeof x);
+            if (isfinite(x) && x > 0) return x;
+        }
+    }
+    static long double ref(int f, double x) {
+        long double d = x;
+        switch (f) {
+            case F_EXP: return expl(d);
+            case F_LOG: return logl(d);
+            case F_TANH: return tanhl(d);
+            case F_SIGMOID: return 1.0L / (1.0L + expl(-d));
+            case F_ERF: return erfl(d);
+            default: return 0.5L * d * erfcl(-d * sqrtl(0.5L));
+        }
+    }
+    static double libm(int f, double x) {
+        switch (f) {
+            case F_EXP: return exp(x);
+            case F_LOG: return log(x);
+            case F_TANH: return tanh(x);
+            case F_SIGMOID: return 1.0 / (1.0 + exp(-x));
+            case F_ERF: return erf(x);
+            default: return 0.5 * x * erfc(-x * M_SQRT1_2);
+        }
+    }
+    static void simd(int f, const double* x, double* y, size_t n) {
+        switch (f) {
+            case F_EXP: vm_map_pd([](__m256d v) { return vm_exp_pd(v); }, x, y, n); break;
+            case F_LOG: vm_map_pd([](__m256d v) { return vm_log_pd(v); }, x, y, n); break;
+            case F_TANH: vm_map_pd([](__m256d v) { return vm_tanh_pd(v); }, x, y, n); break;
+            case F_SIGMOID: vm_map_pd([](__m256d v) { return vm_sigmoid_pd(v); }, x, y, n); break;
+            case F_ERF: vm_map_pd([](__m256d v) { return vm_erf_pd(v); }, x, y, n); break;
+            default: vm_map_pd([](__m256d v) { return vm_gelu_pd(v); }, x, y, n); break;
+        }
+    }
+};
+constexpr double vm<double>::range[F_COUNT];
+
+// |y - r| in ulps of T at r
+template <class T>
+static double ulp_error(T y, typename vm<T>::ref_t r) {
+    if (isnan(r)) return isnan(y) ? 0 : 1e9;
+    if (isinf(r) || isinf(y)) return (long double)y == r ? 0 : 1e9;
+    int e;
+    frexp((long double)r, &e);
+    long double ulp = ldexpl(1.0L, max(e - vm<T>::mant, vm<T>::min_exp));
+    return (double)(fabsl((long double)y - (long double)r) / ulp);
+}
+
+template <class T>
+static T random_input(int f) {
+    if (f == F_LOG) return vm<T>::random_positive();
+    double r = vm<T>::range[f];
+    return (T)((2 * next_unit() - 1) * r);
+}
+
+// ============================================================
+// Accuracy, throughput, special values
+// ============================================================
+
+template <class T>
+static void accuracy(int f, size_t samples, double* simd_ulp, double* libm_ulp) {
+    const size_t batch = 4096;
+    T x[batch], y[batch];
+    *simd_ulp = *libm_ulp = 0;
+    for (size_t done = 0; done < samples; done += batch) {
+        for (size_t i = 0; i < batch; i++) x[i] = random_input<T>(f);
+        vm<T>::simd(f, x, y, batch);
+        for (size_t i = 0; i < batch; i++) {
+            typename vm<T>::ref_t r = vm<T>::ref(f, x[i]);
+            *simd_ulp = max(*simd_ulp, ulp_error<T>(y[i], r));
+            *libm_ulp = max(*libm_ulp, ulp_error<T>(vm<T>::libm(f, x[i]), r));
+        }
+    }
+}
+
+// Elements/ns over `reps` passes of n elements, best of 5
+template <class T, class F>
+static double throughput(size_t n, F&& pass) {
+    const int reps = 200;
+    double best = 1e30;
+    for (int r = 0; r < 5; r++) {
+        double t0 = now();
+        for (int k = 0; k < reps; k++) pass();
+        best = min(best, now() - t0);
+    }
+    return (double)n * reps / best / 1e9;
+}
+
+template <class T>
+static void type_rows(size_t samples) {
+    const size_t n = 4096;
+    T* x = (T*)aligned_alloc(64, n * sizeof(T));
+    T* y = (T*)aligned_alloc(64, n * sizeof(T));
+    if (!x || !y) abort();
+    printf("╟──────────────────────────────────────────────────────────────────────────────╢\n");
+    for (int f = 0; f < F_COUNT; f++) {
+        double su, lu;
+        accuracy<T>(f, samples, &su, &lu);
+        for (size_t i = 0; i < n; i++) x[i] = random_input<T>(f);
+        volatile T sink = 0;
+        double t_libm = throughput<T>(n, [&] {
+            for (size_t i = 0; i < n; i++) y[i] = vm<T>::libm(f, x[i]);
+            sink = y[n / 2];
+        });
+        double t_simd = throughput<T>(n, [&] {
+            vm<T>::simd(f, x, y, n);
+            sink = y[n / 2];
+        });
+        char range[16];
+        if (f == F_LOG)
+            snprintf(range, sizeof range, "(0, max]");
+        else
+            snprintf(range, sizeof range, "+-%g", vm<T>::range[f]);
+        printf("║ %-8s %-7s %-9s %8.2f %8.2f %10.3f %10.3f %8.1fx ║\n", fn_names[f],
+               vm<T>::name(), range, su, lu, t_libm, t_simd, t_simd / t_libm);
+    }
+    free(x);
+    free(y);
+}
+
+// Specials against libm (gelu(-inf) = 0, where x/2 erfc(...) gives NaN)
+template <class T>
+static int special_values() {
+    const T inf = numeric_limits<T>::infinity(), nan = numeric_limits<T>::quiet_NaN();
+    const T in[8] = {inf, -inf, nan, 0, -0.0f, -1, numeric_limits<T>::denorm_min(), 1};
+    int bad = 0;
+    for (int f = 0; f < F_COUNT; f++) {
+        T y[8];
+        vm<T>::simd(f, in, y, 8);
+        for (int i = 0; i < 8; i++) {
+            T want = f == F_GELU && in[i] == -inf ? 0 : vm<T>::libm(f, in[i]);
+            if (isnan(want) ? isnan(y[i]) : y[i] == want || ulp_error<T>(y[i], want) <= 4)
+                continue;
+            printf("  %s %s(%g) = %g, libm %g\n", vm<T>::name(), fn_names[f], (double)in[i],
+                   (double)y[i], (double)want);
+            bad++;
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char** argv) {
+    size_t samples = argc > 1 ? strtoull(argv[1], NULL, 10) : 2000000;
+    printf("\n");
+    printf("╔══════════════════════════════════════════════════════════════════════════════╗\n");
+    printf("║  vmath.h vs libm: max ulp error, elements/ns from L1                         ║\n");
+    printf("╟──────────────────────────────────────────────────────────────────────────────╢\n");
+    printf("║ %-8s %-7s %-9s %8s %8s %10s %10s %9s ║\n", "function", "type", "range", "ulp",
+           "libm ulp", "libm", "AVX2", "speedup");
+    type_rows<float>(samples);
+    type_rows<double>(samples);
+    printf("╚══════════════════════════════════════════════════════════════════════════════╝\n");
+    int bad = special_values<float>() + special_values<double>();
+    printf("\nSpecial values (inf, NaN, +-0, -1, denormal): %s\n", bad ? "MISMATCH" : "ok");
+    return 0;
+}
@@ -0,0 +1,483 @@
+/*
+ * Complex GEMM (CGEMM) - Intel AVX2/FMA Version
+ *
+ * C = A * B for single-precision complex matrices stored interleaved
+ * (re, im, re, im, ...), row-major, leading dimensions in complex elements.
+ *
+ * Two ways to get there:
+ *
+ *   Plane methods: pack real / imaginary planes separately and run the
+ *   real 6x16 micro-kernel from gemm_kernels.h on them.
+ *
+ *     4M:  Cr = Ar*Br - Ai*Bi            4 real GEMMs (8 FLOPs per complex FMA)
+ *          Ci = Ar*Bi + Ai*Br
+ *
+ *     3M:  T1 = Ar*Br, T2 = Ai*Bi        3 real GEMMs (6 FLOPs per complex FMA)
+ *          T3 = (Ar+Ai)*(Br+Bi)          25% fewer FLOPs, but one more packed
+ *          Cr = T1 - T2                  plane of A and B, more work per tile,
+ *          Ci = T3 - T1 - T2             and a larger error in Ci
+ *
+ *   Direct: a 3x8 interleaved-complex kernel. Each YMM holds 4 complex
+ *   values; two accumulators per output vector collect ar*b and ai*b and
+ *   are merged at the end with one permute + addsub:
+ *
+ *     ar*b             = (ar br, ar bi)
+ *     swap(ai*b)       = (ai bi, ai br)
+ *     addsub(., .)     = (ar br - ai bi, ar bi + ai br)
+ *
+ *   3 rows x 8 complex x 2 accumulators = 12 YMM, same budget as 6x16.
+ *
+ * For the plane methods the real kernel runs on a scratch 6x16 tile per
+ * K-panel, and the tiles are combined straight into interleaved C, so no
+ * full-size real/imaginary planes of C are ever allocated.
+ *
+ * GFLOPS below always count 8*M*N*K (the 4M FLOP count), so 3M shows up
+ * as a higher "effective" rate.
+ *
+ * Build: make gemm_complex
+ * Run:   OPENBLAS_NUM_THREADS=1 ./gemm_complex
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <immintrin.h>
+#include <cblas.h>
+
+#include "gemm_kernels.h"
+
+// Complex blocking: three packed B planes of KC_C x NC_C stay in L2 (768 KB)
+#define MC_C 1020
+#define KC_C 128
+#define NC_C 512
+
+// Direct interleaved kernel: 3 complex rows x 8 complex columns
+#define MR3 3
+#define NR8C 8
+
+typedef enum { CGEMM_AUTO, CGEMM_4M, CGEMM_3M } cgemm_algo;
+
+// ============================================================================
+// Utilities
+// ============================================================================
+
+static inline double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void init_random(float* m, size_t size) {
+    for (size_t i = 0; i < size; i++)
+        m[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+// max |a - b| / max |b| over interleaved complex arrays
+static float rel_error(const float* a, const float* b, size_t n) {
+    float max_d = 0, max_b = 0;
+    for (size_t i = 0; i < 2 * n; i++) {
+        float d = fabsf(a[i] - b[i]);
+        if (d > max_d) max_d = d;
+        if (fabsf(b[i]) > max_b) max_b = fabsf(b[i]);
+    }
+    return max_b > 0 ? max_d / max_b : max_d;
+}
+
+static float* alloc_floats(size_t n) {
+    float* p = NULL;
+    if (posix_memalign((void**)&p, 64, n * sizeof(float)) != 0) abort();
+    return p;
+}
+
+// ============================================================================
+// Plane packing
+// ============================================================================
+/*
+ * A slice (mr <= 6 complex rows, kc columns) -> three 6-row real slices:
+ *   re = Ar, im = Ai, x = -Ai (4M) or Ar + Ai (3M)
+ * Rows past mr are zero.
+ */
+static void pack_A_planes_6(const float* A, int lda, int row, int mr, int pc, int kc,
+                            float* re, float* im, float* x, cgemm_algo algo) {
+    for (int k = 0; k < kc; k++) {
+        for (int i = 0; i < MR6; i++) {
+            float ar = 0.0f, ai = 0.0f;
+            if (i < mr) {
+                const float* a = A + 2 * ((size_t)(row + i) * lda + pc + k);
+                ar = a[0];
+                ai = a[1];
+            }
+            re[k * MR6 + i] = ar;
+            im[k * MR6 + i] = ai;
+            x[k * MR6 + i] = (algo == CGEMM_3M) ? ar + ai : -ai;
+        }
+    }
+}
+
+/*
+ * B slice (nr <= 16 complex columns, kc rows) -> real slices re = Br, im = Bi,
+ * and for 3M also sum = Br + Bi. De-interleaves 8 complex values per step.
+ */
+static void pack_B_planes_16(const float* B, int ldb, int pc, int col, int nr, int kc,
+                             float* re, float* im, float* sum) {
+    for (int k = 0; k < kc; k++) {
+        const float* b = B + 2 * ((size_t)(pc + k) * ldb + col);
+        float* dr = re + k * NR16;
+        float* di = im + k * NR16;
+        if (nr == NR16) {
+            for (int h = 0; h < NR16; h += 8) {
+                __m256 v0 = _mm256_loadu_ps(b + 2 * h);      // r0 i0 r1 i1 | r2 i2 r3 i3
+                __m256 v1 = _mm256_loadu_ps(b + 2 * h + 8);  // r4 i4 r5 i5 | r6 i6 r7 i7
+                __m256 lo = _mm256_permute2f128_ps(v0, v1, 0x20);  // r0 i0 r1 i1 | r4 i4 r5 i5
+                __m256 hi = _mm256_permute2f128_ps(v0, v1, 0x31);  // r2 i2 r3 i3 | r6 i6 r7 i7
+                __m256 vr = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));  // r0 r1 r2 r3 | r4 ..
+                __m256 vi = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+                _mm256_storeu_ps(dr + h, vr);
+                _mm256_storeu_ps(di + h, vi);
+                if (sum) _mm256_storeu_ps(sum + k * NR16 + h, _mm256_add_ps(vr, vi));
+            }
+        } else {
+            for (int j = 0; j < NR16; j++) {
+                float br = (j < nr) ? b[2 * j] : 0.0f;
+                float bi = (j < nr) ? b[2 * j + 1] : 0.0f;
+                dr[j] = br;
+                di[j] = bi;
+                if (sum) sum[k * NR16 + j] = br + bi;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Tile combine: real/imag scratch tiles -> interleaved C
+// ============================================================================
+static inline void store_tile_complex(const float* tre, const float* tim,
+                                      float* C, int ldc, int mr, int nr, int first) {
+    if (mr == MR6 && nr == NR16) {
+        for (int i = 0; i < MR6; i++) {
+            float* c = C + 2 * (size_t)i * ldc;
+            for (int h = 0; h < NR16; h += 8) {
+                __m256 vr = _mm256_loadu_ps(tre + i * NR16 + h);
+                __m256 vi = _mm256_loadu_ps(tim + i * NR16 + h);
+                __m256 lo = _mm256_unpacklo_ps(vr, vi);  // r0 i0 r1 i1 | r4 i4 r5 i5
+                __m256 hi = _mm256_unpackhi_ps(vr, vi);  // r2 i2 r3 i3 | r6 i6 r7 i7
+                __m256 c0 = _mm256_permute2f128_ps(lo, hi, 0x20);
+                __m256 c1 = _mm256_permute2f128_ps(lo, hi, 0x31);
+                if (!first) {
+                    c0 = _mm256_add_ps(c0, _mm256_loadu_ps(c + 2 * h));
+                    c1 = _mm256_add_ps(c1, _mm256_loadu_ps(c + 2 * h + 8));
+                }
+                _mm256_storeu_ps(c + 2 * h, c0);
+                _mm256_storeu_ps(c + 2 * h + 8, c1);
+            }
+        }
+    } else {
+        for (int i = 0; i < mr; i++) {
+            float* c = C + 2 * (size_t)i * ldc;
+            for (int j = 0; j < nr; j++) {
+                c[2 * j]     = (first ? 0.0f : c[2 * j])     + tre[i * NR16 + j];
+                c[2 * j + 1] = (first ? 0.0f : c[2 * j + 1]) + tim[i * NR16 + j];
+            }
+        }
+    }
+}
+
+// ============================================================================
+// CGEMM via real planes (3M / 4M)
+// ============================================================================
+static cgemm_algo cgemm_choose(int M, int N, int K) {
+    // 3M runs 3 kernels per tile instead of 4, but packs a third plane of A
+    // and B and combines three scratch tiles per K-panel. Per tile that is
+    // a fixed cost against K steps of kernel work, so 3M wins once K is a
+    // few steps deep: measured ahead from K = 8 on, at every C size from
+    // 32x64 up, and behind at K = 4 (1024x1024x4: ~55 vs 30-45 GFLOPS* here).
+    // Below ~16x16 of C the two are within noise; those stay on 4M, which
+    // is also the more accurate one.
+    return (K >= 8 && (long)M * N >= 16 * 16) ? CGEMM_3M : CGEMM_4M;
+}
+
+static void cgemm_planes(int M, int N, int K,
+                         const float* A, int lda, const float* B, int ldb,
+                         float* C, int ldc, cgemm_algo algo) {
+    if (algo == CGEMM_AUTO) algo = cgemm_choose(M, N, K);
+    int three_m = (algo == CGEMM_3M);
+
+    float* Ap = alloc_floats(3 * (size_t)MR6 * KC_C);
+    float* Bp = alloc_floats(3 * (size_t)KC_C * (NC_C + NR16));
+    float* A_re = Ap;
+    float* A_im = Ap + MR6 * KC_C;
+    float* A_x  = Ap + 2 * MR6 * KC_C;
+    size_t b_plane = (size_t)KC_C * (NC_C + NR16);
+    float* B_re = Bp;
+    float* B_im = Bp + b_plane;
+    float* B_s  = Bp + 2 * b_plane;
+
+    float t1[MR6 * NR16] __attribute__((aligned(32)));
+    float t2[MR6 * NR16] __attribute__((aligned(32)));
+    float t3[MR6 * NR16] __attribute__((aligned(32)));
+
+    for (int jc = 0; jc < N; jc += NC_C) {
+        int nc = (jc + NC_C <= N) ? NC_C : (N - jc);
+
+        for (int pc = 0; pc < K; pc += KC_C) {
+            int kc = (pc + KC_C <= K) ? KC_C : (K - pc);
+            int first = (pc == 0);
+
+            for (int jr = 0; jr < nc; jr += NR16) {
+                int nr = (jr + NR16 <= nc) ? NR16 : (nc - jr);
+                size_t off = (size_t)(jr / NR16) * kc * NR16;
+                pack_B_planes_16(B, ldb, pc, jc + jr, nr, kc,
+                                 B_re + off, B_im + off, three_m ? B_s + off : NULL);
+            }
+
+            for (int ic = 0; ic < M; ic += MC_C) {
+                int mc = (ic + MC_C <= M) ? MC_C : (M - ic);
+
+                for (int ir = 0; ir < mc; ir += MR6) {
+                    int mr = (ir + MR6 <= mc) ? MR6 : (mc - ir);
+                    pack_A_planes_6(A, lda, ic + ir, mr, pc, kc, A_re, A_im, A_x, algo);
+
+                    for (int jr = 0; jr < nc; jr += NR16) {
+                        int nr = (jr + NR16 <= nc) ? NR16 : (nc - jr);
+                        size_t off = (size_t)(jr / NR16) * kc * NR16;
+                        float* c = C + 2 * ((size_t)(ic + ir) * ldc + jc + jr);
+
+                        if (three_m) {
+                            microkernel_6x16(A_re, B_re + off, t1, NR16, kc, 1);
+                            microkernel_6x16(A_im, B_im + off, t2, NR16, kc, 1);
+                            microkernel_6x16(A_x,  B_s + off,  t3, NR16, kc, 1);
+                            for (int t = 0; t < MR6 * NR16; t += 8) {
+                                __m256 v1 = _mm256_load_ps(t1 + t);
+                                __m256 v2 = _mm256_load_ps(t2 + t);
+                                __m256 v3 = _mm256_load_ps(t3 + t);
+                                _mm256_store_ps(t1 + t, _mm256_sub_ps(v1, v2));
+                                _mm256_store_ps(t3 + t, _mm256_sub_ps(v3, _mm256_add_ps(v1, v2)));
+                            }
+                            store_tile_complex(t1, t3, c, ldc, mr, nr, first);
+                        } else {
+                            microkernel_6x16(A_re, B_re + off, t1, NR16, kc, 1);  // Ar*Br
+                            microkernel_6x16(A_x,  B_im + off, t1, NR16, kc, 0);  // - Ai*Bi
+                            microkernel_6x16(A_re, B_im + off, t2, NR16, kc, 1);  // Ar*Bi
+                            microkernel_6x16(A_im, B_re + off, t2, NR16, kc, 0);  // + Ai*Br
+                            store_tile_complex(t1, t2, c, ldc, mr, nr, first);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    free(Ap);
+    free(Bp);
+}
+
+static void cgemm_4m(int M, int N, int K, const float* A, const float* B, float* C) {
+    cgemm_planes(M, N, K, A, K, B, N, C, N, CGEMM_4M);
+}
+
+static void cgemm_3m(int M, int N, int K, const float* A, const float* B, float* C) {
+    cgemm_planes(M, N, K, A, K, B, N, C, N, CGEMM_3M);
+}
+
+static void cgemm_auto(int M, int N, int K, const float* A, const float* B, float* C) {
+    cgemm_planes(M, N, K, A, K, B, N, C, N, CGEMM_AUTO);
+}
+
+// ============================================================================
+// Direct interleaved-complex kernel (3x8)
+// ============================================================================
+static inline void cmicrokernel_3x8(const float* A_packed, const float* B_packed,
+                                    float* C, int ldc, int kc, int first_k) {
+    // cXh_r: sum of ar*b, cXh_i: sum of ai*b, for row X, columns 4h..4h+3
+    __m256 c00r, c00i, c01r, c01i, c10r, c10i, c11r, c11i, c20r, c20i, c21r, c21i;
+    c00r = c00i = c01r = c01i = c10r = c10i = _mm256_setzero_ps();
+    c11r = c11i = c20r = c20i = c21r = c21i = _mm256_setzero_ps();
+
+    for (int k = 0; k < kc; k++) {
+        __m256 b0 = _mm256_loadu_ps(B_packed + k * 2 * NR8C + 0);
+        __m256 b1 = _mm256_loadu_ps(B_packed + k * 2 * NR8C + 8);
+        const float* a = A_packed + k * 2 * MR3;
+        __m256 ar, ai;
+        ar = _mm256_broadcast_ss(a + 0); ai = _mm256_broadcast_ss(a + 1);
+        c00r = _mm256_fmadd_ps(ar, b0, c00r); c01r = _mm256_fmadd_ps(ar, b1, c01r);
+        c00i = _mm256_fmadd_ps(ai, b0, c00i); c01i = _mm256_fmadd_ps(ai, b1, c01i);
+        ar = _mm256_broadcast_ss(a + 2); ai = _mm256_broadcast_ss(a + 3);
+        c10r = _mm256_fmadd_ps(ar, b0, c10r); c11r = _mm256_fmadd_ps(ar, b1, c11r);
+        c10i = _mm256_fmadd_ps(ai, b0, c10i); c11i = _mm256_fmadd_ps(ai, b1, c11i);
+        ar = _mm256_broadcast_ss(a + 4); ai = _mm256_broadcast_ss(a + 5);
+        c20r = _mm256_fmadd_ps(ar, b0, c20r); c21r = _mm256_fmadd_ps(ar, b1, c21r);
+        c20i = _mm256_fmadd_ps(ai, b0, c20i); c21i = _mm256_fmadd_ps(ai, b1, c21i);
+    }
+
+#define CMERGE_STORE(ptr, acc_r, acc_i)                                         \
+    do {                                                                        \
+        __m256 v = _mm256_addsub_ps(acc_r, _mm256_permute_ps(acc_i, 0xB1));     \
+        if (!first_k) v = _mm256_add_ps(v, _mm256_loadu_ps(ptr));               \
+        _mm256_storeu_ps(ptr, v);                                               \
+    } while (0)
+
+    CMERGE_STORE(C + 0 * 2 * ldc + 0, c00r, c00i); CMERGE_STORE(C + 0 * 2 * ldc + 8, c01r, c01i);
+    CMERGE_STORE(C + 1 * 2 * ldc + 0, c10r, c10i); CMERGE_STORE(C + 1 * 2 * ldc + 8, c11r, c11i);
+    CMERGE_STORE(C + 2 * 2 * ldc + 0, c20r, c20i); CMERGE_STORE(C + 2 * 2 * ldc + 8, c21r, c21i);
+#undef CMERGE_STORE
+}
+
+static void cgemm_direct(int M, int N, int K, const float* A, const float* B, float* C) {
+    int lda = K, ldb = N, ldc = N;
+    float* Ap = alloc_floats(2 * (size_t)MR3 * KC_C);
+    float* Bp = alloc_floats(2 * (size_t)KC_C * (NC_C + NR8C));
+    float tile[2 * MR3 * NR8C];
+
+    for (int jc = 0; jc < N; jc += NC_C) {
+        int nc = (jc + NC_C <= N) ? NC_C : (N - jc);
+
+        for (int pc = 0; pc < K; pc += KC_C) {
+            int kc = (pc + KC_C <= K) ? KC_C : (K - pc);
+            int first = (pc == 0);
+
+            // Pack B: kc x 8 complex per slice, interleaved, zero-padded
+            for (int jr = 0; jr < nc; jr += NR8C) {
+                int nr = (jr + NR8C <= nc) ? NR8C : (nc - jr);
+                float* dst = Bp + (size_t)(jr / NR8C) * kc * 2 * NR8C;
+                for (int k = 0; k < kc; k++) {
+                    const float* src = B + 2 * ((size_t)(pc + k) * ldb + jc + jr);
+                    if (nr == NR8C) {
+                        _mm256_storeu_ps(dst + k * 2 * NR8C, _mm256_loadu_ps(src));
+                        _mm256_storeu_ps(dst + k * 2 * NR8C + 8, _mm256_loadu_ps(src + 8));
+                    } else {
+                        for (int j = 0; j < 2 * NR8C; j++)
+                            dst[k * 2 * NR8C + j] = (j < 2 * nr) ? src[j] : 0.0f;
+                    }
+                }
+            }
+
+            for (int ic = 0; ic < M; ic += MC_C) {
+                int mc = (ic + MC_C <= M) ? MC_C : (M - ic);
+
+                for (int ir = 0; ir < mc; ir += MR3) {
+                    int mr = (ir + MR3 <= mc) ? MR3 : (mc - ir);
+                    for (int k = 0; k < kc; k++)
+                        for (int i = 0; i < MR3; i++) {
+                            const float* a = A + 2 * ((size_t)(ic + ir + i) * lda + pc + k);
+                            Ap[k * 2 * MR3 + 2 * i]     = (i < mr) ? a[0] : 0.0f;
+                            Ap[k * 2 * MR3 + 2 * i + 1] = (i < mr) ? a[1] : 0.0f;
+                        }
+
+                    for (int jr = 0; jr < nc; jr += NR8C) {
+                        int nr = (jr + NR8C <= nc) ? NR8C : (nc - jr);
+                        const float* Bs = Bp + (size_t)(jr / NR8C) * kc * 2 * NR8C;
+                        float* c = C + 2 * ((size_t)(ic + ir) * ldc + jc + jr);
+                        if (mr == MR3 && nr == NR8C) {
+                            cmicrokernel_3x8(Ap, Bs, c, ldc, kc, first);
+                        } else {
+                            cmicrokernel_3x8(Ap, Bs, tile, NR8C, kc, 1);
+                            for (int i = 0; i < mr; i++)
+                                for (int j = 0; j < 2 * nr; j++)
+                                    c[2 * (size_t)i * ldc + j] = (first ? 0.0f : c[2 * (size_t)i * ldc + j])
+                                                                 + tile[i * 2 * NR8C + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    free(Ap);
+    free(Bp);
+}
+
+// ============================================================================
+// Reference (OpenBLAS)
+// ============================================================================
+static void cgemm_reference(int M, int N, int K, const float* A, const float* B, float* C) {
+    const float alpha[2] = {1.0f, 0.0f}, beta[2] = {0.0f, 0.0f};
+    cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                M, N, K, alpha, A, K, B, N, beta, C, N);
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+typedef void (*cgemm_func)(int, int, int, const float*, const float*, float*);
+
+int main(void) {
+    struct { int M, N, K; } shapes[] = {
+        {256, 256, 256},
+        {512, 512, 512},
+        {1024, 1024, 1024},
+        {1024, 1024, 64},   // short K
+        {1024, 1024, 16},   // very short K: 3M still ahead
+        {1024, 1024, 4},    // K = 4: 3M's extra packing/combine not amortized, auto picks 4M
+        {48, 1024, 1024},   // few rows
+        {12, 1024, 1024},   // two row slices
+        {32, 64, 512},      // small C: 3M still ahead
+        {1000, 1000, 1000}, // ragged edges
+    };
+    int n_shapes = sizeof(shapes) / sizeof(shapes[0]);
+
+    struct { const char* name; cgemm_func func; } impls[] = {
+        {"cblas_cgemm", cgemm_reference},
+        {"4M (planes)", cgemm_4m},
+        {"3M (planes)", cgemm_3m},
+        {"auto 3M/4M",  cgemm_auto},
+        {"direct 3x8",  cgemm_direct},
+    };
+    int n_impls = sizeof(impls) / sizeof(impls[0]);
+
+    printf("\n");
+    printf("╔════════════════════════════════════════════════════════════════════╗\n");
+    printf("║        Complex GEMM (CGEMM) - Intel AVX2/FMA, single thread        ║\n");
+    printf("╠════════════════════════════════════════════════════════════════════╣\n");
+    printf("║ Shape (MxNxK)        Impl           GFLOPS*   vs BLAS   rel.err    ║\n");
+    printf("╠════════════════════════════════════════════════════════════════════╣\n");
+
+    srand(42);
+    for (int s = 0; s < n_shapes; s++) {
+        int M = shapes[s].M, N = shapes[s].N, K = shapes[s].K;
+        float* A = alloc_floats(2 * (size_t)M * K);
+        float* B = alloc_floats(2 * (size_t)K * N);
+        float* C = alloc_floats(2 * (size_t)M * N);
+        float* C_ref = alloc_floats(2 * (size_t)M * N);
+        init_random(A, 2 * (size_t)M * K);
+        init_random(B, 2 * (size_t)K * N);
+        cgemm_reference(M, N, K, A, B, C_ref);
+
+        double flops = 8.0 * M * N * K;
+        int runs = (int)(4e9 / flops) + 1;
+        double ref_gflops = 0;
+        char shape[32];
+        snprintf(shape, sizeof(shape), "%dx%dx%d", M, N, K);
+
+        for (int t = 0; t < n_impls; t++) {
+            memset(C, 0, 2 * (size_t)M * N * sizeof(float));
+            impls[t].func(M, N, K, A, B, C);  // warmup
+            float err = rel_error(C, C_ref, (size_t)M * N);
+
+            double t0 = get_time();
+            for (int r = 0; r < runs; r++) impls[t].func(M, N, K, A, B, C);
+            double gflops = flops / ((get_time() - t0) / runs) / 1e9;
+            if (t == 0) ref_gflops = gflops;
+
+            const char* label = impls[t].name;
+            char auto_label[32];
+            if (impls[t].func == cgemm_auto) {
+                snprintf(auto_label, sizeof(auto_label), "auto -> %s",
+                         cgemm_choose(M, N, K) == CGEMM_3M ? "3M" : "4M");
+                label = auto_label;
+            }
+            printf("║ %-20s %-14s %7.1f   %6.1f%%   %.1e    ║\n",
+                   t == 0 ? shape : "", label, gflops, gflops / ref_gflops * 100, err);
+        }
+        if (s + 1 < n_shapes)
+            printf("╟────────────────────────────────────────────────────────────────────╢\n");
+
+        free(A);
+        free(B);
+        free(C);
+        free(C_ref);
+    }
+    printf("╚════════════════════════════════════════════════════════════════════╝\n");
+    printf("* GFLOPS = 8*M*N*K / time for every method (3M executes only 6*M*N*K).\n");
+    printf("  3M's imaginary part is computed as T3 - T1 - T2, so expect a larger error.\n");
+    return 0;
+}
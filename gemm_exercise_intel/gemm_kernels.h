@@ -0,0 +1,466 @@
+/*
+ * Shared AVX2/FMA GEMM Building Blocks
+ *
+ * The 6x16 / 4x16 micro-kernels from Stage 5 of gemm_progressive.c, an
+ * AVX2 packing engine for any panel width and source layout, and a
+ * general packed driver that handles any M, N, K and leading dimension.
+ * The extra drivers in this directory (out-of-core, complex, fused MLP,
+ * ...) are all built on top of these.
+ *
+ * Packed layouts (same as gemm_progressive.c):
+ *   A slice: KC x MR, element (i, k) at dst[k * MR + i]
+ *   B slice: KC x NR16, element (k, j) at dst[k * NR16 + j]
+ *
+ * Edge tiles (rows % 6, cols % 16) are handled by zero-padded packing
+ * and a scratch C tile, so the hot 6x16 kernel never sees a partial tile.
+ *
+ * Without AVX2/FMA (e.g. -mno-avx2, non-x86 targets), or with
+ * -DGEMM_GENERIC, packing and kernels come from gemm_kernels_generic.h
+ * (GCC vector extensions) and the driver below is unchanged.
+ */
+
+#ifndef GEMM_KERNELS_H
+#define GEMM_KERNELS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && !defined(GEMM_GENERIC)
+#define GEMM_KERNEL_AVX2 1
+#define GEMM_KERNEL_NAME "AVX2/FMA"
+#include <immintrin.h>
+#else
+#define GEMM_KERNEL_AVX2 0
+#define GEMM_KERNEL_NAME "generic vector_size"
+#endif
+
+#define MR4 4
+#define MR6 6
+#define NR16 16
+
+// Tuned blocking parameters (see Stage 6 in gemm_progressive.c)
+#define MC_TUNED 1024
+#define KC_TUNED 64
+#define NC_TUNED 1024
+
+// ============================================================================
+// Packing engine
+// ============================================================================
+/*
+ * Every packed panel, A or B, has the same shape: R "lanes" (rows of an A
+ * slice, columns of a B slice) interleaved along k,
+ *
+ *     dst[k * R + r] = M(r0 + r, k0 + k)     r < R, k < kc
+ *
+ * with lanes r >= nr zero-filled. Only the source layout changes which
+ * direction is contiguous:
+ *
+ *   k contiguous (A row-major, B col-major):  load 8 lanes x 8 k, transpose
+ *                                             8x8 in registers, store by k
+ *   r contiguous (A col-major, B row-major):  straight vector copy per k
+ *
+ * R can be anything (4, 6, 8, 16, ...): lanes are handled in groups of 8
+ * (groups of <= 4 use a 4x4 SSE transpose), and partial groups and the k
+ * tail use maskload/maskstore. For R < 8 the
+ * full 8-float store of step k spills into step k+1, which then
+ * overwrites it, so only the final k needs a masked store.
+ */
+
+typedef enum { PACK_ROW_MAJOR, PACK_COL_MAJOR } pack_layout;
+
+#if GEMM_KERNEL_AVX2
+
+static const int32_t pack_mask_table[16] = {-1, -1, -1, -1, -1, -1, -1, -1,
+                                             0,  0,  0,  0,  0,  0,  0,  0};
+
+// First n lanes set (0 <= n <= 8)
+static inline __m256i pack_tail_mask(int n) {
+    return _mm256_loadu_si256((const __m256i*)(pack_mask_table + 8 - n));
+}
+
+static inline void transpose_8x8_ps(__m256* r) {
+    __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+    __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+    __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+    __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+    __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// Force inlining so that pack_panel()'s constant R folds every lane branch
+#define PACK_INLINE static inline __attribute__((always_inline))
+
+// Store the first w lanes of v; `spill_ok` allows a full 8-wide store
+PACK_INLINE void pack_store_lanes(float* p, __m256 v, int w, int spill_ok) {
+    if (w == 8 || spill_ok) _mm256_storeu_ps(p, v);
+    else if (w == 4)        _mm_storeu_ps(p, _mm256_castps256_ps128(v));
+    else                    _mm256_maskstore_ps(p, pack_tail_mask(w), v);
+}
+
+// Groups of <= 4 lanes: 4 x 4 SSE transpose instead of half-empty 8 x 8
+PACK_INLINE void pack_group_transpose_4(const float* src, int ld, int rows, int w,
+                                        int kc, int R, float* dst) {
+    int k = 0;
+    if (rows == 4) {
+        // Full tiles: plain loads, constant trip counts (v[] stays in registers)
+        for (; k + 4 <= kc; k += 4) {
+            __m128 r0 = _mm_loadu_ps(src + 0 * (size_t)ld + k);
+            __m128 r1 = _mm_loadu_ps(src + 1 * (size_t)ld + k);
+            __m128 r2 = _mm_loadu_ps(src + 2 * (size_t)ld + k);
+            __m128 r3 = _mm_loadu_ps(src + 3 * (size_t)ld + k);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(dst + (size_t)(k + 0) * R, r0);
+            _mm_storeu_ps(dst + (size_t)(k + 1) * R, r1);
+            _mm_storeu_ps(dst + (size_t)(k + 2) * R, r2);
+            _mm_storeu_ps(dst + (size_t)(k + 3) * R, r3);
+        }
+    }
+    for (; k < kc; k += 4) {
+        int kn = (kc - k < 4) ? kc - k : 4;
+        __m128i km = _mm256_castsi256_si128(pack_tail_mask(kn));
+        __m128 v[4];
+        for (int i = 0; i < 4; i++) {
+            const float* s = src + (size_t)i * ld + k;
+            if (i >= rows)    v[i] = _mm_setzero_ps();
+            else if (kn == 4) v[i] = _mm_loadu_ps(s);
+            else              v[i] = _mm_maskload_ps(s, km);
+        }
+        _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+        for (int j = 0; j < kn; j++) {
+            float* p = dst + (size_t)(k + j) * R;
+            if (w == 4) _mm_storeu_ps(p, v[j]);
+            else        _mm_maskstore_ps(p, _mm256_castsi256_si128(pack_tail_mask(w)), v[j]);
+        }
+    }
+}
+
+// k contiguous: element (r, k) at src[r * ld + k]
+PACK_INLINE void pack_panel_transpose(const float* src, int ld, int nr, int kc,
+                                      int R, float* dst) {
+    for (int g = 0; g < R; g += 8) {
+        int w = (R - g < 8) ? R - g : 8;
+        int rows = (nr - g < w) ? nr - g : w;
+        if (rows < 0) rows = 0;
+
+        if (w <= 4) {
+            pack_group_transpose_4(src + (size_t)g * ld, ld, rows, w, kc, R, dst + g);
+            continue;
+        }
+        int k = 0;
+        if (rows == w) {
+            // Full tiles; the last one goes through the masked path below
+            for (; k + 8 < kc; k += 8) {
+                __m256 v[8];
+                for (int i = 0; i < 8; i++)
+                    v[i] = (i < w) ? _mm256_loadu_ps(src + (size_t)(g + i) * ld + k)
+                                   : _mm256_setzero_ps();
+                transpose_8x8_ps(v);
+                for (int j = 0; j < 8; j++)
+                    pack_store_lanes(dst + (size_t)(k + j) * R + g, v[j], w, R < 8);
+            }
+        }
+        for (; k < kc; k += 8) {
+            int kn = (kc - k < 8) ? kc - k : 8;
+            __m256i km = pack_tail_mask(kn);
+            __m256 v[8];
+            for (int i = 0; i < 8; i++) {
+                const float* s = src + (size_t)(g + i) * ld + k;
+                if (i >= rows)    v[i] = _mm256_setzero_ps();
+                else if (kn == 8) v[i] = _mm256_loadu_ps(s);
+                else              v[i] = _mm256_maskload_ps(s, km);
+            }
+            transpose_8x8_ps(v);
+            for (int j = 0; j < kn; j++)
+                pack_store_lanes(dst + (size_t)(k + j) * R + g, v[j], w, R < 8 && k + j + 1 < kc);
+        }
+    }
+}
+
+// r contiguous: element (r, k) at src[k * ld + r]
+PACK_INLINE void pack_panel_copy(const float* src, int ld, int nr, int kc,
+                                 int R, float* dst) {
+    for (int k = 0; k < kc; k++) {
+        const float* s = src + (size_t)k * ld;
+        for (int g = 0; g < R; g += 8) {
+            int w = (R - g < 8) ? R - g : 8;
+            int rows = (nr - g < w) ? nr - g : w;
+            __m256 v;
+            if (rows >= 8)     v = _mm256_loadu_ps(s + g);
+            else if (rows > 0) v = _mm256_maskload_ps(s + g, pack_tail_mask(rows));
+            else               v = _mm256_setzero_ps();
+            pack_store_lanes(dst + (size_t)k * R + g, v, w, R < 8 && k + 1 < kc);
+        }
+    }
+}
+
+PACK_INLINE void pack_panel_r(const float* src, int ld, pack_layout layout,
+                              int r0, int k0, int nr, int kc, int R, float* dst) {
+    if (layout == PACK_ROW_MAJOR)
+        pack_panel_transpose(src + (size_t)r0 * ld + k0, ld, nr, kc, R, dst);
+    else
+        pack_panel_copy(src + (size_t)k0 * ld + r0, ld, nr, kc, R, dst);
+}
+
+/*
+ * Pack nr (<= R) lanes starting at r0 and kc steps starting at k0 of M,
+ * where M is row-major (M(i,j) = src[i*ld + j]) or col-major (src[i + j*ld]).
+ */
+static inline void pack_panel(const float* src, int ld, pack_layout layout,
+                              int r0, int k0, int nr, int kc, int R, float* dst) {
+    switch (R) {
+    case 4:  pack_panel_r(src, ld, layout, r0, k0, nr, kc, 4, dst); break;
+    case 6:  pack_panel_r(src, ld, layout, r0, k0, nr, kc, 6, dst); break;
+    case 8:  pack_panel_r(src, ld, layout, r0, k0, nr, kc, 8, dst); break;
+    case 16: pack_panel_r(src, ld, layout, r0, k0, nr, kc, 16, dst); break;
+    default: pack_panel_r(src, ld, layout, r0, k0, nr, kc, R, dst); break;
+    }
+}
+
+#else
+#include "gemm_kernels_generic.h"  // portable pack_panel + micro-kernels
+#endif // GEMM_KERNEL_AVX2
+
+// A slice: rows row..row+mr of A (M x K), columns pc..pc+kc, MR lanes
+static inline void pack_A(const float* A, int lda, pack_layout layout,
+                          int row, int pc, int mr, int kc, int MR, float* dst) {
+    pack_panel(A, lda, layout, row, pc, mr, kc, MR, dst);
+}
+
+// B slice: columns col..col+nr of B (K x N), rows pc..pc+kc, NR lanes.
+// A row-major B is a column-major view of B^T, hence the layout flip.
+static inline void pack_B(const float* B, int ldb, pack_layout layout,
+                          int pc, int col, int nr, int kc, int NR, float* dst) {
+    pack_panel(B, ldb, layout == PACK_ROW_MAJOR ? PACK_COL_MAJOR : PACK_ROW_MAJOR,
+               col, pc, nr, kc, NR, dst);
+}
+
+// Fixed-shape entry points used by the stages in gemm_progressive.c
+static inline void pack_A_slice_6(const float* A, float* dst, int row, int pc, int lda, int KC) {
+    pack_A(A, lda, PACK_ROW_MAJOR, row, pc, MR6, KC, MR6, dst);
+}
+
+static inline void pack_A_slice_4(const float* A, float* dst, int row, int pc, int lda, int KC) {
+    pack_A(A, lda, PACK_ROW_MAJOR, row, pc, MR4, KC, MR4, dst);
+}
+
+static inline void pack_A_slice_6_edge(const float* A, float* dst, int row, int mr,
+                                       int pc, int lda, int KC) {
+    pack_A(A, lda, PACK_ROW_MAJOR, row, pc, mr, KC, MR6, dst);
+}
+
+static inline void pack_B_slice_16(const float* B, float* dst, int pc, int col, int nr,
+                                   int ldb, int KC) {
+    pack_B(B, ldb, PACK_ROW_MAJOR, pc, col, nr, KC, NR16, dst);
+}
+
+// ============================================================================
+// Micro-kernels
+// ============================================================================
+#if GEMM_KERNEL_AVX2
+
+// 6x16 micro-kernel (12 YMM for C, optimal FLOPs/load)
+static inline void microkernel_6x16(const float* A_packed, const float* B_packed,
+                                     float* C, int ldc, int KC, int first_k) {
+    __m256 c00, c01, c10, c11, c20, c21, c30, c31, c40, c41, c50, c51;
+
+    if (first_k) {
+        c00 = c01 = c10 = c11 = c20 = c21 = _mm256_setzero_ps();
+        c30 = c31 = c40 = c41 = c50 = c51 = _mm256_setzero_ps();
+    } else {
+        c00 = _mm256_loadu_ps(C + 0 * ldc + 0); c01 = _mm256_loadu_ps(C + 0 * ldc + 8);
+        c10 = _mm256_loadu_ps(C + 1 * ldc + 0); c11 = _mm256_loadu_ps(C + 1 * ldc + 8);
+        c20 = _mm256_loadu_ps(C + 2 * ldc + 0); c21 = _mm256_loadu_ps(C + 2 * ldc + 8);
+        c30 = _mm256_loadu_ps(C + 3 * ldc + 0); c31 = _mm256_loadu_ps(C + 3 * ldc + 8);
+        c40 = _mm256_loadu_ps(C + 4 * ldc + 0); c41 = _mm256_loadu_ps(C + 4 * ldc + 8);
+        c50 = _mm256_loadu_ps(C + 5 * ldc + 0); c51 = _mm256_loadu_ps(C + 5 * ldc + 8);
+    }
+
+    for (int k = 0; k < KC; k++) {
+        __m256 b0 = _mm256_loadu_ps(B_packed + k * NR16 + 0);
+        __m256 b1 = _mm256_loadu_ps(B_packed + k * NR16 + 8);
+        __m256 a;
+        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 0]);
+        c00 = _mm256_fmadd_ps(a, b0, c00); c01 = _mm256_fmadd_ps(a, b1, c01);
+        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 1]);
+        c10 = _mm256_fmadd_ps(a, b0, c10); c11 = _mm256_fmadd_ps(a, b1, c11);
+        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 2]);
+        c20 = _mm256_fmadd_ps(a, b0, c20); c21 = _mm256_fmadd_ps(a, b1, c21);
+        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 3]);
+        c30 = _mm256_fmadd_ps(a, b0, c30); c31 = _mm256_fmadd_ps(a, b1, c31);
+        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 4]);
+        c40 = _mm256_fmadd_ps(a, b0, c40); c41 = _mm256_fmadd_ps(a, b1, c41);
+        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 5]);
+        c50 = _mm256_fmadd_ps(a, b0, c50); c51 = _mm256_fmadd_ps(a, b1, c51);
+    }
+
+    _mm256_storeu_ps(C + 0 * ldc + 0, c00); _mm256_storeu_ps(C + 0 * ldc + 8, c01);
+    _mm256_storeu_ps(C + 1 * ldc + 0, c10); _mm256_storeu_ps(C + 1 * ldc + 8, c11);
+    _mm256_storeu_ps(C + 2 * ldc + 0, c20); _mm256_storeu_ps(C + 2 * ldc + 8, c21);
+    _mm256_storeu_ps(C + 3 * ldc + 0, c30); _mm256_storeu_ps(C + 3 * ldc + 8, c31);
+    _mm256_storeu_ps(C + 4 * ldc + 0, c40); _mm256_storeu_ps(C + 4 * ldc + 8, c41);
+    _mm256_storeu_ps(C + 5 * ldc + 0, c50); _mm256_storeu_ps(C + 5 * ldc + 8, c51);
+}
+
+// 4x16 micro-kernel (8 YMM for C, used for edge cases)
+static inline void microkernel_4x16(const float* A_packed, const float* B_packed,
+                                     float* C, int ldc, int KC, int first_k) {
+    __m256 c00, c01, c10, c11, c20, c21, c30, c31;
+
+    if (first_k) {
+        c00 = c01 = c10 = c11 = c20 = c21 = c30 = c31 = _mm256_setzero_ps();
+    } else {
+        c00 = _mm256_loadu_ps(C + 0 * ldc + 0); c01 = _mm256_loadu_ps(C + 0 * ldc + 8);
+        c10 = _mm256_loadu_ps(C + 1 * ldc + 0); c11 = _mm256_loadu_ps(C + 1 * ldc + 8);
+        c20 = _mm256_loadu_ps(C + 2 * ldc + 0); c21 = _mm256_loadu_ps(C + 2 * ldc + 8);
+        c30 = _mm256_loadu_ps(C + 3 * ldc + 0); c31 = _mm256_loadu_ps(C + 3 * ldc + 8);
+    }
+
+    for (int k = 0; k < KC; k++) {
+        __m256 b0 = _mm256_loadu_ps(B_packed + k * NR16 + 0);
+        __m256 b1 = _mm256_loadu_ps(B_packed + k * NR16 + 8);
+        __m256 a0 = _mm256_broadcast_ss(&A_packed[k * MR4 + 0]);
+        __m256 a1 = _mm256_broadcast_ss(&A_packed[k * MR4 + 1]);
+        __m256 a2 = _mm256_broadcast_ss(&A_packed[k * MR4 + 2]);
+        __m256 a3 = _mm256_broadcast_ss(&A_packed[k * MR4 + 3]);
+        c00 = _mm256_fmadd_ps(a0, b0, c00); c01 = _mm256_fmadd_ps(a0, b1, c01);
+        c10 = _mm256_fmadd_ps(a1, b0, c10); c11 = _mm256_fmadd_ps(a1, b1, c11);
+        c20 = _mm256_fmadd_ps(a2, b0, c20); c21 = _mm256_fmadd_ps(a2, b1, c21);
+        c30 = _mm256_fmadd_ps(a3, b0, c30); c31 = _mm256_fmadd_ps(a3, b1, c31);
+    }
+
+    _mm256_storeu_ps(C + 0 * ldc + 0, c00); _mm256_storeu_ps(C + 0 * ldc + 8, c01);
+    _mm256_storeu_ps(C + 1 * ldc + 0, c10); _mm256_storeu_ps(C + 1 * ldc + 8, c11);
+    _mm256_storeu_ps(C + 2 * ldc + 0, c20); _mm256_storeu_ps(C + 2 * ldc + 8, c21);
+    _mm256_storeu_ps(C + 3 * ldc + 0, c30); _mm256_storeu_ps(C + 3 * ldc + 8, c31);
+}
+
+#endif // GEMM_KERNEL_AVX2
+
+// Partial mr x nr tile: run the full 6x16 kernel on a scratch tile, copy back
+static inline void microkernel_6x16_edge(const float* A_packed, const float* B_packed,
+                                         float* C, int ldc, int KC, int first_k,
+                                         int mr, int nr) {
+    float tile[MR6 * NR16];
+    for (int i = 0; i < MR6; i++)
+        for (int j = 0; j < NR16; j++)
+            tile[i * NR16 + j] = (!first_k && i < mr && j < nr) ? C[i * ldc + j] : 0.0f;
+
+    microkernel_6x16(A_packed, B_packed, tile, NR16, KC, 0);
+
+    for (int i = 0; i < mr; i++)
+        for (int j = 0; j < nr; j++)
+            C[i * ldc + j] = tile[i * NR16 + j];
+}
+
+// ============================================================================
+// General packed driver
+// ============================================================================
+/*
+ * C[M,N] (+)= A[M,K] * B[K,N] with leading dimensions; C is row-major,
+ * A and B may each be row- or column-major (gemm_packed_ws_layout).
+ * accumulate = 0 overwrites C, accumulate = 1 adds to it.
+ *
+ * Loop order follows Stage 7 (lazy A packing) with an extra NC loop so
+ * B_packed stays bounded for any N. The workspace lets hot callers (e.g.
+ * per-panel or per-row-block drivers) reuse the packing buffers.
+ */
+typedef struct {
+    float* A_packed;  // (MC_TUNED + MR6) x KC_TUNED
+    float* B_packed;  // KC_TUNED x (NC_TUNED + NR16)
+} gemm_workspace;
+
+static inline void gemm_workspace_init(gemm_workspace* ws) {
+    if (posix_memalign((void**)&ws->A_packed, 64, (MC_TUNED + MR6) * KC_TUNED * sizeof(float)) != 0) abort();
+    if (posix_memalign((void**)&ws->B_packed, 64, KC_TUNED * (NC_TUNED + NR16) * sizeof(float)) != 0) abort();
+}
+
+static inline void gemm_workspace_free(gemm_workspace* ws) {
+    free(ws->A_packed);
+    free(ws->B_packed);
+}
+
+static inline void gemm_packed_ws_layout(int M, int N, int K,
+                                         const float* A, int lda, pack_layout layout_A,
+                                         const float* B, int ldb, pack_layout layout_B,
+                                         float* C, int ldc,
+                                         int accumulate, gemm_workspace* ws) {
+    if (K <= 0) {
+        if (!accumulate)
+            for (int i = 0; i < M; i++) memset(C + (size_t)i * ldc, 0, N * sizeof(float));
+        return;
+    }
+
+    for (int jc = 0; jc < N; jc += NC_TUNED) {
+        int nc = (jc + NC_TUNED <= N) ? NC_TUNED : (N - jc);
+
+        for (int pc = 0; pc < K; pc += KC_TUNED) {
+            int kc = (pc + KC_TUNED <= K) ? KC_TUNED : (K - pc);
+            int first_k = (pc == 0) && !accumulate;
+
+            for (int jr = 0; jr < nc; jr += NR16) {
+                int nr = (jr + NR16 <= nc) ? NR16 : (nc - jr);
+                pack_B(B, ldb, layout_B, pc, jc + jr, nr, kc, NR16, ws->B_packed + (jr / NR16) * kc * NR16);
+            }
+
+            for (int ic = 0; ic < M; ic += MC_TUNED) {
+                int mc = (ic + MC_TUNED <= M) ? MC_TUNED : (M - ic);
+
+                for (int ir = 0; ir < mc; ir += MR6) {
+                    int mr = (ir + MR6 <= mc) ? MR6 : (mc - ir);
+                    float* A_slice = ws->A_packed + (ir / MR6) * MR6 * kc;
+                    pack_A(A, lda, layout_A, ic + ir, pc, mr, kc, MR6, A_slice);
+
+                    for (int jr = 0; jr < nc; jr += NR16) {
+                        int nr = (jr + NR16 <= nc) ? NR16 : (nc - jr);
+                        const float* B_slice = ws->B_packed + (jr / NR16) * kc * NR16;
+                        float* c_ptr = C + (size_t)(ic + ir) * ldc + jc + jr;
+                        if (mr == MR6 && nr == NR16)
+                            microkernel_6x16(A_slice, B_slice, c_ptr, ldc, kc, first_k);
+                        else
+                            microkernel_6x16_edge(A_slice, B_slice, c_ptr, ldc, kc, first_k, mr, nr);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static inline void gemm_packed_ws(int M, int N, int K,
+                                  const float* A, int lda,
+                                  const float* B, int ldb,
+                                  float* C, int ldc,
+                                  int accumulate, gemm_workspace* ws) {
+    gemm_packed_ws_layout(M, N, K, A, lda, PACK_ROW_MAJOR, B, ldb, PACK_ROW_MAJOR,
+                          C, ldc, accumulate, ws);
+}
+
+static inline void gemm_packed(int M, int N, int K,
+                               const float* A, int lda,
+                               const float* B, int ldb,
+                               float* C, int ldc, int accumulate) {
+    gemm_workspace ws;
+    gemm_workspace_init(&ws);
+    gemm_packed_ws(M, N, K, A, lda, B, ldb, C, ldc, accumulate, &ws);
+    gemm_workspace_free(&ws);
+}
+
+#endif // GEMM_KERNELS_H
@@ -0,0 +1,112 @@
+/*
+ * Portable GEMM Building Blocks (GCC/Clang vector extensions)
+ *
+ * Drop-in replacements for the AVX2 packing engine and micro-kernels in
+ * gemm_kernels.h, selected there when the target has no AVX2/FMA (or
+ * with -DGEMM_GENERIC). Same names, same packed layouts, so the general
+ * driver and every program built on it work unchanged.
+ *
+ * The vector type is sized to the target's native register (16 bytes on
+ * SSE2/NEON, 32 with AVX, 64 with AVX-512), and the 6x16 tile is held as
+ * 6 x (16 / lanes) of them. The loops below have constant trip counts,
+ * so the compiler unrolls them and keeps the tile in registers, exactly
+ * like the hand-written microkernel_6x16. `c += a * b` becomes an FMA
+ * whenever the target has one (-ffp-contract=fast is GCC's default
+ * outside ISO mode).
+ *
+ * On 16-register SSE2 the 24 accumulators of the 6x16 tile do not all
+ * fit, so expect some spilling there; AArch64 (32 registers), AVX (12
+ * accumulators) and AVX-512 (6) hold the whole tile.
+ *
+ * Not meant to be included directly: needs MR4/MR6/NR16 and pack_layout
+ * from gemm_kernels.h.
+ */
+
+#ifndef GEMM_KERNELS_GENERIC_H
+#define GEMM_KERNELS_GENERIC_H
+
+#include <string.h>
+
+#if defined(__AVX512F__)
+#define GEMM_GV_BYTES 64
+#elif defined(__AVX__)
+#define GEMM_GV_BYTES 32
+#else
+#define GEMM_GV_BYTES 16
+#endif
+
+#define GV_LANES (GEMM_GV_BYTES / (int)sizeof(float))
+#define GV_COLS (NR16 / GV_LANES)  // vectors per 16-wide row of C
+
+typedef float gv __attribute__((vector_size(GEMM_GV_BYTES)));
+
+// Unaligned load/store; memcpy compiles to plain vector moves
+#define GV_LOAD(v, p)  memcpy(&(v), (p), sizeof(gv))
+#define GV_STORE(p, v) memcpy((p), &(v), sizeof(gv))
+
+// ============================================================================
+// Packing (portable)
+// ============================================================================
+/*
+ * Same panel format as the AVX2 engine: dst[k * R + r] = M(r0 + r, k0 + k),
+ * lanes r >= nr zero-filled. The lane loop is innermost so the
+ * contiguous (column-major) case auto-vectorizes.
+ */
+static inline void pack_panel(const float* src, int ld, pack_layout layout,
+                              int r0, int k0, int nr, int kc, int R, float* dst) {
+    for (int k = 0; k < kc; k++) {
+        float* d = dst + (size_t)k * R;
+        if (layout == PACK_ROW_MAJOR) {
+            const float* s = src + (size_t)r0 * ld + k0 + k;
+            for (int r = 0; r < nr; r++) d[r] = s[(size_t)r * ld];
+        } else {
+            const float* s = src + (size_t)(k0 + k) * ld + r0;
+            for (int r = 0; r < nr; r++) d[r] = s[r];
+        }
+        for (int r = nr; r < R; r++) d[r] = 0.0f;
+    }
+}
+
+// ============================================================================
+// Micro-kernels (portable)
+// ============================================================================
+
+// MR x 16 micro-kernel: MR * GV_COLS C vectors (12 YMM at 32 bytes, as in
+// the AVX2 6x16), one broadcast of A per row, GV_COLS loads of B per k
+static inline __attribute__((always_inline))
+void microkernel_gv(const float* A_packed, const float* B_packed, float* C, int ldc,
+                    int KC, int first_k, const int MR) {
+    gv c[MR6][GV_COLS];
+
+    for (int i = 0; i < MR; i++)
+        for (int j = 0; j < GV_COLS; j++) {
+            if (first_k) c[i][j] = (gv){0};
+            else         GV_LOAD(c[i][j], C + i * ldc + j * GV_LANES);
+        }
+
+    for (int k = 0; k < KC; k++) {
+        gv b[GV_COLS];
+        for (int j = 0; j < GV_COLS; j++) GV_LOAD(b[j], B_packed + k * NR16 + j * GV_LANES);
+        for (int i = 0; i < MR; i++) {
+            gv a = (gv){0} + A_packed[k * MR + i];  // broadcast
+            for (int j = 0; j < GV_COLS; j++) c[i][j] += a * b[j];
+        }
+    }
+
+    for (int i = 0; i < MR; i++)
+        for (int j = 0; j < GV_COLS; j++) GV_STORE(C + i * ldc + j * GV_LANES, c[i][j]);
+}
+
+// 6x16 micro-kernel (bulk tiles)
+static inline void microkernel_6x16(const float* A_packed, const float* B_packed,
+                                    float* C, int ldc, int KC, int first_k) {
+    microkernel_gv(A_packed, B_packed, C, ldc, KC, first_k, MR6);
+}
+
+// 4x16 micro-kernel (edge rows in gemm_progressive.c's stages)
+static inline void microkernel_4x16(const float* A_packed, const float* B_packed,
+                                    float* C, int ldc, int KC, int first_k) {
+    microkernel_gv(A_packed, B_packed, C, ldc, KC, first_k, MR4);
+}
+
+#endif // GEMM_KERNELS_GENERIC_H
@@ -0,0 +1,272 @@
+/*
+ * Fused MLP Chain - Intel AVX2/FMA Version
+ *
+ * Y = act(X * W1) * W2      X: T x D,  W1: D x H,  W2: H x D,  Y: T x D
+ *
+ * Unfused: two gemm_packed() calls with the full T x H hidden matrix in
+ * between. For H = 16k and T = 2048 that is 128 MB written, re-read and
+ * re-written by the activation, then read again by the second GEMM.
+ *
+ * Fused: the activation is elementwise, so the hidden dimension can be
+ * split into chunks and each chunk finished before the next is started:
+ *
+ *   for each row-block of X (MB rows)
+ *     for each hidden chunk hc (HC columns of W1 / rows of W2)
+ *       Hbuf  = X[rows] * W1[:, hc]        MB x HC, stays in L2
+ *       Hbuf  = act(Hbuf)
+ *       Y[rows] += Hbuf * W2[hc, :]        Y row-block stays in LLC
+ *
+ * The hidden matrix never leaves the cache. The price is that W1 and W2
+ * are streamed once per row-block instead of once in total, so fusion
+ * saves DRAM traffic when
+ *
+ *   ceil(T/MB) * 8*D*H  <  16*T*H   i.e.   MB > D/2 (roughly)
+ *
+ * which is why MB defaults to about D rows.
+ *
+ * DRAM traffic is reported from a simple compulsory-traffic model and,
+ * when perf_event_open() is permitted, from LLC misses x 64 bytes.
+ *
+ * Build: make gemm_mlp
+ * Run:   ./gemm_mlp [T] [D] [relu|gelu]      (default 2048 1024 relu)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <immintrin.h>
+
+#include "gemm_kernels.h"
+
+#define HC_FUSED 128  // hidden chunk: MB x 128 floats = 512 KB at MB = 1024
+
+typedef enum { ACT_RELU, ACT_GELU } activation;
+
+// ============================================================================
+// Utilities
+// ============================================================================
+
+static inline double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void init_random(float* m, size_t size, float scale) {
+    for (size_t i = 0; i < size; i++)
+        m[i] = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * scale;
+}
+
+static float* alloc_floats(size_t n) {
+    float* p = NULL;
+    if (posix_memalign((void**)&p, 64, n * sizeof(float)) != 0) abort();
+    return p;
+}
+
+// LLC misses via perf_event_open, -1 when counters are not available
+static int llc_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void llc_start(int fd) {
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static long long llc_stop(int fd) {
+    long long count = -1;
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) return -1;
+    return count;
+}
+
+// ============================================================================
+// Activation (in place on an m x n block with leading dimension ld)
+// ============================================================================
+static void apply_activation(float* H, int m, int n, int ld, activation act) {
+    if (act == ACT_RELU) {
+        __m256 zero = _mm256_setzero_ps();
+        for (int i = 0; i < m; i++) {
+            float* h = H + (size_t)i * ld;
+            int j = 0;
+            for (; j + 8 <= n; j += 8)
+                _mm256_storeu_ps(h + j, _mm256_max_ps(_mm256_loadu_ps(h + j), zero));
+            for (; j < n; j++) h[j] = h[j] > 0.0f ? h[j] : 0.0f;
+        }
+    } else {
+        // GELU, tanh approximation
+        const float k0 = 0.7978845608f, k1 = 0.044715f;
+        for (int i = 0; i < m; i++) {
+            float* h = H + (size_t)i * ld;
+            for (int j = 0; j < n; j++) {
+                float x = h[j];
+                h[j] = 0.5f * x * (1.0f + tanhf(k0 * (x + k1 * x * x * x)));
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Unfused: two GEMMs with the full hidden matrix in DRAM
+// ============================================================================
+static void mlp_unfused(int T, int D, int H, const float* X, const float* W1,
+                        const float* W2, float* Hfull, float* Y, activation act) {
+    gemm_packed(T, H, D, X, D, W1, H, Hfull, H, 0);
+    apply_activation(Hfull, T, H, H, act);
+    gemm_packed(T, D, H, Hfull, H, W2, D, Y, D, 0);
+}
+
+// ============================================================================
+// Fused: hidden chunks stay in cache
+// ============================================================================
+// Row-block height: about D rows (see header), at most one MC block, and
+// balanced so the last block is not a sliver that re-streams all weights.
+static int fused_row_block(int T, int D) {
+    int target = D < MC_TUNED ? D : MC_TUNED;
+    if (target < 8 * MR6) target = 8 * MR6;
+    int blocks = (T + target - 1) / target;
+    return (T + blocks - 1) / blocks;
+}
+
+static void mlp_fused(int T, int D, int H, const float* X, const float* W1,
+                      const float* W2, float* Y, activation act) {
+    int MB = fused_row_block(T, D);
+    float* Hbuf = alloc_floats((size_t)MB * HC_FUSED);
+    gemm_workspace ws;
+    gemm_workspace_init(&ws);
+
+    for (int ic = 0; ic < T; ic += MB) {
+        int mb = (ic + MB <= T) ? MB : (T - ic);
+        for (int hc = 0; hc < H; hc += HC_FUSED) {
+            int hw = (hc + HC_FUSED <= H) ? HC_FUSED : (H - hc);
+            gemm_packed_ws(mb, hw, D, X + (size_t)ic * D, D, W1 + hc, H,
+                           Hbuf, HC_FUSED, 0, &ws);
+            apply_activation(Hbuf, mb, hw, HC_FUSED, act);
+            gemm_packed_ws(mb, D, hw, Hbuf, HC_FUSED, W2 + (size_t)hc * D, D,
+                           Y + (size_t)ic * D, D, hc > 0, &ws);
+        }
+    }
+    gemm_workspace_free(&ws);
+    free(Hbuf);
+}
+
+// ============================================================================
+// DRAM traffic model (compulsory bytes, no cache reuse across phases)
+// ============================================================================
+static double traffic_unfused(double T, double D, double H) {
+    // X, W1, W2 read; H written, read+written by act, read; Y written
+    return 4.0 * (T * D + D * H + H * D + 4.0 * T * H + T * D);
+}
+
+static double traffic_fused(double T, double D, double H, int MB) {
+    double blocks = ceil(T / MB);
+    return 4.0 * (T * D + blocks * (D * H + H * D) + T * D);
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+int main(int argc, char** argv) {
+    int T = (argc > 1) ? atoi(argv[1]) : 2048;
+    int D = (argc > 2) ? atoi(argv[2]) : 1024;
+    activation act = (argc > 3 && strcmp(argv[3], "gelu") == 0) ? ACT_GELU : ACT_RELU;
+    int hidden[] = {1024, 2048, 4096, 8192, 16384};
+    int n_hidden = sizeof(hidden) / sizeof(hidden[0]);
+    int MB = fused_row_block(T, D);
+
+    int llc_fd = llc_open();
+
+    printf("\n");
+    printf("╔═══════════════════════════════════════════════════════════════════════════╗\n");
+    printf("║  Fused MLP  Y = %s(X*W1)*W2   T=%-5d D=%-5d MB=%-4d HC=%-4d            ║\n",
+           act == ACT_RELU ? "relu" : "gelu", T, D, MB, HC_FUSED);
+    printf("╠═══════════════════════════════════════════════════════════════════════════╣\n");
+    printf("║     H   Variant    Time(ms)  GFLOPS   Model DRAM(MB)  LLC-miss(MB)  Err   ║\n");
+    printf("╠═══════════════════════════════════════════════════════════════════════════╣\n");
+
+    srand(42);
+    float* X = alloc_floats((size_t)T * D);
+    float* Y_ref = alloc_floats((size_t)T * D);
+    float* Y = alloc_floats((size_t)T * D);
+    init_random(X, (size_t)T * D, 1.0f);
+
+    for (int h = 0; h < n_hidden; h++) {
+        int H = hidden[h];
+        float* W1 = alloc_floats((size_t)D * H);
+        float* W2 = alloc_floats((size_t)H * D);
+        float* Hfull = alloc_floats((size_t)T * H);
+        init_random(W1, (size_t)D * H, 1.0f / sqrtf((float)D));
+        init_random(W2, (size_t)H * D, 1.0f / sqrtf((float)H));
+
+        double flops = 4.0 * T * D * H;
+
+        // Unfused (warmup + timed)
+        mlp_unfused(T, D, H, X, W1, W2, Hfull, Y_ref, act);
+        llc_start(llc_fd);
+        double t0 = get_time();
+        mlp_unfused(T, D, H, X, W1, W2, Hfull, Y_ref, act);
+        double t_unf = get_time() - t0;
+        long long miss_unf = llc_stop(llc_fd);
+
+        // Fused (warmup + timed)
+        mlp_fused(T, D, H, X, W1, W2, Y, act);
+        llc_start(llc_fd);
+        t0 = get_time();
+        mlp_fused(T, D, H, X, W1, W2, Y, act);
+        double t_fus = get_time() - t0;
+        long long miss_fus = llc_stop(llc_fd);
+
+        float max_d = 0, max_y = 0;
+        for (size_t i = 0; i < (size_t)T * D; i++) {
+            float d = fabsf(Y[i] - Y_ref[i]);
+            if (d > max_d) max_d = d;
+            if (fabsf(Y_ref[i]) > max_y) max_y = fabsf(Y_ref[i]);
+        }
+
+        char miss_u[16] = "n/a", miss_f[16] = "n/a";
+        if (miss_unf >= 0) snprintf(miss_u, sizeof(miss_u), "%.0f", miss_unf * 64 / 1e6);
+        if (miss_fus >= 0) snprintf(miss_f, sizeof(miss_f), "%.0f", miss_fus * 64 / 1e6);
+
+        printf("║ %5d   unfused  %9.1f  %6.1f   %14.0f  %12s         ║\n",
+               H, t_unf * 1e3, flops / t_unf / 1e9, traffic_unfused(T, D, H) / 1e6, miss_u);
+        printf("║         fused    %9.1f  %6.1f   %14.0f  %12s  %.0e ║\n",
+               t_fus * 1e3, flops / t_fus / 1e9, traffic_fused(T, D, H, MB) / 1e6, miss_f,
+               max_y > 0 ? max_d / max_y : max_d);
+        printf("║         speedup  %8.2fx                                                ║\n",
+               t_unf / t_fus);
+        if (h + 1 < n_hidden)
+            printf("╟───────────────────────────────────────────────────────────────────────────╢\n");
+
+        free(W1);
+        free(W2);
+        free(Hfull);
+    }
+    printf("╚═══════════════════════════════════════════════════════════════════════════╝\n");
+    if (llc_fd < 0)
+        printf("LLC-miss: perf_event_open unavailable (container/VM or perf_event_paranoid)\n");
+    else
+        close(llc_fd);
+    printf("Model DRAM: compulsory bytes; fused streams W1/W2 once per %d-row block.\n", MB);
+
+    free(X);
+    free(Y);
+    free(Y_ref);
+    return 0;
+}
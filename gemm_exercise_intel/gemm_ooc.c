@@ -0,0 +1,491 @@
+/*
+ * Out-of-Core GEMM - Intel AVX2/FMA Version
+ *
+ * C = A * B for matrices that live in files and are accessed through mmap,
+ * so M, N, K are bounded by disk space rather than RAM.
+ *
+ * Schedule (one C row-block at a time, K streamed in panels):
+ *
+ *   for each row-block ic of C (MB rows)
+ *     for each K-panel pc (KB wide)
+ *       helper thread: madvise(WILLNEED) + fault in the NEXT A/B panel
+ *       main thread:   gemm_packed_ws() on the CURRENT panel
+ *                      (Stage 5-7 packing + 6x16 kernel from gemm_kernels.h)
+ *     msync(MS_ASYNC) the finished C rows, drop them and the A rows
+ *     from our mapping
+ *
+ * Disk reads for panel p+1 overlap with FMAs on panel p. A and C are read
+ * and written exactly once; B is re-streamed once per C row-block, so
+ *
+ *   FLOPs per byte of B read = 2 * MB / 4 = MB / 2
+ *
+ * MB is derived from the memory budget (OOC_MEM_MB, default 512): the C
+ * row-block plus two A/B panel pairs (current + prefetched) must fit.
+ *
+ * File format (.mat): 4 KB header {magic "GMAT", dtype, rows, cols},
+ * then rows*cols row-major float32. The data starts on a page boundary.
+ *
+ * Build: make gemm_ooc
+ * Run:   ./gemm_ooc bench [dir] [n ...]      GFLOPS vs file size (default 1024 2048 4096)
+ *        ./gemm_ooc gen   A.mat rows cols    random matrix file
+ *        ./gemm_ooc mul   A.mat B.mat C.mat  C = A * B
+ */
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <float.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "gemm_kernels.h"
+
+#define MAT_MAGIC        0x54414d47u  // "GMAT"
+#define MAT_DTYPE_F32    0
+#define MAT_HEADER_BYTES 4096
+
+#define OOC_KB               256  // K-panel width (columns of A / rows of B)
+#define OOC_MEM_MB_DEFAULT   512
+
+// ============================================================================
+// Utilities
+// ============================================================================
+
+static size_t page_size;
+
+static inline double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void die(const char* what, const char* path) {
+    fprintf(stderr, "gemm_ooc: %s %s: %s\n", what, path, strerror(errno));
+    exit(1);
+}
+
+// Process-wide storage I/O counters (Linux /proc/self/io), -1 if unavailable
+static void read_io_counters(int64_t* read_bytes, int64_t* write_bytes) {
+    *read_bytes = *write_bytes = -1;
+    FILE* f = fopen("/proc/self/io", "r");
+    if (!f) return;
+    char key[64];
+    long long val;
+    while (fscanf(f, "%63[^:]: %lld\n", key, &val) == 2) {
+        if (strcmp(key, "read_bytes") == 0) *read_bytes = val;
+        if (strcmp(key, "write_bytes") == 0) *write_bytes = val;
+    }
+    fclose(f);
+}
+
+static void advise_range(const void* p, size_t bytes, int advice) {
+    uintptr_t start = (uintptr_t)p & ~(uintptr_t)(page_size - 1);
+    uintptr_t end = (uintptr_t)p + bytes;
+    if (bytes) madvise((void*)start, end - start, advice);
+}
+
+// Fault in every page of [p, p + bytes)
+static void touch_range(const void* p, size_t bytes) {
+    const volatile char* c = (const volatile char*)p;
+    for (size_t off = 0; off < bytes; off += page_size) (void)c[off];
+    if (bytes) (void)c[bytes - 1];
+}
+
+// ============================================================================
+// Matrix files
+// ============================================================================
+
+typedef struct {
+    uint32_t magic;
+    uint32_t dtype;
+    int64_t rows;
+    int64_t cols;
+} mat_header;
+
+typedef struct {
+    int fd;
+    int writable;
+    int64_t rows, cols;
+    size_t map_bytes;
+    char* base;
+    float* data;
+} mat_file;
+
+static size_t mat_file_bytes(int64_t rows, int64_t cols) {
+    return MAT_HEADER_BYTES + (size_t)rows * cols * sizeof(float);
+}
+
+static void mat_map(mat_file* m, const char* path) {
+    int prot = PROT_READ | (m->writable ? PROT_WRITE : 0);
+    m->base = mmap(NULL, m->map_bytes, prot, MAP_SHARED, m->fd, 0);
+    if (m->base == MAP_FAILED) die("mmap", path);
+    m->data = (float*)(m->base + MAT_HEADER_BYTES);
+}
+
+static void mat_create(mat_file* m, const char* path, int64_t rows, int64_t cols) {
+    m->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m->fd < 0) die("open", path);
+    m->writable = 1;
+    m->rows = rows;
+    m->cols = cols;
+    m->map_bytes = mat_file_bytes(rows, cols);
+    if (ftruncate(m->fd, m->map_bytes) != 0) die("ftruncate", path);
+    mat_map(m, path);
+
+    mat_header h = {MAT_MAGIC, MAT_DTYPE_F32, rows, cols};
+    memcpy(m->base, &h, sizeof(h));
+}
+
+static void mat_open(mat_file* m, const char* path, int writable) {
+    m->fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (m->fd < 0) die("open", path);
+    m->writable = writable;
+
+    mat_header h;
+    if (pread(m->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) die("read header", path);
+    if (h.magic != MAT_MAGIC || h.dtype != MAT_DTYPE_F32 || h.rows <= 0 || h.cols <= 0) {
+        fprintf(stderr, "gemm_ooc: %s: not a float32 .mat file\n", path);
+        exit(1);
+    }
+    struct stat st;
+    if (fstat(m->fd, &st) != 0) die("stat", path);
+    m->rows = h.rows;
+    m->cols = h.cols;
+    m->map_bytes = mat_file_bytes(h.rows, h.cols);
+    if ((size_t)st.st_size < m->map_bytes) {
+        fprintf(stderr, "gemm_ooc: %s: truncated file\n", path);
+        exit(1);
+    }
+    mat_map(m, path);
+}
+
+static void mat_close(mat_file* m) {
+    if (m->writable) msync(m->base, m->map_bytes, MS_SYNC);
+    munmap(m->base, m->map_bytes);
+    close(m->fd);
+}
+
+// Flush to disk and evict from the page cache, so the next run reads from disk
+static void mat_drop_cache(const mat_file* m) {
+    if (m->writable) msync(m->base, m->map_bytes, MS_SYNC);
+    fsync(m->fd);
+    madvise(m->base, m->map_bytes, MADV_DONTNEED);
+    posix_fadvise(m->fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+// Fill with uniform [-1, 1) values, streaming so files larger than RAM work
+static void mat_fill_random(mat_file* m, uint64_t seed) {
+    assert(m->rows > 0 && m->cols > 0);
+    uint64_t s = seed * 0x9E3779B97F4A7C15ull + 1;
+    int64_t rows_per_chunk = (64 << 20) / (m->cols * sizeof(float)) + 1;
+
+    for (int64_t r0 = 0; r0 < m->rows; r0 += rows_per_chunk) {
+        int64_t r1 = (r0 + rows_per_chunk < m->rows) ? r0 + rows_per_chunk : m->rows;
+        float* p = m->data + r0 * m->cols;
+        size_t count = (size_t)(r1 - r0) * m->cols;
+        for (size_t i = 0; i < count; i++) {
+            s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+            p[i] = (float)(s >> 40) * (2.0f / 16777216.0f) - 1.0f;
+        }
+        msync((void*)((uintptr_t)p & ~(uintptr_t)(page_size - 1)),
+              count * sizeof(float) + ((uintptr_t)p & (page_size - 1)), MS_ASYNC);
+        advise_range(p, count * sizeof(float), MADV_DONTNEED);
+    }
+}
+
+// ============================================================================
+// Panel prefetch
+// ============================================================================
+
+typedef struct {
+    const mat_file* A;
+    const mat_file* B;
+    int64_t ic, mb;  // rows of A / C
+    int64_t pc, kb;  // columns of A / rows of B
+} panel;
+
+static void panel_prefetch(const panel* p) {
+    int64_t K = p->A->cols, N = p->B->cols;
+
+    // B panel is contiguous: one readahead request, then fault it in
+    const float* b = p->B->data + p->pc * N;
+    size_t b_bytes = (size_t)p->kb * N * sizeof(float);
+    advise_range(b, b_bytes, MADV_WILLNEED);
+
+    // A panel is mb row fragments of kb floats each
+    for (int64_t i = 0; i < p->mb; i++)
+        touch_range(p->A->data + (p->ic + i) * K + p->pc, p->kb * sizeof(float));
+
+    touch_range(b, b_bytes);
+}
+
+static void* prefetch_main(void* arg) {
+    panel_prefetch((const panel*)arg);
+    return NULL;
+}
+
+// ============================================================================
+// Out-of-core driver
+// ============================================================================
+
+typedef struct {
+    double seconds;
+    int64_t mb, kb;
+    int64_t read_bytes, write_bytes;
+} ooc_stats;
+
+static void gemm_ooc(const mat_file* A, const mat_file* B, mat_file* C,
+                     size_t mem_bytes, ooc_stats* st) {
+    int64_t M = A->rows, K = A->cols, N = B->cols;
+    if (K > INT_MAX || N > INT_MAX) {
+        fprintf(stderr, "gemm_ooc: K and N must fit in an int\n");
+        exit(1);
+    }
+
+    // C row-block (mb x N) + 2 x (A panel mb x kb + B panel kb x N) <= budget
+    int64_t kb = (K < OOC_KB) ? K : OOC_KB;
+    int64_t b_panels = 2 * kb * N * (int64_t)sizeof(float);
+    int64_t mb = ((int64_t)mem_bytes > b_panels)
+                     ? ((int64_t)mem_bytes - b_panels) / ((N + 2 * kb) * (int64_t)sizeof(float))
+                     : MR6;
+    mb = mb / MR6 * MR6;
+    if (mb > INT_MAX / K) mb = INT_MAX / K / MR6 * MR6;  // gemm_packed_ws indexes rows as int
+    if (mb < MR6) mb = MR6;
+    if (mb > M) mb = M;
+
+    int64_t n_row_blocks = (M + mb - 1) / mb;
+    int64_t n_k_panels = (K + kb - 1) / kb;
+    int64_t n_panels = n_row_blocks * n_k_panels;
+
+    gemm_workspace ws;
+    gemm_workspace_init(&ws);
+
+    int64_t rd0, wr0;
+    read_io_counters(&rd0, &wr0);
+    double t0 = get_time();
+
+    panel cur, next;
+    for (int64_t t = 0; t < n_panels; t++) {
+        int64_t ic = (t / n_k_panels) * mb, pc = (t % n_k_panels) * kb;
+        cur = (panel){A, B, ic, (ic + mb <= M) ? mb : M - ic, pc, (pc + kb <= K) ? kb : K - pc};
+        if (t == 0) panel_prefetch(&cur);
+
+        // Start faulting in panel t+1 while we compute panel t
+        pthread_t tid;
+        int have_next = (t + 1 < n_panels);
+        if (have_next) {
+            int64_t nic = ((t + 1) / n_k_panels) * mb, npc = ((t + 1) % n_k_panels) * kb;
+            next = (panel){A, B, nic, (nic + mb <= M) ? mb : M - nic, npc, (npc + kb <= K) ? kb : K - npc};
+            if (pthread_create(&tid, NULL, prefetch_main, &next) != 0) have_next = 0;
+        }
+
+        gemm_packed_ws((int)cur.mb, (int)N, (int)cur.kb,
+                       A->data + cur.ic * K + cur.pc, (int)K,
+                       B->data + cur.pc * N, (int)N,
+                       C->data + cur.ic * N, (int)N,
+                       cur.pc > 0, &ws);
+
+        if (have_next) pthread_join(tid, NULL);
+
+        // Row-block finished: write C tile back, release A and C pages
+        if (cur.pc + cur.kb >= K) {
+            float* c_rows = C->data + cur.ic * N;
+            size_t c_bytes = (size_t)cur.mb * N * sizeof(float);
+            uintptr_t c_start = (uintptr_t)c_rows & ~(uintptr_t)(page_size - 1);
+            msync((void*)c_start, (uintptr_t)c_rows + c_bytes - c_start, MS_ASYNC);
+            advise_range(c_rows, c_bytes, MADV_DONTNEED);
+            advise_range(A->data + cur.ic * K, (size_t)cur.mb * K * sizeof(float), MADV_DONTNEED);
+        }
+    }
+    msync(C->base, C->map_bytes, MS_SYNC);
+
+    st->seconds = get_time() - t0;
+    st->mb = mb;
+    st->kb = kb;
+    int64_t rd1, wr1;
+    read_io_counters(&rd1, &wr1);
+    st->read_bytes = (rd0 >= 0 && rd1 >= 0) ? rd1 - rd0 : -1;
+    st->write_bytes = (wr0 >= 0 && wr1 >= 0) ? wr1 - wr0 : -1;
+
+    gemm_workspace_free(&ws);
+}
+
+// Spot-check random entries of C against a double-precision dot product
+static int verify_samples(const mat_file* A, const mat_file* B, const mat_file* C, int samples) {
+    int64_t M = A->rows, K = A->cols, N = B->cols;
+    uint64_t s = 12345;
+    int ok = 1;
+    for (int t = 0; t < samples; t++) {
+        s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+        int64_t i = (int64_t)(s % (uint64_t)M);
+        int64_t j = (int64_t)((s >> 32) % (uint64_t)N);
+        double ref = 0, mag = 0;
+        for (int64_t k = 0; k < K; k++) {
+            double p = (double)A->data[i * K + k] * B->data[k * N + j];
+            ref += p;
+            mag += fabs(p);
+        }
+        double err = fabs(C->data[i * N + j] - ref);
+        if (err > K * FLT_EPSILON * mag + 1e-6) {
+            fprintf(stderr, "gemm_ooc: C[%lld][%lld] = %g, expected %g\n",
+                    (long long)i, (long long)j, C->data[i * N + j], ref);
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+static size_t mem_budget(void) {
+    const char* env = getenv("OOC_MEM_MB");
+    long mb = env ? atol(env) : OOC_MEM_MB_DEFAULT;
+    if (mb <= 0) mb = OOC_MEM_MB_DEFAULT;
+    return (size_t)mb << 20;
+}
+
+// ============================================================================
+// Commands
+// ============================================================================
+
+static int cmd_gen(const char* path, int64_t rows, int64_t cols) {
+    mat_file m;
+    mat_create(&m, path, rows, cols);
+    mat_fill_random(&m, (uint64_t)rows * 31 + cols);
+    mat_close(&m);
+    printf("%s: %lld x %lld (%.1f MB)\n", path, (long long)rows, (long long)cols,
+           mat_file_bytes(rows, cols) / 1e6);
+    return 0;
+}
+
+static int cmd_mul(const char* pa, const char* pb, const char* pcc) {
+    mat_file A, B, C;
+    mat_open(&A, pa, 0);
+    mat_open(&B, pb, 0);
+    if (A.cols != B.rows) {
+        fprintf(stderr, "gemm_ooc: shape mismatch (%lld x %lld) * (%lld x %lld)\n",
+                (long long)A.rows, (long long)A.cols, (long long)B.rows, (long long)B.cols);
+        return 1;
+    }
+    mat_create(&C, pcc, A.rows, B.cols);
+
+    ooc_stats st;
+    gemm_ooc(&A, &B, &C, mem_budget(), &st);
+    double flops = 2.0 * A.rows * A.cols * B.cols;
+    printf("C[%lld x %lld] = A[%lld x %lld] * B[%lld x %lld]\n",
+           (long long)A.rows, (long long)B.cols, (long long)A.rows, (long long)A.cols,
+           (long long)B.rows, (long long)B.cols);
+    printf("  MB=%lld KB=%lld  time %.2f s  %.1f GFLOPS  disk read %.1f MB  write %.1f MB\n",
+           (long long)st.mb, (long long)st.kb, st.seconds, flops / st.seconds / 1e9,
+           st.read_bytes / 1e6, st.write_bytes / 1e6);
+
+    int ok = verify_samples(&A, &B, &C, 16);
+    mat_close(&A);
+    mat_close(&B);
+    mat_close(&C);
+    return ok ? 0 : 1;
+}
+
+static int cmd_bench(const char* dir, const int64_t* sizes, int n_sizes) {
+    size_t budget = mem_budget();
+
+    printf("\n");
+    printf("╔══════════════════════════════════════════════════════════════════════╗\n");
+    printf("║     Out-of-Core GEMM (mmap, cold page cache, budget %5zu MB)         ║\n", budget >> 20);
+    printf("╠══════════════════════════════════════════════════════════════════════╣\n");
+    printf("║     N    Files(MB)   MB/KB      Time(s)   GFLOPS   Read(MB)   Check  ║\n");
+    printf("╠══════════════════════════════════════════════════════════════════════╣\n");
+
+    int all_ok = 1;
+    for (int s = 0; s < n_sizes; s++) {
+        int64_t n = sizes[s];
+        char pa[4096], pb[4096], pcc[4096];
+        snprintf(pa, sizeof(pa), "%s/ooc_A_%lld.mat", dir, (long long)n);
+        snprintf(pb, sizeof(pb), "%s/ooc_B_%lld.mat", dir, (long long)n);
+        snprintf(pcc, sizeof(pcc), "%s/ooc_C_%lld.mat", dir, (long long)n);
+
+        mat_file A, B, C;
+        mat_create(&A, pa, n, n);
+        mat_fill_random(&A, 1);
+        mat_create(&B, pb, n, n);
+        mat_fill_random(&B, 2);
+        mat_create(&C, pcc, n, n);
+        mat_drop_cache(&A);
+        mat_drop_cache(&B);
+        mat_drop_cache(&C);
+
+        ooc_stats st;
+        gemm_ooc(&A, &B, &C, budget, &st);
+        int ok = verify_samples(&A, &B, &C, 16);
+        all_ok &= ok;
+
+        double files_mb = 3.0 * mat_file_bytes(n, n) / 1e6;
+        double gflops = 2.0 * n * n * n / st.seconds / 1e9;
+        printf("║ %6lld   %9.1f   %5lld/%-4lld %8.2f   %6.1f   %8.1f   %5s  ║\n",
+               (long long)n, files_mb, (long long)st.mb, (long long)st.kb,
+               st.seconds, gflops, st.read_bytes / 1e6, ok ? "ok" : "FAIL");
+
+        mat_close(&A);
+        mat_close(&B);
+        mat_close(&C);
+        unlink(pa);
+        unlink(pb);
+        unlink(pcc);
+    }
+
+    printf("╚══════════════════════════════════════════════════════════════════════╝\n");
+    printf("Read(MB) is from /proc/self/io (-0.0 if unavailable). B is re-read once\n");
+    printf("per C row-block, so raise OOC_MEM_MB to trade RAM for disk traffic.\n");
+    return all_ok ? 0 : 1;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: gemm_ooc bench [dir] [n ...]\n"
+            "       gemm_ooc gen A.mat rows cols\n"
+            "       gemm_ooc mul A.mat B.mat C.mat\n"
+            "env:   OOC_MEM_MB  resident panel budget (default %d)\n",
+            OOC_MEM_MB_DEFAULT);
+}
+
+int main(int argc, char** argv) {
+    page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    if (argc >= 2 && strcmp(argv[1], "gen") == 0 && argc == 5) {
+        int64_t rows = atoll(argv[3]), cols = atoll(argv[4]);
+        if (rows > 0 && cols > 0) return cmd_gen(argv[2], rows, cols);
+        fprintf(stderr, "gen: rows and cols must be positive\n");
+        usage();
+        return 1;
+    }
+    if (argc >= 2 && strcmp(argv[1], "mul") == 0 && argc == 5)
+        return cmd_mul(argv[2], argv[3], argv[4]);
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        const char* dir = (argc >= 3) ? argv[2] : ".";
+        int64_t sizes[32] = {1024, 2048, 4096};
+        int n_sizes = 3;
+        if (argc >= 4) {
+            n_sizes = 0;
+            for (int i = 3; i < argc && n_sizes < 32; i++) {
+                int64_t n = atoll(argv[i]);
+                if (n <= 0) {
+                    fprintf(stderr, "bench: sizes must be positive, got '%s'\n", argv[i]);
+                    usage();
+                    return 1;
+                }
+                sizes[n_sizes++] = n;
+            }
+        }
+        return cmd_bench(dir, sizes, n_sizes);
+    }
+    usage();
+    return 1;
+}
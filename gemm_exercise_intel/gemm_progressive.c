@@ -11,8 +11,11 @@
  *   6. Tuned:    + Optimal blocking parameters (~165 GFLOPS)
  *   7. Lazy:     + Just-in-time A packing (~168 GFLOPS, beats OpenBLAS!)
  *
- * Build: gcc -O3 -march=native -mavx2 -mfma -o gemm_progressive gemm_progressive.c -lopenblas -lm
+ * Build: gcc -O3 -march=native -mavx2 -mfma -I../cpu/lecture10_roofline/examples \
+ *            -o gemm_progressive gemm_progressive.c -lopenblas -lm
  * Run:   OPENBLAS_NUM_THREADS=1 ./gemm_progressive
+ *        OPENBLAS_NUM_THREADS=1 ./gemm_progressive csv   (roofline CSV rows, see
+ *        cpu/lecture10_roofline/examples/roofline.cpp)
  */
 
 #include <stdio.h>
@@ -23,6 +26,9 @@
 #include <immintrin.h>
 #include <cblas.h>
 
+#include "gemm_kernels.h"  // 6x16/4x16 kernels, AVX2 packing engine, general driver
+#include "machine_profile.h"  // measured peak (cpu/lecture10_roofline/examples)
+
 // Matrix size
 #define N 1024
 
@@ -47,19 +53,14 @@
  */
 #define MR8 8
 #define NR8 8
-#define MR4 4
-#define MR6 6
-#define NR16 16
+// MR4, MR6 and NR16 are defined in gemm_kernels.h
 
 // Default blocking parameters (used for stages 2-5)
 #define MC_DEFAULT 512
 #define KC_DEFAULT 64
 #define NC_DEFAULT 512
 
-// Tuned blocking parameters
-#define MC_TUNED 1024
-#define KC_TUNED 64
-#define NC_TUNED 1024
+// Tuned blocking parameters (MC_TUNED, KC_TUNED, NC_TUNED) are in gemm_kernels.h
 
 // ============================================================================
 // Utilities
@@ -426,107 +427,10 @@ static void gemm_pack_b(const float* A, const float* B, float* C, int n) {
  * └─────────────────────────────────────────────────────────────────────────┘
  */
 
-// 6x16 micro-kernel (12 YMM for C, optimal FLOPs/load)
-static inline void pack_A_slice_6(const float* A, float* dst, int row, int pc, int lda, int KC) {
-    for (int k = 0; k < KC; k++) {
-        dst[k * MR6 + 0] = A[(row + 0) * lda + pc + k];
-        dst[k * MR6 + 1] = A[(row + 1) * lda + pc + k];
-        dst[k * MR6 + 2] = A[(row + 2) * lda + pc + k];
-        dst[k * MR6 + 3] = A[(row + 3) * lda + pc + k];
-        dst[k * MR6 + 4] = A[(row + 4) * lda + pc + k];
-        dst[k * MR6 + 5] = A[(row + 5) * lda + pc + k];
-    }
-}
-
-static inline void microkernel_6x16(const float* A_packed, const float* B_packed,
-                                     float* C, int ldc, int KC, int first_k) {
-    __m256 c00, c01, c10, c11, c20, c21, c30, c31, c40, c41, c50, c51;
-
-    if (first_k) {
-        c00 = c01 = c10 = c11 = c20 = c21 = _mm256_setzero_ps();
-        c30 = c31 = c40 = c41 = c50 = c51 = _mm256_setzero_ps();
-    } else {
-        c00 = _mm256_loadu_ps(C + 0 * ldc + 0); c01 = _mm256_loadu_ps(C + 0 * ldc + 8);
-        c10 = _mm256_loadu_ps(C + 1 * ldc + 0); c11 = _mm256_loadu_ps(C + 1 * ldc + 8);
-        c20 = _mm256_loadu_ps(C + 2 * ldc + 0); c21 = _mm256_loadu_ps(C + 2 * ldc + 8);
-        c30 = _mm256_loadu_ps(C + 3 * ldc + 0); c31 = _mm256_loadu_ps(C + 3 * ldc + 8);
-        c40 = _mm256_loadu_ps(C + 4 * ldc + 0); c41 = _mm256_loadu_ps(C + 4 * ldc + 8);
-        c50 = _mm256_loadu_ps(C + 5 * ldc + 0); c51 = _mm256_loadu_ps(C + 5 * ldc + 8);
-    }
-
-    for (int k = 0; k < KC; k++) {
-        __m256 b0 = _mm256_loadu_ps(B_packed + k * NR16 + 0);
-        __m256 b1 = _mm256_loadu_ps(B_packed + k * NR16 + 8);
-        __m256 a;
-        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 0]);
-        c00 = _mm256_fmadd_ps(a, b0, c00); c01 = _mm256_fmadd_ps(a, b1, c01);
-        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 1]);
-        c10 = _mm256_fmadd_ps(a, b0, c10); c11 = _mm256_fmadd_ps(a, b1, c11);
-        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 2]);
-        c20 = _mm256_fmadd_ps(a, b0, c20); c21 = _mm256_fmadd_ps(a, b1, c21);
-        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 3]);
-        c30 = _mm256_fmadd_ps(a, b0, c30); c31 = _mm256_fmadd_ps(a, b1, c31);
-        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 4]);
-        c40 = _mm256_fmadd_ps(a, b0, c40); c41 = _mm256_fmadd_ps(a, b1, c41);
-        a = _mm256_broadcast_ss(&A_packed[k * MR6 + 5]);
-        c50 = _mm256_fmadd_ps(a, b0, c50); c51 = _mm256_fmadd_ps(a, b1, c51);
-    }
-
-    _mm256_storeu_ps(C + 0 * ldc + 0, c00); _mm256_storeu_ps(C + 0 * ldc + 8, c01);
-    _mm256_storeu_ps(C + 1 * ldc + 0, c10); _mm256_storeu_ps(C + 1 * ldc + 8, c11);
-    _mm256_storeu_ps(C + 2 * ldc + 0, c20); _mm256_storeu_ps(C + 2 * ldc + 8, c21);
-    _mm256_storeu_ps(C + 3 * ldc + 0, c30); _mm256_storeu_ps(C + 3 * ldc + 8, c31);
-    _mm256_storeu_ps(C + 4 * ldc + 0, c40); _mm256_storeu_ps(C + 4 * ldc + 8, c41);
-    _mm256_storeu_ps(C + 5 * ldc + 0, c50); _mm256_storeu_ps(C + 5 * ldc + 8, c51);
-}
-
-// 4x16 micro-kernel (8 YMM for C, used for edge cases)
-static inline void pack_A_slice_4(const float* A, float* dst, int row, int pc, int lda, int KC) {
-    const float* src = A + row * lda + pc;
-    for (int k = 0; k < KC; k += 4) {
-        __m128 r0 = _mm_loadu_ps(src + 0 * lda + k);
-        __m128 r1 = _mm_loadu_ps(src + 1 * lda + k);
-        __m128 r2 = _mm_loadu_ps(src + 2 * lda + k);
-        __m128 r3 = _mm_loadu_ps(src + 3 * lda + k);
-        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
-        _mm_storeu_ps(dst + k * MR4 + 0, r0);
-        _mm_storeu_ps(dst + k * MR4 + 4, r1);
-        _mm_storeu_ps(dst + k * MR4 + 8, r2);
-        _mm_storeu_ps(dst + k * MR4 + 12, r3);
-    }
-}
-
-static inline void microkernel_4x16(const float* A_packed, const float* B_packed,
-                                     float* C, int ldc, int KC, int first_k) {
-    __m256 c00, c01, c10, c11, c20, c21, c30, c31;
-
-    if (first_k) {
-        c00 = c01 = c10 = c11 = c20 = c21 = c30 = c31 = _mm256_setzero_ps();
-    } else {
-        c00 = _mm256_loadu_ps(C + 0 * ldc + 0); c01 = _mm256_loadu_ps(C + 0 * ldc + 8);
-        c10 = _mm256_loadu_ps(C + 1 * ldc + 0); c11 = _mm256_loadu_ps(C + 1 * ldc + 8);
-        c20 = _mm256_loadu_ps(C + 2 * ldc + 0); c21 = _mm256_loadu_ps(C + 2 * ldc + 8);
-        c30 = _mm256_loadu_ps(C + 3 * ldc + 0); c31 = _mm256_loadu_ps(C + 3 * ldc + 8);
-    }
-
-    for (int k = 0; k < KC; k++) {
-        __m256 b0 = _mm256_loadu_ps(B_packed + k * NR16 + 0);
-        __m256 b1 = _mm256_loadu_ps(B_packed + k * NR16 + 8);
-        __m256 a0 = _mm256_broadcast_ss(&A_packed[k * MR4 + 0]);
-        __m256 a1 = _mm256_broadcast_ss(&A_packed[k * MR4 + 1]);
-        __m256 a2 = _mm256_broadcast_ss(&A_packed[k * MR4 + 2]);
-        __m256 a3 = _mm256_broadcast_ss(&A_packed[k * MR4 + 3]);
-        c00 = _mm256_fmadd_ps(a0, b0, c00); c01 = _mm256_fmadd_ps(a0, b1, c01);
-        c10 = _mm256_fmadd_ps(a1, b0, c10); c11 = _mm256_fmadd_ps(a1, b1, c11);
-        c20 = _mm256_fmadd_ps(a2, b0, c20); c21 = _mm256_fmadd_ps(a2, b1, c21);
-        c30 = _mm256_fmadd_ps(a3, b0, c30); c31 = _mm256_fmadd_ps(a3, b1, c31);
-    }
-
-    _mm256_storeu_ps(C + 0 * ldc + 0, c00); _mm256_storeu_ps(C + 0 * ldc + 8, c01);
-    _mm256_storeu_ps(C + 1 * ldc + 0, c10); _mm256_storeu_ps(C + 1 * ldc + 8, c11);
-    _mm256_storeu_ps(C + 2 * ldc + 0, c20); _mm256_storeu_ps(C + 2 * ldc + 8, c21);
-    _mm256_storeu_ps(C + 3 * ldc + 0, c30); _mm256_storeu_ps(C + 3 * ldc + 8, c31);
-}
+// pack_A_slice_6 / microkernel_6x16 and pack_A_slice_4 / microkernel_4x16
+// live in gemm_kernels.h so the other drivers in this directory can reuse them.
+// Both pack_A_slice_* are thin wrappers over the AVX2 8x8-transpose packing
+// engine there (see pack_bench.c for packing GB/s against memcpy).
 
 // Stage 5 uses the hybrid kernel with default blocking (to isolate kernel effect)
 static void gemm_kernel(const float* A, const float* B, float* C, int n) {
@@ -743,15 +647,36 @@ static void gemm_reference(const float* A, const float* B, float* C, int n) {
 // ============================================================================
 typedef void (*gemm_func)(const float*, const float*, float*, int);
 
-int main(void) {
-    double peak_gflops = 179.0;  // i7-14700KF @ 5.6GHz, AVX2+FMA
+/*
+ * DRAM traffic model for the roofline CSV (no counters needed):
+ *   naive: every C(i,j) streams a row of A and a column of B
+ *   blocked (jc/pc/ic order): B read once, A once per NC panel,
+ *   C read+written once per KC pass
+ * kc == 0 selects the naive model.
+ */
+static double dram_bytes(int n, int kc, int nc) {
+    double n2 = (double)n * n;
+    if (kc == 0) return sizeof(float) * (2.0 * n2 * n + 2 * n2);
+    return sizeof(float) * (n2 + n2 * n / nc + 2 * n2 * n / kc);
+}
 
-    printf("\n");
-    printf("╔══════════════════════════════════════════════════════════════════╗\n");
-    printf("║      GEMM Progressive Optimization - Intel AVX2/FMA (N=%d)     ║\n", N);
-    printf("╠══════════════════════════════════════════════════════════════════╣\n");
-    printf("║ Stage  Implementation          GFLOPS    %%Peak    vs OpenBLAS  ║\n");
-    printf("╠══════════════════════════════════════════════════════════════════╣\n");
+int main(int argc, char** argv) {
+    int csv = argc > 1 && strcmp(argv[1], "csv") == 0;
+
+    // Measured single-core FMA peak from `make profile`; the datasheet number
+    // (i7-14700KF @ 5.6GHz, AVX2+FMA) is only a fallback
+    machine_profile mp;
+    int measured = machine_profile_load(&mp);
+    double peak_gflops = measured ? mp.peak_sp_1core : 179.0;
+
+    if (!csv) {
+        printf("\n");
+        printf("╔══════════════════════════════════════════════════════════════════╗\n");
+        printf("║      GEMM Progressive Optimization - Intel AVX2/FMA (N=%d)     ║\n", N);
+        printf("╠══════════════════════════════════════════════════════════════════╣\n");
+        printf("║ Stage  Implementation          GFLOPS    %%Peak    vs OpenBLAS  ║\n");
+        printf("╠══════════════════════════════════════════════════════════════════╣\n");
+    }
 
     float *A = NULL, *B = NULL, *C = NULL, *C_ref = NULL;
     if (posix_memalign((void**)&A, 64, N * N * sizeof(float)) != 0) abort();
@@ -768,15 +693,16 @@ int main(void) {
     // Reference
     gemm_reference(A, B, C_ref, N);
 
-    struct { const char* name; gemm_func func; int runs; } tests[] = {
-        {"OpenBLAS (ref)",    gemm_reference, 20},
-        {"1. Naive",          gemm_naive,     1},
-        {"2. Blocked",        gemm_blocked,   3},
-        {"3. Pack A (8x8)",   gemm_pack_a,    10},
-        {"4. Pack B (8x8)",   gemm_pack_b,    15},
-        {"5. Kernel (6x16+4x16)", gemm_kernel, 15},
-        {"6. Tuned",          gemm_tuned,     20},
-        {"7. Lazy",           gemm_lazy,      20},
+    // id, kc, nc: CSV kernel name and the blocking its traffic model uses
+    struct { const char* name; gemm_func func; int runs; const char* id; int kc, nc; } tests[] = {
+        {"OpenBLAS (ref)",    gemm_reference, 20, "gemm_openblas", KC_TUNED,   NC_TUNED},
+        {"1. Naive",          gemm_naive,     1,  "gemm_1_naive",   0,          0},
+        {"2. Blocked",        gemm_blocked,   3,  "gemm_2_blocked", KC_DEFAULT, NC_DEFAULT},
+        {"3. Pack A (8x8)",   gemm_pack_a,    10, "gemm_3_pack_a",  KC_DEFAULT, NC_DEFAULT},
+        {"4. Pack B (8x8)",   gemm_pack_b,    15, "gemm_4_pack_b",  KC_DEFAULT, NC_DEFAULT},
+        {"5. Kernel (6x16+4x16)", gemm_kernel, 15, "gemm_5_kernel", KC_DEFAULT, NC_DEFAULT},
+        {"6. Tuned",          gemm_tuned,     20, "gemm_6_tuned",   KC_TUNED,   NC_TUNED},
+        {"7. Lazy",           gemm_lazy,      20, "gemm_7_lazy",    KC_TUNED,   NC_TUNED},
     };
     int n_tests = sizeof(tests) / sizeof(tests[0]);
 
@@ -790,7 +716,8 @@ int main(void) {
         // Verify
         float err = max_diff(C, C_ref, N * N);
         if (err > 1e-3) {
-            printf("║ WARNING: %s error %.2e                            ║\n", tests[t].name, err);
+            fprintf(csv ? stderr : stdout,
+                    "║ WARNING: %s error %.2e                            ║\n", tests[t].name, err);
         }
 
         // Benchmark
@@ -802,6 +729,11 @@ int main(void) {
         double gflops = flops / elapsed / 1e9;
         double pct = gflops / peak_gflops * 100;
 
+        if (csv) {
+            machine_profile_csv_row(stdout, &mp, tests[t].id, 0, N, 3.0 * N * N * sizeof(float), flops,
+                                    dram_bytes(N, tests[t].kc, tests[t].nc), elapsed, "model");
+            continue;
+        }
         if (t == 0) {
             ref_gflops = gflops;
             printf("║   -   %-24s %6.1f    %5.1f%%    (baseline)    ║\n", tests[t].name, gflops, pct);
@@ -811,8 +743,19 @@ int main(void) {
         }
     }
 
+    if (csv) {
+        free(A);
+        free(B);
+        free(C);
+        free(C_ref);
+        return 0;
+    }
+
     printf("╠══════════════════════════════════════════════════════════════════╣\n");
-    printf("║ Theoretical peak: %.0f GFLOPS (single core, AVX2+FMA @ 5.6GHz)   ║\n", peak_gflops);
+    if (measured)
+        printf("║ Measured peak: %5.1f GFLOPS (single core, AVX2+FMA)              ║\n", peak_gflops);
+    else
+        printf("║ Theoretical peak: %.0f GFLOPS (single core, AVX2+FMA @ 5.6GHz)   ║\n", peak_gflops);
     printf("╚══════════════════════════════════════════════════════════════════╝\n");
 
     printf("\nKey Insights:\n");